@@ -849,7 +849,7 @@ static int file_binlog_read_lev_rotate_to (file_t *F) {
 static void file_relax_crc32 (file_t *F, void *p, int l) {
   assert (!quick_test);
   assert (!(l & 3));
-  F->log_crc32 = ~crc32_partial (p, l, ~F->log_crc32);
+  F->log_crc32 = ~crc32_partial_parallel (p, l, ~F->log_crc32);
   F->crc32_off += l;
 }
 
@@ -34,6 +34,11 @@
 #include <sys/types.h>
 #include <aio.h>
 #include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
 
 #include "crc32.h"
 #include "md5.h"
@@ -42,6 +47,7 @@
 #include "kfs-layout.h"
 #include "kfs.h"
 #include "server-functions.h"
+#include "net-events.h"
 
 #define MAX_LOG_TS_INTERVAL	100
 
@@ -186,6 +192,13 @@ static int load_binlog_headers (int fd) {
     E = (struct lev_start *) ((kfs_binlog_zip_header_t *) E)->first36_bytes;
     r = 36;
     goto loop;
+  case KFS_BINLOG_ZS_MAGIC:
+    assert (!binlog_headers && binlog_zipped);
+    assert (r >= sizeof (kfs_binlog_zs_header_t));
+    assert (E == (struct lev_start *) (kfs_Hdr + binlog_headers));
+    E = (struct lev_start *) ((kfs_binlog_zs_header_t *) E)->first36_bytes;
+    r = 36;
+    goto loop;
   default:
     fprintf (stderr, "fatal: binlog file begins with wrong entry type %08x\n", E->type);
     return -1;
@@ -270,11 +283,43 @@ static int load_binlog_headers (int fd) {
 }
 
 
+/* same as calc_binlog_hash, but data is decoded from streaming zipped binlog */
+static hash_t calc_zs_binlog_hash (long long expected_size) {
+  static unsigned char buffer[32768];
+  int totsize = expected_size >= 32768 ? 32768 : (int) expected_size;
+  int r = totsize < 16384 ? totsize : 16384;
+  if (kfs_bz_decode (Binlog, 0, buffer, &r, NULL) < 0 || r != (totsize < 16384 ? totsize : 16384)) {
+    fprintf (stderr, "fatal: cannot decode head of binlog %s\n", binlogname);
+    exit (1);
+  }
+  if (totsize > 16384) {
+    r = totsize - 16384;
+    if (kfs_bz_decode (Binlog, expected_size - r, buffer + 16384, &r, NULL) < 0 || r != totsize - 16384) {
+      fprintf (stderr, "fatal: cannot decode tail of binlog %s\n", binlogname);
+      exit (1);
+    }
+  }
+  assert (*(int *) buffer == LEV_START);
+
+  *(hash_t *)(buffer + totsize - 16) = 0;
+  *(hash_t *)(buffer + totsize - 8) = 0;
+
+  static unsigned char md[16];
+  md5 (buffer, totsize, md);
+  return *(hash_t *)md;
+}
+
 hash_t calc_binlog_hash (int rhandle, long long expected_size, const char *logbuf, int bufsize, int overlap) {
   if (binlog_zipped) {
     if (cur_binlog_file_hash) {
       return cur_binlog_file_hash;
     }
+    if (Binlog->info->zs) {
+      if (Binlog->info->zs->file_hash) {
+        return cur_binlog_file_hash = Binlog->info->zs->file_hash;
+      }
+      return cur_binlog_file_hash = calc_zs_binlog_hash (expected_size);
+    }
     kfs_binlog_zip_header_t *H = (kfs_binlog_zip_header_t *) Binlog->info->start;
     assert (*(int *) H->first36_bytes == LEV_START);
     return cur_binlog_file_hash = H->file_hash;
@@ -720,6 +765,11 @@ int set_schema (int schema) {
   return res;
 }
 
+/* crc32 complement of binlog up to prefetch_crc32_pos, computed by prefetch thread */
+static long long prefetch_crc32_pos = -1;
+static unsigned prefetch_crc32_complement;
+long long binlog_prefetch_crc32_hits;
+
 /* computes log_crc32_complement up to new log_crc32_pos, equal to log_cur_pos() + s
    in most cases, s = 0
 */
@@ -741,6 +791,12 @@ void relax_log_crc32 (int s) {
     }
     assert (tot_crc32 == ~log_crc32_complement);
   }
+  if (new_log_crc32_pos == prefetch_crc32_pos && log_crc32_pos < new_log_crc32_pos && log_crc32_pos >= tot_crc32_pos) {
+    log_crc32_complement = prefetch_crc32_complement;
+    log_crc32_pos = new_log_crc32_pos;
+    binlog_prefetch_crc32_hits++;
+    return;
+  }
   log_crc32_complement = crc32_partial (R.log_wptr - (log_pos - log_crc32_pos), new_log_crc32_pos - log_crc32_pos, log_crc32_complement);
   log_crc32_pos = new_log_crc32_pos;
 }
@@ -812,7 +868,8 @@ int force_new_binlog (void) {
 */
 
   if (!binlog_cyclic_mode) {
-    flush_binlog_forced (0);
+    /* with group commit, events of the old file must be durable before callbacks are invoked */
+    flush_binlog_forced (binlog_group_commit);
   } else {
     flush_cbinlog (1);
   }
@@ -1100,6 +1157,236 @@ int default_replay_logevent (struct lev_generic *E, int size) {
   return -1;
 }
 
+/*
+ *	binlog prefetch for replicas: a background thread tails the binlog file,
+ *	reads new bytes into a single-producer single-consumer ring and computes their crc32;
+ *	replay_log () called from read_new_events () only copies ready bytes from the ring
+ */
+
+#define	PREFETCH_RING_SIZE	(1 << 22)
+#define	PREFETCH_READ_SIZE	(1 << 20)
+#define	PREFETCH_SEGMENTS	256
+#define	PREFETCH_IDLE_TIMEOUT	100
+
+int binlog_prefetch;
+long long binlog_prefetch_bytes, binlog_prefetch_reads;
+
+/* programs without event loop aren't linked with net-events */
+#pragma weak epoll_sethandler
+#pragma weak epoll_insert
+
+static struct binlog_prefetcher {
+  pthread_t thread;
+  int fd, inotify_fd, wakeup_fd, event_fd;
+  volatile int stop, error;
+  int running, crc32_valid;
+  long long file_offset;	// file offset minus log position
+  unsigned crc32_complement;	// at start position
+  char *buf;
+  volatile long long wpos, rpos;	// log positions, wpos is advanced by thread only, rpos by main thread only
+  struct {
+    volatile long long end;
+    volatile unsigned crc32_complement;
+  } seg[PREFETCH_SEGMENTS];
+  volatile int seg_wptr, seg_rptr;
+} BP = { .fd = -1, .inotify_fd = -1, .wakeup_fd = -1, .event_fd = -1 };
+
+static int binlog_tailing;
+
+static int prefetch_event_handler (int fd, void *data, event_t *ev) {
+  long long x;
+  while (read (fd, &x, 8) == 8) {
+  }
+  return 0;
+}
+
+static void prefetch_wait (int timeout) {
+  struct pollfd P[2];
+  int n = 0;
+  if (BP.inotify_fd >= 0) {
+    P[n].fd = BP.inotify_fd;
+    P[n++].events = POLLIN;
+  }
+  P[n].fd = BP.wakeup_fd;
+  P[n++].events = POLLIN;
+  if (poll (P, n, timeout) > 0) {
+    static char buff[4096];
+    long long x;
+    if (BP.inotify_fd >= 0) {
+      while (read (BP.inotify_fd, buff, sizeof (buff)) > 0) {
+      }
+    }
+    while (read (BP.wakeup_fd, &x, 8) == 8) {
+    }
+  }
+}
+
+static void *binlog_prefetch_thread (void *arg) {
+  long long pos = BP.wpos;
+  unsigned crc32_complement = BP.crc32_complement;
+  while (!BP.stop) {
+    long long len = PREFETCH_RING_SIZE - (pos - BP.rpos);
+    int tail = PREFETCH_RING_SIZE - (pos & (PREFETCH_RING_SIZE - 1));
+    if (len > tail) {
+      len = tail;
+    }
+    if (len > PREFETCH_READ_SIZE) {
+      len = PREFETCH_READ_SIZE;
+    }
+    if (len <= 0 || BP.seg_wptr - BP.seg_rptr >= PREFETCH_SEGMENTS) {
+      /* main thread is behind */
+      prefetch_wait (1);
+      continue;
+    }
+    char *p = BP.buf + (pos & (PREFETCH_RING_SIZE - 1));
+    long long r = pread (BP.fd, p, len, pos + BP.file_offset);
+    if (r < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      BP.error = errno;
+      break;
+    }
+    if (!r) {
+      prefetch_wait (BP.inotify_fd >= 0 ? PREFETCH_IDLE_TIMEOUT : 10);
+      continue;
+    }
+    crc32_complement = crc32_partial (p, r, crc32_complement);
+    pos += r;
+    int k = BP.seg_wptr & (PREFETCH_SEGMENTS - 1);
+    BP.seg[k].end = pos;
+    BP.seg[k].crc32_complement = crc32_complement;
+    __sync_synchronize ();
+    BP.seg_wptr++;
+    BP.wpos = pos;
+    __sync_fetch_and_add (&binlog_prefetch_bytes, r);
+    __sync_fetch_and_add (&binlog_prefetch_reads, 1);
+    if (BP.event_fd >= 0) {
+      long long x = 1;
+      assert (write (BP.event_fd, &x, 8) == 8);
+    }
+  }
+  return 0;
+}
+
+static void binlog_prefetch_stop (void) {
+  if (!BP.running) {
+    return;
+  }
+  BP.stop = 1;
+  long long x = 1;
+  assert (write (BP.wakeup_fd, &x, 8) == 8);
+  pthread_join (BP.thread, 0);
+  BP.running = 0;
+  if (BP.inotify_fd >= 0) {
+    close (BP.inotify_fd);
+    BP.inotify_fd = -1;
+  }
+  prefetch_crc32_pos = -1;
+  /* prefetched bytes, which weren't consumed, will be read again */
+  if (BP.fd >= 0 && BP.fd == binlog_fd) {
+    assert (lseek (binlog_fd, BP.rpos + BP.file_offset, SEEK_SET) == BP.rpos + BP.file_offset);
+  }
+  BP.fd = -1;
+  vkprintf (1, "binlog prefetch stopped at log position %lld\n", BP.rpos);
+}
+
+static int binlog_prefetch_start (void) {
+  if (BP.running) {
+    return 0;
+  }
+  if (binlog_fd < 0 || !Binlog || Binlog->info->iv || binlog_zipped || !binlog_disabled || binlog_check_mode || log_limit_pos >= 0) {
+    return -1;
+  }
+  if (!BP.buf) {
+    BP.buf = malloc (PREFETCH_RING_SIZE);
+    assert (BP.buf);
+    BP.wakeup_fd = eventfd (0, EFD_NONBLOCK);
+    assert (BP.wakeup_fd >= 0);
+    if (epoll_sethandler && epoll_insert) {
+      BP.event_fd = eventfd (0, EFD_NONBLOCK);
+      if (BP.event_fd >= 0) {
+        epoll_sethandler (BP.event_fd, 0, prefetch_event_handler, 0);
+        epoll_insert (BP.event_fd, EVT_READ | EVT_LEVEL);
+      }
+    }
+  }
+  BP.fd = binlog_fd;
+  BP.file_offset = log_headers_size - log_start_pos;
+  BP.wpos = BP.rpos = log_pos;
+  BP.seg_wptr = BP.seg_rptr = 0;
+  BP.stop = 0;
+  BP.error = 0;
+  /* crc32 of read but not yet replayed bytes */
+  BP.crc32_valid = !(disable_crc32 & 2) && log_crc32_pos >= tot_crc32_pos;
+  BP.crc32_complement = BP.crc32_valid ? crc32_partial (R.log_wptr - (log_pos - log_crc32_pos), log_pos - log_crc32_pos, log_crc32_complement) : 0;
+  BP.inotify_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+  if (BP.inotify_fd >= 0 && inotify_add_watch (BP.inotify_fd, binlogname, IN_MODIFY | IN_CLOSE_WRITE) < 0) {
+    vkprintf (1, "inotify_add_watch (%s) failed: %m, binlog will be polled\n", binlogname);
+    close (BP.inotify_fd);
+    BP.inotify_fd = -1;
+  }
+  if (pthread_create (&BP.thread, 0, binlog_prefetch_thread, 0)) {
+    kprintf ("cannot create binlog prefetch thread: %m\n");
+    binlog_prefetch = 0;
+    BP.fd = -1;
+    return -1;
+  }
+  BP.running = 1;
+  vkprintf (1, "binlog prefetch started for %s at log position %lld\n", binlogname, log_pos);
+  return 0;
+}
+
+static int binlog_prefetch_read (char *buf, int len) {
+  long long w = BP.wpos;
+  __sync_synchronize ();
+  if (w == BP.rpos && BP.error) {
+    kprintf ("binlog prefetch: pread () failed: %s, reading binlog directly\n", strerror (BP.error));
+    binlog_prefetch_stop ();
+    binlog_prefetch = 0;
+    return read (binlog_fd, buf, len);
+  }
+  if (len > w - BP.rpos) {
+    len = w - BP.rpos;
+  }
+  int i = BP.rpos & (PREFETCH_RING_SIZE - 1), l = PREFETCH_RING_SIZE - i;
+  if (l > len) {
+    l = len;
+  }
+  memcpy (buf, BP.buf + i, l);
+  memcpy (buf + l, BP.buf, len - l);
+  long long rpos = BP.rpos + len;
+  /* crc32 up to the end of prefetched segment is already known */
+  while (BP.seg_rptr != BP.seg_wptr) {
+    int k = BP.seg_rptr & (PREFETCH_SEGMENTS - 1);
+    if (BP.seg[k].end > rpos) {
+      break;
+    }
+    if (BP.seg[k].end == rpos && BP.crc32_valid) {
+      prefetch_crc32_pos = rpos;
+      prefetch_crc32_complement = BP.seg[k].crc32_complement;
+    }
+    BP.seg_rptr++;
+  }
+  __sync_synchronize ();
+  BP.rpos = rpos;
+  return len;
+}
+
+static int read_binlog_bytes (char *buf, int len) {
+  if (binlog_tailing && binlog_prefetch && binlog_prefetch_start () >= 0) {
+    return binlog_prefetch_read (buf, len);
+  }
+  int r = read (binlog_fd, buf, len);
+  if (r > 0 && Binlog && Binlog->fd == binlog_fd) {
+    kfs_account_read (Binlog, r);
+    if (!kfs_no_fadvise && Binlog->access_pattern == KFS_ACCESS_SEQUENTIAL) {
+      kfs_drop_behind (Binlog, lseek (binlog_fd, 0, SEEK_CUR));
+    }
+  }
+  return r;
+}
+
 #define	LOG_READ_THRESHOLD	1024
 
 int binlog_crc32_verbosity_level = 3;
@@ -1147,7 +1434,7 @@ int replay_log (int cutoff_time, int set_now) {
           r = s;
         }
       } else {
-        r = read (binlog_fd, R.log_start, s);
+        r = read_binlog_bytes (R.log_start, s);
         if (verbosity > 0 && (r || iteration)) {
           fprintf (stderr, "read %d bytes from binlog %s\n", r, binlogname);
         }
@@ -1166,6 +1453,7 @@ int replay_log (int cutoff_time, int set_now) {
       if (need_switch_binlog == 1) {
         assert (r == 0);
         assert (Binlog);
+        binlog_prefetch_stop ();
         kfs_file_handle_t NextBinlog = next_binlog (Binlog);
 
         if (!NextBinlog) {
@@ -1225,7 +1513,7 @@ int replay_log (int cutoff_time, int set_now) {
           r = s;
         }
       } else {
-        r = read (binlog_fd, R.log_wptr, s);
+        r = read_binlog_bytes (R.log_wptr, s);
         if (verbosity > 0 && (r || iteration)) {
           fprintf (stderr, "read %d bytes from binlog %s\n", r, binlogname);
         }
@@ -1416,7 +1704,7 @@ void init_log_data (long long new_log_pos, int log_timestamp, unsigned log_crc32
   assert (Binlog);
   binlog_zipped = Binlog->info->flags & 16;
   binlogname = Binlog->info->filename;
-  set_log_data (Binlog->fd, binlog_zipped ? ((kfs_binlog_zip_header_t *) Binlog->info->start)->orig_file_size : Binlog->info->file_size);
+  set_log_data (Binlog->fd, binlog_zipped ? kfs_get_binlog_file_size (Binlog->info) : Binlog->info->file_size);
   log_seek (new_log_pos, log_timestamp, log_crc32);
   next_binlog_rotate_pos = log_start_pos + max_binlog_size;
 }
@@ -1499,19 +1787,10 @@ void sync_binlog (int mode) {
   }
 }
 
-void flush_binlog_forced (int force_sync) {
+/* writes out everything accumulated in W, returns -1 if write() failed or was incomplete */
+static int write_binlog_buffer (void) {
   int w, s, t;
   long long log_file_pos;
-  if (!binlogname || binlog_disabled) {
-    return;
-  }
-  if (W.log_rptr == W.log_wptr) {
-    sync_binlog (force_sync * 2);
-    return;
-  }
-  if (verbosity > 0) {
-    fprintf (stderr, "%d flush_binlog()\n", now);
-  }
   if (W.log_endw) {
     assert (W.log_wptr < W.log_rptr && W.log_rptr <= W.log_endw); 
     s = W.log_endw - W.log_rptr;
@@ -1527,7 +1806,7 @@ void flush_binlog_forced (int force_sync) {
       w = write (binlog_fd, W.log_rptr, s);
       if (w < 0) {
         fprintf (stderr, "error writing %d bytes at %lld (file position %lld) to %s: %m\n", s, log_pos, log_file_pos, binlogname);
-        return;
+        return -1;
       }
       W.log_rptr += w;
       if (Binlog && !binlog_cyclic_mode) {
@@ -1536,7 +1815,7 @@ void flush_binlog_forced (int force_sync) {
       }
       log_pos += w;
       if (w < s) {
-        return;
+        return -1;
       }
     }
     W.log_rptr = W.log_start;
@@ -1558,7 +1837,7 @@ void flush_binlog_forced (int force_sync) {
       int binlog_write_errno = errno;
       kprintf ("error writing %d bytes at %lld (file position %lld) to %s: %m\n", s, log_pos, log_file_pos, binlogname);
       assert (binlog_write_errno == EINTR || binlog_write_errno == EAGAIN);
-      return;
+      return -1;
     }
     W.log_rptr += w;
     if (Binlog && !binlog_cyclic_mode) {
@@ -1567,6 +1846,33 @@ void flush_binlog_forced (int force_sync) {
     }
     log_pos += w;
   }
+  return 0;
+}
+
+static int binlog_commit_busy (void);
+static void binlog_commit_wait (void);
+
+void flush_binlog_forced (int force_sync) {
+  if (!binlogname || binlog_disabled) {
+    return;
+  }
+  if (binlog_commit_busy ()) {
+    if (!force_sync) {
+      /* events after the batch being written by group commit thread are written later */
+      return;
+    }
+    binlog_commit_wait ();
+  }
+  if (W.log_rptr == W.log_wptr) {
+    sync_binlog (force_sync * 2);
+    return;
+  }
+  if (verbosity > 0) {
+    fprintf (stderr, "%d flush_binlog()\n", now);
+  }
+  if (write_binlog_buffer () < 0) {
+    return;
+  }
   sync_binlog (1 + force_sync);
 }
 
@@ -1624,7 +1930,8 @@ void flush_binlog (void) {
       }
     }
   }
-  if (!binlog_write_active && W.log_rptr != W.log_wptr) {
+  /* with group commit requests, events are written by binlog_group_commit_work () */
+  if (!binlog_write_active && !binlog_commit_busy () && !binlog_commit_pending () && W.log_rptr != W.log_wptr) {
     long long log_file_pos = log_pos - log_start_pos + log_headers_size;
     int w, t;
     // assert (lseek (binlog_fd, log_file_pos, SEEK_SET) == log_file_pos);
@@ -1681,6 +1988,351 @@ void flush_binlog (void) {
 
 }
 
+/*
+ *	GROUP COMMIT
+ *
+ *	binlog_commit_request () remembers current end of binlog and a callback;
+ *	binlog_group_commit_work (), invoked once per event loop iteration, passes
+ *	all pending events to group commit thread as soon as the oldest request has waited
+ *	binlog_commit_delay seconds (or binlog_commit_bytes are pending); the thread writes
+ *	them with one write () and one fdatasync (), and after that the event loop
+ *	invokes callbacks of all requests that became durable
+ */
+
+int binlog_group_commit;
+double binlog_commit_delay;
+int binlog_commit_bytes = (1 << 20);
+long long log_durable_pos;
+
+long long binlog_commits, binlog_commit_requests, binlog_committed_bytes;
+double binlog_commit_sync_time, binlog_commit_max_sync_time;
+long long binlog_commit_wait_hist[BINLOG_COMMIT_HIST_SIZE], binlog_commit_sync_hist[BINLOG_COMMIT_HIST_SIZE];
+
+struct binlog_commit_waiter {
+  long long pos;
+  double time;
+  void (*on_durable)(void *extra, int arg);
+  void *extra;
+  int arg;
+};
+
+static struct binlog_commit_waiter *CW;
+static int CW_size, CW_first, CW_num;
+
+static void binlog_commit_hist_add (long long *H, double t) {
+  long long us = (long long) (t * 1e6);
+  int i = 0;
+  while (us >= 2 && i < BINLOG_COMMIT_HIST_SIZE - 1) {
+    us >>= 1;
+    i++;
+  }
+  H[i]++;
+}
+
+void binlog_commit_request (void (*on_durable)(void *extra, int arg), void *extra, int arg) {
+  long long pos = log_last_pos ();
+  if (!binlog_group_commit || !binlogname || binlog_disabled || pos <= log_durable_pos) {
+    on_durable (extra, arg);
+    return;
+  }
+  if (CW_num == CW_size) {
+    int new_size = CW_size ? 2 * CW_size : 1024;
+    struct binlog_commit_waiter *N = malloc (new_size * sizeof (struct binlog_commit_waiter));
+    assert (N);
+    int i;
+    for (i = 0; i < CW_num; i++) {
+      N[i] = CW[(CW_first + i) & (CW_size - 1)];
+    }
+    free (CW);
+    CW = N;
+    CW_size = new_size;
+    CW_first = 0;
+  }
+  struct binlog_commit_waiter *R = &CW[(CW_first + CW_num++) & (CW_size - 1)];
+  R->pos = pos;
+  R->time = get_utime (CLOCK_MONOTONIC);
+  R->on_durable = on_durable;
+  R->extra = extra;
+  R->arg = arg;
+  binlog_commit_requests++;
+}
+
+int binlog_commit_pending (void) {
+  return CW_num;
+}
+
+/* write () and fdatasync () of a batch are done by group commit thread,
+   which wakes up the event loop through eventfd; W.log_rptr is advanced and
+   callbacks are invoked by main thread in binlog_group_commit_work () */
+static struct {
+  pthread_t thread;
+  int running;			// -1 if thread can't be used, batches are committed synchronously
+  int wakeup_fd, event_fd;
+  volatile int busy, done, error;
+  int fd, segs, wrapped;
+  char *ptr[2];
+  int len[2];
+  long long file_pos[2];
+  char *rptr_end;		// W.log_rptr after batch
+  long long bytes;
+  double sync_time;
+} GC = { .wakeup_fd = -1, .event_fd = -1 };
+
+static void *binlog_commit_thread (void *arg) {
+  while (1) {
+    long long x;
+    if (read (GC.wakeup_fd, &x, 8) != 8 || !GC.busy || GC.done) {
+      continue;
+    }
+    __sync_synchronize ();
+    double t = get_utime (CLOCK_MONOTONIC);
+    int i, err = 0;
+    for (i = 0; i < GC.segs && !err; i++) {
+      char *p = GC.ptr[i];
+      int l = GC.len[i];
+      long long off = GC.file_pos[i];
+      while (l > 0) {
+        int r = pwrite (GC.fd, p, l, off);
+        if (r < 0) {
+          if (errno != EINTR) {
+            err = errno;
+            break;
+          }
+          continue;
+        }
+        p += r;
+        l -= r;
+        off += r;
+      }
+    }
+    if (!err && fdatasync (GC.fd) < 0) {
+      err = errno;
+    }
+    GC.sync_time = get_utime (CLOCK_MONOTONIC) - t;
+    GC.error = err;
+    __sync_synchronize ();
+    GC.done = 1;
+    x = 1;
+    assert (write (GC.event_fd, &x, 8) == 8);
+  }
+  return 0;
+}
+
+static int binlog_commit_event_handler (int fd, void *data, event_t *ev) {
+  long long x;
+  while (read (fd, &x, 8) == 8) {
+  }
+  /* batch is accounted by binlog_group_commit_work () after epoll_work () */
+  return 0;
+}
+
+static int binlog_commit_thread_start (void) {
+  if (GC.running) {
+    return GC.running;
+  }
+  GC.running = -1;
+  if (!epoll_sethandler || !epoll_insert) {
+    return -1;
+  }
+  GC.wakeup_fd = eventfd (0, 0);
+  GC.event_fd = eventfd (0, EFD_NONBLOCK);
+  if (GC.wakeup_fd < 0 || GC.event_fd < 0) {
+    kprintf ("cannot create eventfd for group commit thread: %m, binlog will be synced by main thread\n");
+    return -1;
+  }
+  if (pthread_create (&GC.thread, 0, binlog_commit_thread, 0)) {
+    kprintf ("cannot create group commit thread: %m, binlog will be synced by main thread\n");
+    return -1;
+  }
+  epoll_sethandler (GC.event_fd, 0, binlog_commit_event_handler, 0);
+  epoll_insert (GC.event_fd, EVT_READ | EVT_LEVEL);
+  GC.running = 1;
+  vkprintf (1, "group commit thread started\n");
+  return 1;
+}
+
+static void binlog_commit_account (long long bytes, double sync_time) {
+  binlog_sync_last = now;
+  log_durable_pos = log_pos;
+  binlog_commits++;
+  binlog_committed_bytes += bytes;
+  binlog_commit_sync_time += sync_time;
+  if (sync_time > binlog_commit_max_sync_time) {
+    binlog_commit_max_sync_time = sync_time;
+  }
+  binlog_commit_hist_add (binlog_commit_sync_hist, sync_time);
+  vkprintf (2, "group commit: %lld bytes, durable position %lld, %.6f seconds\n", bytes, log_durable_pos, sync_time);
+}
+
+static void binlog_commit_add_segment (char *p, int len, long long *file_pos) {
+  if (len > 0) {
+    GC.ptr[GC.segs] = p;
+    GC.len[GC.segs] = len;
+    GC.file_pos[GC.segs++] = *file_pos;
+    *file_pos += len;
+    GC.bytes += len;
+  }
+}
+
+/* encrypts pending part of the buffer (as write_binlog_buffer () does) and passes it to the thread;
+   W.log_rptr isn't advanced till the batch is written, so these bytes aren't overwritten */
+static void binlog_commit_start (void) {
+  long long file_pos = log_pos - log_start_pos + log_headers_size;
+  char *r = W.log_rptr;
+  GC.segs = 0;
+  GC.bytes = 0;
+  GC.fd = binlog_fd;
+  GC.wrapped = W.log_endw != 0;
+  if (W.log_endw) {
+    if (r <= W.log_wcrypt_ptr && W.log_wcrypt_ptr < W.log_endw) {
+      relax_write_log_crc32 (); /* relax crc32 before encryption */
+      kfs_buffer_crypt (Binlog, W.log_wcrypt_ptr, W.log_endw - W.log_wcrypt_ptr, file_pos + (W.log_wcrypt_ptr - r));
+      W.log_wcrypt_ptr = W.log_start;
+    }
+    binlog_commit_add_segment (r, W.log_endw - r, &file_pos);
+    r = W.log_start;
+  }
+  if (r <= W.log_wcrypt_ptr && W.log_wcrypt_ptr < W.log_wptr) {
+    relax_write_log_crc32 (); /* relax crc32 before encryption */
+    kfs_buffer_crypt (Binlog, W.log_wcrypt_ptr, W.log_wptr - W.log_wcrypt_ptr, file_pos + (W.log_wcrypt_ptr - r));
+    W.log_wcrypt_ptr = W.log_wptr;
+  }
+  binlog_commit_add_segment (r, W.log_wptr - r, &file_pos);
+  GC.rptr_end = W.log_wptr;
+  GC.done = 0;
+  __sync_synchronize ();
+  GC.busy = 1;
+  long long x = 1;
+  assert (write (GC.wakeup_fd, &x, 8) == 8);
+}
+
+/* main thread: accounts batch written by group commit thread */
+static void binlog_commit_complete (void) {
+  if (!GC.busy || !GC.done) {
+    return;
+  }
+  __sync_synchronize ();
+  if (GC.error) {
+    errno = GC.error;
+    kprintf ("error writing or syncing binlog %s: %m\n", binlogname);
+    exit (3);
+  }
+  W.log_rptr = GC.rptr_end;
+  if (GC.wrapped || W.log_rptr == W.log_endw) {
+    if (W.log_rptr == W.log_endw) {
+      W.log_rptr = W.log_start;
+    }
+    W.log_endw = 0;
+  }
+  if (Binlog && !binlog_cyclic_mode) {
+    Binlog->info->file_size += GC.bytes;
+  }
+  log_pos += GC.bytes;
+  GC.busy = GC.done = 0;
+  binlog_commit_account (GC.bytes, GC.sync_time);
+}
+
+static int binlog_commit_busy (void) {
+  return GC.busy;
+}
+
+/* waits for the batch being written, used before other writes to binlog */
+static void binlog_commit_wait (void) {
+  while (GC.busy && !GC.done) {
+    struct pollfd P;
+    P.fd = GC.event_fd;
+    P.events = POLLIN;
+    poll (&P, 1, 10);
+  }
+  binlog_commit_complete ();
+}
+
+static void binlog_commit (void) {
+  if (binlog_commit_thread_start () > 0) {
+    if (binlog_write_active) {
+      /* completes aio_write () of flush_binlog (), no new one is queued while there are commit requests */
+      flush_binlog ();
+      if (binlog_write_active) {
+        return;
+      }
+    }
+    binlog_commit_start ();
+    return;
+  }
+  double t = get_utime (CLOCK_MONOTONIC);
+  long long start_pos = log_pos;
+  if (W.log_rptr != W.log_wptr && write_binlog_buffer () < 0) {
+    return;
+  }
+  if (fdatasync (binlog_fd) < 0) {
+    kprintf ("error syncing binlog %s: %m\n", binlogname);
+    exit (3);
+  }
+  binlog_commit_account (log_pos - start_pos, get_utime (CLOCK_MONOTONIC) - t);
+}
+
+void binlog_group_commit_work (void) {
+  binlog_commit_complete ();
+  if (!CW_num) {
+    return;
+  }
+  if (!binlogname || binlog_disabled || binlog_fd < 0) {
+    log_durable_pos = log_last_pos ();
+  } else if (!GC.busy && (binlog_commit_delay <= 0 || get_utime (CLOCK_MONOTONIC) >= CW[CW_first].time + binlog_commit_delay || log_write_pos () - log_durable_pos >= binlog_commit_bytes)) {
+    binlog_commit ();
+  }
+  double t = get_utime (CLOCK_MONOTONIC);
+  /* callbacks may add new requests at the tail */
+  while (CW_num > 0 && CW[CW_first].pos <= log_durable_pos) {
+    struct binlog_commit_waiter R = CW[CW_first];
+    CW_first = (CW_first + 1) & (CW_size - 1);
+    CW_num--;
+    binlog_commit_hist_add (binlog_commit_wait_hist, t - R.time);
+    R.on_durable (R.extra, R.arg);
+  }
+}
+
+static int binlog_commit_hist_print (char *buff, int size, long long *H) {
+  int i, l = 0;
+  for (i = 0; i < BINLOG_COMMIT_HIST_SIZE && l < size; i++) {
+    if (H[i]) {
+      l += snprintf (buff + l, size - l, "%s%s%lld:%lld", l ? " " : "", i == BINLOG_COMMIT_HIST_SIZE - 1 ? ">=" : "<", i == BINLOG_COMMIT_HIST_SIZE - 1 ? 1LL << i : 2LL << i, H[i]);
+    }
+  }
+  return l < size ? l : size;
+}
+
+int binlog_group_commit_stats (char *buff, int size) {
+  if (!binlog_group_commit || size <= 0) {
+    return 0;
+  }
+  int l = snprintf (buff, size,
+    "group_commit_delay\t%.3fms\n"
+    "group_commit_bytes\t%d\n"
+    "group_commit_batches\t%lld\n"
+    "group_commit_requests\t%lld\n"
+    "group_commit_pending_requests\t%d\n"
+    "group_commit_avg_batch_requests\t%.3f\n"
+    "group_commit_avg_batch_bytes\t%.1f\n"
+    "group_commit_avg_sync_time\t%.6fs\n"
+    "group_commit_max_sync_time\t%.6fs\n"
+    "binlog_durable_pos\t%lld\n",
+    binlog_commit_delay * 1000, binlog_commit_bytes, binlog_commits, binlog_commit_requests, CW_num,
+    binlog_commits ? (double) (binlog_commit_requests - CW_num) / binlog_commits : 0,
+    binlog_commits ? (double) binlog_committed_bytes / binlog_commits : 0,
+    binlog_commits ? binlog_commit_sync_time / binlog_commits : 0,
+    binlog_commit_max_sync_time, log_durable_pos);
+  if (l >= size - 64) {
+    return l < size ? l : size;
+  }
+  l += snprintf (buff + l, size - l, "group_commit_sync_hist_us\t");
+  l += binlog_commit_hist_print (buff + l, size - l - 32, binlog_commit_sync_hist);
+  l += snprintf (buff + l, size - l, "\ngroup_commit_wait_hist_us\t");
+  l += binlog_commit_hist_print (buff + l, size - l - 2, binlog_commit_wait_hist);
+  l += snprintf (buff + l, size - l, "\n");
+  return l < size ? l : size;
+}
+
 void flush_cbinlog (int force_sync) {
   assert (binlog_cyclic_mode);
   assert (W.log_rptr == W.log_start);
@@ -1842,9 +2494,12 @@ int compute_uncommitted_log_bytes (void) {
 
 /* used for implementing -r key : use epoll_pre_event = read_new_events */
 void read_new_events (void) {
+  binlog_tailing = 1;
   int res = replay_log (0, 1);
+  binlog_tailing = 0;
   if (res < 0) {
     fprintf (stderr, "fatal: ceased reading binlog updates from %d.\n", binlog_fd);
+    binlog_prefetch_stop ();
     binlog_fd = -1;
   }
 }
@@ -208,6 +208,22 @@ void flush_binlog_last (void);
 void sync_binlog (int mode);
 void flush_cbinlog (int force_sync);
 
+/* group commit: on_durable (extra, arg) is invoked as soon as all binlog events
+   allocated before binlog_commit_request () are written and fdatasync()'ed;
+   write () and fdatasync () are done by a separate thread, which wakes up epoll (if it is linked),
+   binlog_group_commit_work () must be invoked once per event loop iteration */
+#define	BINLOG_COMMIT_HIST_SIZE	24
+
+extern int binlog_group_commit, binlog_commit_bytes;
+extern double binlog_commit_delay;
+extern long long log_durable_pos;
+extern long long binlog_commits, binlog_commit_requests, binlog_committed_bytes;
+
+void binlog_commit_request (void (*on_durable)(void *extra, int arg), void *extra, int arg);
+int binlog_commit_pending (void);
+void binlog_group_commit_work (void);
+int binlog_group_commit_stats (char *buff, int size);
+
 int compute_uncommitted_log_bytes (void);
 long long log_cur_pos (void);
 // NB: while reading binlog, this is position of the log event being interpreted;
@@ -218,6 +234,12 @@ void unalloc_log_event (int bytes);
 
 void read_new_events (void);	// set epoll_pre_event = read_new_events for -r key
 
+/* binlog prefetch (--prefetch-binlog): while read_new_events () tails the binlog of a read-only
+   replica, new bytes are read and their crc32 is computed by a background thread woken by inotify;
+   the thread wakes up the event loop through an eventfd, if the program has one */
+extern int binlog_prefetch;
+extern long long binlog_prefetch_bytes, binlog_prefetch_reads, binlog_prefetch_crc32_hits;
+
 /* file locks (will eventually move into kfs.h) */
 
 int lock_whole_file (int fd, int mode);
@@ -49,7 +49,7 @@
 #define COMMIT "unknown"
 #endif
 
-#define	VERSION_STR	"pack-binlog-1.13"
+#define	VERSION_STR	"pack-binlog-1.14"
 const char FullVersionStr[] = VERSION_STR " compiled at " __DATE__ " " __TIME__ " by gcc " __VERSION__ " "
 #ifdef __LP64__
   "64-bit"
@@ -714,6 +714,90 @@ int pack_binlog_file (const char *orig_binlog_filename, kfs_bz_format_t format,
   return 0;
 }
 
+/* appends bytes which were added to the binlog since previous call, doesn't require LEV_ROTATE_TO at the end */
+int pack_binlog_file_stream (const char *orig_binlog_filename, kfs_bz_format_t format, int level, int frame_size) {
+  filenames_t F;
+  if (filenames_init (&F, orig_binlog_filename, 1, 0) < 0) {
+    return -1;
+  }
+  if (format != kfs_bzf_zlib && format != kfs_bzf_xz) {
+    kprintf ("%s: only zlib and xz formats are supported for streaming zipped binlogs.\n", __func__);
+    return -1;
+  }
+
+  struct stat st;
+  int fd = open (orig_binlog_filename, O_RDONLY);
+  if (fd < 0) {
+    kprintf ("%s: open (\"%s\", O_RDONLY) failed. %m\n", __func__, orig_binlog_filename);
+    return -1;
+  }
+  if (fstat (fd, &st) < 0) {
+    kprintf ("%s: fstat for the file '%s' failed. %m\n", __func__, orig_binlog_filename);
+    assert (!close (fd));
+    return -1;
+  }
+  if (st.st_size < 36 || pread (fd, read_buff, 36, 0) != 36) {
+    kprintf ("%s: binlog file '%s' is too small (%lld bytes).\n", __func__, orig_binlog_filename, (long long) st.st_size);
+    assert (!close (fd));
+    return -1;
+  }
+  int magic = *((int *) read_buff);
+  if (magic != LEV_START && magic != LEV_ROTATE_FROM) {
+    kprintf ("binlog '%s' starts by 0x%08x, but expected LEV_START or LEV_ROTATE_FROM\n", orig_binlog_filename, magic);
+    assert (!close (fd));
+    return -1;
+  }
+  long long log_start_pos = magic == LEV_ROTATE_FROM ? ((struct lev_rotate_from *) read_buff)->cur_log_pos : 0;
+
+  kfs_zs_writer_t W;
+  if (kfs_zs_writer_open (&W, F.output_filename, format, level, frame_size, (char *) read_buff) < 0) {
+    assert (!close (fd));
+    return -1;
+  }
+  W.compress = bz_compress;
+
+  long long off = W.Z->orig_size, start_off = off;
+  if (off > st.st_size) {
+    kprintf ("%s: '%s' contains %lld bytes, but binlog '%s' has only %lld bytes.\n", __func__, F.output_filename, off, orig_binlog_filename, (long long) st.st_size);
+    kfs_zs_writer_close (&W, 0, 0);
+    assert (!close (fd));
+    return -1;
+  }
+  while (off < st.st_size) {
+    int n = st.st_size - off < sizeof (read_buff) ? st.st_size - off : sizeof (read_buff);
+    ssize_t r = pread (fd, read_buff, n, off);
+    if (r != n) {
+      kprintf ("%s: read %lld of expected %d bytes from file '%s' from offset %lld. %m\n", __func__, (long long) r, n, orig_binlog_filename, off);
+      kfs_zs_writer_close (&W, 0, 0);
+      assert (!close (fd));
+      return -1;
+    }
+    if (kfs_zs_write (&W, read_buff, n) < 0) {
+      kfs_zs_writer_close (&W, 0, 0);
+      assert (!close (fd));
+      return -1;
+    }
+    off += n;
+  }
+
+  /* completed binlog: index is written, and file hash is taken from LEV_ROTATE_TO */
+  struct lev_rotate_to RT;
+  int seal = 0;
+  if (pread (fd, &RT, 36, st.st_size - 36) == 36 && RT.type == LEV_ROTATE_TO && RT.next_log_pos == log_start_pos + st.st_size) {
+    seal = 1;
+  }
+  assert (!close (fd));
+  long long data_end = W.Z->data_end;
+  if (kfs_zs_writer_close (&W, seal, seal ? RT.cur_log_hash : 0) < 0) {
+    return -1;
+  }
+
+  printf ("%s\n", F.output_filename);
+  vkprintf (1, "appended %lld bytes, original file size: %lld, compressed file size: %lld, ratio: %.3lf%%%s\n",
+    off - start_off, off, data_end, (100.0 * data_end) / (off ? off : 1), seal ? ", sealed" : "");
+  return 0;
+}
+
 typedef struct {
   int write_buff_off;
   int size;
@@ -807,6 +891,31 @@ int show_info_zipped_binlog (const char *filename) {
     return -1;
   }
   struct kfs_file_info *FI = B->info;
+  if (FI->zs) {
+    kfs_binlog_zs_header_t *ZH = (kfs_binlog_zs_header_t *) FI->start;
+    row ("filename");
+    printf ("%s\n", filename);
+    row ("format");
+    printf ("%s (streaming)\n", get_format (ZH->format & 15));
+    row ("level");
+    printf ("%d\n", (ZH->format & 0xf0) >> 4);
+    row ("frame_size");
+    printf ("%d\n", ZH->frame_size);
+    row ("frames");
+    printf ("%d\n", FI->zs->frames);
+    row ("orig_file_size");
+    printf ("%lld\n", FI->zs->orig_size);
+    row ("head");
+    printf ("%s\n", get_bytes ((unsigned char *) ZH->first36_bytes, 36));
+    row ("sealed");
+    printf ("%s\n", FI->zs->sealed ? "yes" : "no");
+    if (FI->zs->file_hash) {
+      row ("hash");
+      printf ("0x%016llx\n", FI->zs->file_hash);
+    }
+    kfs_close_file (B, 1);
+    return 0;
+  }
   kfs_binlog_zip_header_t *H = (kfs_binlog_zip_header_t *) FI->start;
   row ("filename");
   printf ("%s\n", filename);
@@ -842,6 +951,65 @@ int show_info_zipped_binlog (const char *filename) {
   return 0;
 }
 
+static int unpack_streaming_binlog_file (kfs_file_handle_t B, filenames_t *F, int decompress) {
+  const int test_mode = (decompress & 4) ? 1 : 0;
+  struct kfs_file_info *FI = B->info;
+  kfs_binlog_zs_header_t *ZH = (kfs_binlog_zs_header_t *) FI->start;
+  int ofd = -1;
+  if (!test_mode) {
+    ofd = open_write_fd (F->output_tmp_filename, 0, (decompress & 2) ? 1 : -1);
+    if (ofd < 0) {
+      kfs_close_file (B, 1);
+      return -1;
+    }
+  }
+  const long long orig_file_size = FI->zs->orig_size;
+  long long off = 0;
+  while (off < orig_file_size) {
+    int m = sizeof (write_buff);
+    if (kfs_bz_decode (B, off, write_buff, &m, NULL) < 0 || !m) {
+      kprintf ("%s: kfs_bz_decode (off: %lld) failed.\n", __func__, off);
+      kfs_close_file (B, 1);
+      if (ofd >= 0) {
+        assert (!close (ofd));
+      }
+      return -1;
+    }
+    if (!off && (m < 36 || memcmp (ZH->first36_bytes, write_buff, 36))) {
+      kprintf ("%s: first36_bytes isn't matched, file: '%s'.\n", __func__, FI->filename);
+      kfs_close_file (B, 1);
+      return -1;
+    }
+    if (ofd >= 0) {
+      writeout (write_buff, m);
+    }
+    off += m;
+  }
+  vkprintf (1, "%s: decoded %lld bytes from %d frames of the file '%s'.\n", __func__, off, FI->zs->frames, FI->filename);
+  const int mtime = FI->mtime;
+  kfs_close_file (B, 1);
+
+  if (ofd > 1) {
+    assert (!fsync (ofd));
+    assert (!close (ofd));
+    if (!access (F->output_filename, 0)) {
+      kprintf ("file '%s' already exists. Renaming temporary file '%s' failed.\n", F->output_filename, F->output_tmp_filename);
+      return -1;
+    }
+    if (rename (F->output_tmp_filename, F->output_filename) < 0) {
+      kprintf ("rename temporary file '%s' to file '%s' failed. %m\n", F->output_tmp_filename, F->output_filename);
+      return -1;
+    }
+    struct timeval times[2];
+    memset (times, 0, sizeof (times));
+    times[0].tv_sec = times[1].tv_sec = mtime;
+    if (utimes (F->output_filename, times) < 0) {
+      kprintf ("warning: utimes for file '%s' failed. %m\n", F->output_filename);
+    }
+  }
+  return 0;
+}
+
 int unpack_binlog_file (const char *filename, int decompress) {
   const int test_mode = (decompress & 4) ? 1 : 0;
   const int integrity_check = 1;
@@ -868,6 +1036,9 @@ int unpack_binlog_file (const char *filename, int decompress) {
     return -1;
   }
   struct kfs_file_info *FI = B->info;
+  if (FI->zs) {
+    return unpack_streaming_binlog_file (B, &F, decompress);
+  }
   kfs_binlog_zip_header_t *H = (kfs_binlog_zip_header_t *) FI->start;
 
   int ofd = -1;
@@ -1019,6 +1190,9 @@ void usage (void) {
     "\t[-i]\t\tshow zipped binlog info\n"
     "\t[-x]\t\txz compression\n"
     "\t[-z]\t\tzlib compression\n"
+    "\t[-s]\t\tstreaming format: independently compressed frames with index, allows random seek;\n"
+    "\t\t\trepeated calls append new binlog bytes, binlog may be incomplete\n"
+    "\t[-f<size>]\tframe size for streaming format (default %d)\n"
     "\t[-1]\t\tcompress faster\n"
     "\t[-6]\t\tdefault for xz\n"
     "\t[-9]\t\tcompress better (default for zlib)\n"
@@ -1027,7 +1201,7 @@ void usage (void) {
 #ifdef BINLOG_ZIP_BZ2
     "\t[-j]\t\tbz2 compression\n"
 #endif
-  );
+    , KFS_BINLOG_ZS_DEFAULT_FRAME_SIZE);
 /*
   int i;
   for (i = 0; i < 10; i++) {
@@ -1039,10 +1213,10 @@ void usage (void) {
 }
 
 int main (int argc, char *argv[]) {
-  int i, level = -1, format = kfs_bzf_xz, decompress = 0, info = 0;
+  int i, level = -1, format = kfs_bzf_xz, decompress = 0, info = 0, stream = 0, frame_size = KFS_BINLOG_ZS_DEFAULT_FRAME_SIZE;
   maxconn = 10;
   set_debug_handlers ();
-  while ((i = getopt (argc, argv, "0123456789Kcdhijtu:vxz")) != -1) {
+  while ((i = getopt (argc, argv, "0123456789Kcdf:hijstu:vxz")) != -1) {
     switch (i) {
     case '0'...'9':
       level = i - '0';
@@ -1056,6 +1230,12 @@ int main (int argc, char *argv[]) {
     case 'd':
       decompress |= 1;
     break;
+    case 'f':
+      frame_size = atoi (optarg);
+      if (frame_size < 4096 || frame_size > KFS_BINLOG_ZS_MAX_FRAME_SIZE) {
+        usage ();
+      }
+    break;
     case 'h':
       usage ();
     break;
@@ -1065,6 +1245,9 @@ int main (int argc, char *argv[]) {
     case 'j':
       format = kfs_bzf_bz2;
     break;
+    case 's':
+      stream = 1;
+    break;
     case 't':
       decompress |= 4;
     break;
@@ -1121,7 +1304,12 @@ int main (int argc, char *argv[]) {
 
   if (!decompress) {
     vkprintf (1, "format: %d, level: %d\n", (int) format, level);
-    if (pack_binlog_file (argv[optind], format, level) < 0) {
+    if (stream) {
+      if (pack_binlog_file_stream (argv[optind], format, level, frame_size) < 0) {
+        vkprintf (2, "pack_binlog_file_stream ('%s', %d, %d) failed.\n", argv[optind], format, level);
+        exit (1);
+      }
+    } else if (pack_binlog_file (argv[optind], format, level) < 0) {
       vkprintf (2, "pack_binlog_file ('%s', %d, %d) failed.\n", argv[optind], format, level);
       exit (1);
     }
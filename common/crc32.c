@@ -23,6 +23,13 @@
 #include <stdlib.h>
 #include <math.h>
 #include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#ifdef __x86_64__
+#include <cpuid.h>
+#include <wmmintrin.h>
+#include <smmintrin.h>
+#endif
 
 #include "crc32.h"
 #include "server-functions.h"
@@ -327,7 +334,7 @@ unsigned crc32_partial_fast (const void *data, int len, unsigned crc) {
 }
 */
 
-unsigned crc32_partial (const void *data, int len, unsigned crc) {
+static unsigned crc32_partial_four_tables (const void *data, int len, unsigned crc) {
   const int *p = (const int *) data;
   int x;
 #define DO_ONE(v) crc ^= v; crc = crc32_table0[crc & 0xff] ^ crc32_table1[(crc & 0xff00) >> 8] ^ crc32_table2[(crc & 0xff0000) >> 16] ^ crc32_table[crc >> 24];
@@ -369,10 +376,220 @@ unsigned crc32_partial (const void *data, int len, unsigned crc) {
   return crc;
 }
 
+#ifdef __x86_64__
+/* folding by carry-less multiplication, see Intel's "Fast CRC Computation for Generic Polynomials
+   Using PCLMULQDQ Instruction"; constants are x^k mod P for the bit-reflected 0x04C11DB7 polynomial */
+static const unsigned long long crc32_clmul_k1k2[2] __attribute__ ((aligned (16))) = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+static const unsigned long long crc32_clmul_k3k4[2] __attribute__ ((aligned (16))) = { 0x01751997d0ULL, 0x00ccaa009eULL };
+static const unsigned long long crc32_clmul_k5k0[2] __attribute__ ((aligned (16))) = { 0x0163cd6124ULL, 0x0000000000ULL };
+static const unsigned long long crc32_clmul_poly[2] __attribute__ ((aligned (16))) = { 0x01db710641ULL, 0x01f7011641ULL };
+
+/* len >= 64, len % 16 == 0 */
+static unsigned __attribute__ ((target ("pclmul,sse4.1"))) crc32_partial_clmul (const void *data, int len, unsigned crc) {
+  const char *p = data;
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+  x1 = _mm_loadu_si128 ((const __m128i *) (p + 0x00));
+  x2 = _mm_loadu_si128 ((const __m128i *) (p + 0x10));
+  x3 = _mm_loadu_si128 ((const __m128i *) (p + 0x20));
+  x4 = _mm_loadu_si128 ((const __m128i *) (p + 0x30));
+  x1 = _mm_xor_si128 (x1, _mm_cvtsi32_si128 (crc));
+  x0 = _mm_load_si128 ((const __m128i *) crc32_clmul_k1k2);
+  p += 64;
+  len -= 64;
+
+  /* four parallel folds of 512 bits */
+  while (len >= 64) {
+    x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128 (x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128 (x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128 (x4, x0, 0x00);
+    x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128 (x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128 (x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128 (x4, x0, 0x11);
+    x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x5), _mm_loadu_si128 ((const __m128i *) (p + 0x00)));
+    x2 = _mm_xor_si128 (_mm_xor_si128 (x2, x6), _mm_loadu_si128 ((const __m128i *) (p + 0x10)));
+    x3 = _mm_xor_si128 (_mm_xor_si128 (x3, x7), _mm_loadu_si128 ((const __m128i *) (p + 0x20)));
+    x4 = _mm_xor_si128 (_mm_xor_si128 (x4, x8), _mm_loadu_si128 ((const __m128i *) (p + 0x30)));
+    p += 64;
+    len -= 64;
+  }
+
+  /* fold 512 bits into 128 */
+  x0 = _mm_load_si128 ((const __m128i *) crc32_clmul_k3k4);
+  x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+  x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x2), x5);
+  x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+  x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x3), x5);
+  x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+  x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x4), x5);
+
+  while (len >= 16) {
+    x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+    x1 = _mm_xor_si128 (_mm_xor_si128 (x1, _mm_loadu_si128 ((const __m128i *) p)), x5);
+    p += 16;
+    len -= 16;
+  }
+
+  /* 128 bits -> 64 bits */
+  x2 = _mm_clmulepi64_si128 (x1, x0, 0x10);
+  x3 = _mm_setr_epi32 (~0, 0, ~0, 0);
+  x1 = _mm_xor_si128 (_mm_srli_si128 (x1, 8), x2);
+  x0 = _mm_loadl_epi64 ((const __m128i *) crc32_clmul_k5k0);
+  x2 = _mm_srli_si128 (x1, 4);
+  x1 = _mm_and_si128 (x1, x3);
+  x1 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+  x1 = _mm_xor_si128 (x1, x2);
+
+  /* Barrett reduction to 32 bits */
+  x0 = _mm_load_si128 ((const __m128i *) crc32_clmul_poly);
+  x2 = _mm_and_si128 (x1, x3);
+  x2 = _mm_clmulepi64_si128 (x2, x0, 0x10);
+  x2 = _mm_and_si128 (x2, x3);
+  x2 = _mm_clmulepi64_si128 (x2, x0, 0x00);
+  x1 = _mm_xor_si128 (x1, x2);
+  return _mm_extract_epi32 (x1, 1);
+}
+
+static int crc32_clmul_enabled = -1;
+
+static int crc32_clmul_check (void) {
+  unsigned a, b, c, d;
+  if (!__get_cpuid (1, &a, &b, &c, &d)) {
+    return 0;
+  }
+  return (c & bit_PCLMUL) && (c & bit_SSE4_1);
+}
+#endif
+
+unsigned crc32_partial (const void *data, int len, unsigned crc) {
+#ifdef __x86_64__
+  if (len >= 64) {
+    if (crc32_clmul_enabled < 0) {
+      crc32_clmul_enabled = crc32_clmul_check ();
+    }
+    if (crc32_clmul_enabled) {
+      int l = len & -16;
+      crc = crc32_partial_clmul (data, l, crc);
+      data = (const char *) data + l;
+      len -= l;
+    }
+  }
+#endif
+  return crc32_partial_four_tables (data, len, crc);
+}
+
 unsigned compute_crc32 (const void *data, int len) {
   return crc32_partial (data, len, -1) ^ -1;
 }
 
+/******************** multithreaded crc32 ********************/
+
+#define CRC32_PARALLEL_MIN_CHUNK (1 << 22)
+#define CRC32_PARALLEL_MAX_CHUNK (1 << 30)
+#define CRC32_PARALLEL_MAX_THREADS 8
+
+struct crc32_parallel_job {
+  const char *data;
+  long long len;
+  int chunk_size;
+  int chunks;
+  int threads;
+  int thread_id;
+  unsigned crc;
+  unsigned *res;
+};
+
+static void *crc32_parallel_thread (void *arg) {
+  struct crc32_parallel_job *J = arg;
+  int i;
+  for (i = J->thread_id; i < J->chunks; i += J->threads) {
+    long long off = (long long) i * J->chunk_size;
+    int l = (J->len - off < J->chunk_size) ? (int) (J->len - off) : J->chunk_size;
+    J->res[i] = crc32_partial (J->data + off, l, i ? -1 : J->crc) ^ -1;
+  }
+  return NULL;
+}
+
+static int crc32_parallel_threads (void) {
+  static int threads = 0;
+  if (!threads) {
+    long n = sysconf (_SC_NPROCESSORS_ONLN);
+    threads = (n < 1) ? 1 : (n > CRC32_PARALLEL_MAX_THREADS) ? CRC32_PARALLEL_MAX_THREADS : n;
+  }
+  return threads;
+}
+
+unsigned crc32_partial_parallel (const void *data, long long len, unsigned crc) {
+  int threads = crc32_parallel_threads ();
+  if (len < 2 * CRC32_PARALLEL_MIN_CHUNK || threads <= 1) {
+    while (len > CRC32_PARALLEL_MAX_CHUNK) {
+      crc = crc32_partial (data, CRC32_PARALLEL_MAX_CHUNK, crc);
+      data = (const char *) data + CRC32_PARALLEL_MAX_CHUNK;
+      len -= CRC32_PARALLEL_MAX_CHUNK;
+    }
+    return crc32_partial (data, len, crc);
+  }
+  if (threads > len / CRC32_PARALLEL_MIN_CHUNK) {
+    threads = len / CRC32_PARALLEL_MIN_CHUNK;
+  }
+  long long chunk_size = (len + threads - 1) / threads;
+  chunk_size = (chunk_size + 63) & -64;
+  if (chunk_size > CRC32_PARALLEL_MAX_CHUNK) {
+    chunk_size = CRC32_PARALLEL_MAX_CHUNK;
+  }
+  int i, chunks = (len + chunk_size - 1) / chunk_size;
+  unsigned *res = malloc (chunks * sizeof (unsigned));
+  assert (res);
+  struct crc32_parallel_job J[CRC32_PARALLEL_MAX_THREADS];
+  pthread_t T[CRC32_PARALLEL_MAX_THREADS];
+  int started[CRC32_PARALLEL_MAX_THREADS];
+#ifdef __x86_64__
+  if (crc32_clmul_enabled < 0) {
+    crc32_clmul_enabled = crc32_clmul_check ();
+  }
+#endif
+  for (i = 0; i < threads; i++) {
+    J[i].data = data;
+    J[i].len = len;
+    J[i].chunk_size = chunk_size;
+    J[i].chunks = chunks;
+    J[i].threads = threads;
+    J[i].thread_id = i;
+    J[i].crc = crc;
+    J[i].res = res;
+  }
+  /* the calling thread takes the first share, failed pthread_create is not fatal */
+  for (i = 1; i < threads; i++) {
+    started[i] = !pthread_create (&T[i], NULL, crc32_parallel_thread, &J[i]);
+    if (!started[i]) {
+      crc32_parallel_thread (&J[i]);
+    }
+  }
+  crc32_parallel_thread (&J[0]);
+  for (i = 1; i < threads; i++) {
+    if (started[i]) {
+      pthread_join (T[i], NULL);
+    }
+  }
+  crc = res[0];
+  for (i = 1; i < chunks; i++) {
+    long long off = (long long) i * chunk_size;
+    crc = compute_crc32_combine (crc, res[i], (len - off < chunk_size) ? (int) (len - off) : chunk_size);
+  }
+  free (res);
+  return crc ^ -1;
+}
+
+unsigned compute_crc32_parallel (const void *data, long long len) {
+  return crc32_partial_parallel (data, len, -1) ^ -1;
+}
+
 unsigned long long crc64_table[256] = {
  0x0000000000000000LL, 0xb32e4cbe03a75f6fLL, 0xf4843657a840a05bLL, 0x47aa7ae9abe7ff34LL,
  0x7bd0c384ff8f5e33LL, 0xc8fe8f3afc28015cLL, 0x8f54f5d357cffe68LL, 0x3c7ab96d5468a107LL,
@@ -34,6 +34,10 @@ unsigned crc32_partial (const void *data, int len, unsigned crc);
   //unsigned crc32_partial_fastest (const void *data, int len, unsigned crc);
 unsigned compute_crc32 (const void *data, int len);
 unsigned compute_crc32_combine (unsigned crc1, unsigned crc2, int len2);
+/* splits large buffers between several threads and combines partial results,
+   buffers shorter than a few megabytes are processed in the calling thread */
+unsigned crc32_partial_parallel (const void *data, long long len, unsigned crc);
+unsigned compute_crc32_parallel (const void *data, long long len);
 
 extern unsigned long long crc64_table[256];
 unsigned long long crc64_partial (const void *data, int len, unsigned long long crc);
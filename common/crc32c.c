@@ -24,6 +24,8 @@
 #include <math.h>
 #include <assert.h>
 #include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "crc32c.h"
 #include "server-functions.h"
@@ -470,6 +472,104 @@ unsigned compute_crc32c_combine (unsigned crc1, unsigned crc2, int len2) {
   return crc1 ^ crc2;
 }
 
+/******************** multithreaded crc32c ********************/
+
+#define CRC32C_PARALLEL_MIN_CHUNK (1 << 22)
+#define CRC32C_PARALLEL_MAX_CHUNK (1 << 30)
+#define CRC32C_PARALLEL_MAX_THREADS 8
+
+struct crc32c_parallel_job {
+  const char *data;
+  long long len;
+  int chunk_size;
+  int chunks;
+  int threads;
+  int thread_id;
+  unsigned crc;
+  unsigned *res;
+};
+
+static void *crc32c_parallel_thread (void *arg) {
+  struct crc32c_parallel_job *J = arg;
+  int i;
+  for (i = J->thread_id; i < J->chunks; i += J->threads) {
+    long long off = (long long) i * J->chunk_size;
+    int l = (J->len - off < J->chunk_size) ? (int) (J->len - off) : J->chunk_size;
+    J->res[i] = crc32c_partial (J->data + off, l, i ? -1 : J->crc) ^ -1;
+  }
+  return NULL;
+}
+
+static int crc32c_parallel_threads (void) {
+  static int threads = 0;
+  if (!threads) {
+    long n = sysconf (_SC_NPROCESSORS_ONLN);
+    threads = (n < 1) ? 1 : (n > CRC32C_PARALLEL_MAX_THREADS) ? CRC32C_PARALLEL_MAX_THREADS : n;
+  }
+  return threads;
+}
+
+unsigned crc32c_partial_parallel (const void *data, long long len, unsigned crc) {
+  int threads = crc32c_parallel_threads ();
+  if (len < 2 * CRC32C_PARALLEL_MIN_CHUNK || threads <= 1) {
+    while (len > CRC32C_PARALLEL_MAX_CHUNK) {
+      crc = crc32c_partial (data, CRC32C_PARALLEL_MAX_CHUNK, crc);
+      data = (const char *) data + CRC32C_PARALLEL_MAX_CHUNK;
+      len -= CRC32C_PARALLEL_MAX_CHUNK;
+    }
+    return crc32c_partial (data, len, crc);
+  }
+  if (threads > len / CRC32C_PARALLEL_MIN_CHUNK) {
+    threads = len / CRC32C_PARALLEL_MIN_CHUNK;
+  }
+  long long chunk_size = (len + threads - 1) / threads;
+  chunk_size = (chunk_size + 63) & -64;
+  if (chunk_size > CRC32C_PARALLEL_MAX_CHUNK) {
+    chunk_size = CRC32C_PARALLEL_MAX_CHUNK;
+  }
+  int i, chunks = (len + chunk_size - 1) / chunk_size;
+  unsigned *res = malloc (chunks * sizeof (unsigned));
+  assert (res);
+  struct crc32c_parallel_job J[CRC32C_PARALLEL_MAX_THREADS];
+  pthread_t T[CRC32C_PARALLEL_MAX_THREADS];
+  int started[CRC32C_PARALLEL_MAX_THREADS];
+  /* resolve cpuid dispatch before threads start */
+  crc32c_partial (data, 0, 0);
+  for (i = 0; i < threads; i++) {
+    J[i].data = data;
+    J[i].len = len;
+    J[i].chunk_size = chunk_size;
+    J[i].chunks = chunks;
+    J[i].threads = threads;
+    J[i].thread_id = i;
+    J[i].crc = crc;
+    J[i].res = res;
+  }
+  for (i = 1; i < threads; i++) {
+    started[i] = !pthread_create (&T[i], NULL, crc32c_parallel_thread, &J[i]);
+    if (!started[i]) {
+      crc32c_parallel_thread (&J[i]);
+    }
+  }
+  crc32c_parallel_thread (&J[0]);
+  for (i = 1; i < threads; i++) {
+    if (started[i]) {
+      pthread_join (T[i], NULL);
+    }
+  }
+  crc = res[0];
+  for (i = 1; i < chunks; i++) {
+    long long off = (long long) i * chunk_size;
+    crc = compute_crc32c_combine (crc, res[i], (len - off < chunk_size) ? (int) (len - off) : chunk_size);
+  }
+  free (res);
+  return crc ^ -1;
+}
+
+unsigned compute_crc32c_parallel (const void *data, long long len) {
+  return crc32c_partial_parallel (data, len, -1) ^ -1;
+}
+
 
 /********************************* crc32c repair ************************/
 struct fcb_table_entry {
@@ -31,6 +31,9 @@ extern "C" {
 unsigned (*crc32c_partial) (const void *data, int len, unsigned crc);
 unsigned compute_crc32c (const void *data, int len);
 unsigned compute_crc32c_combine (unsigned crc1, unsigned crc2, int len2);
+/* same as crc32_partial_parallel, partial results are combined with compute_crc32c_combine */
+unsigned crc32c_partial_parallel (const void *data, long long len, unsigned crc);
+unsigned compute_crc32c_parallel (const void *data, long long len);
 
 unsigned crc32c_slow (unsigned crc, const void *data, int len);
 
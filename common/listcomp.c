@@ -21,13 +21,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <emmintrin.h>
 #include "kdb-data-common.h"
 #include "listcomp.h"
 
 /* hiword: major version, loword: minor version */
 /* major version: different compression format */
 /* minor version: different compression algorithm implementation (optimization, etc.) */
-const int listcomp_version = 0x0000000c;
+const int listcomp_version = 0x0000000e;
 
 #define unlikely(x) __builtin_expect((x),0)
 #define	decode_cur_bit (m < 0)
@@ -307,6 +308,10 @@ const char* list_get_compression_method_description (int compression_method) {
     return "Interpolative_ext";
   case le_llrun:
     return "LLRUN";
+  case le_block_packed:
+    return "Block_packed";
+  case le_golomb_skip:
+    return "Golomb_skip";
   default:
     return "Unknown";
   }
@@ -760,20 +765,7 @@ static void golomb_encoder_init (struct list_encoder *enc) {
   enc->encode_int = &golomb_encode_int;
 }
 
-static int golomb_decode_int_small_k (struct list_decoder *dec) {
-  struct bitreader *br = &dec->br;
-  register int m = br->m;
-  int a = dec->last;
-  while (decode_cur_bit) {
-    a += dec->M;
-    decode_load_bit();
-  }
-  decode_load_bit();
-  br->m = m;
-  return dec->last = a + 1;
-}
-
-static int golomb_decode_int_big_k (struct list_decoder *dec) {
+static inline int golomb_decode_value (struct list_decoder *dec, int k) {
   struct bitreader *br = &dec->br;
   register int m = br->m;
   int d = 0, a = dec->last;
@@ -782,26 +774,36 @@ static int golomb_decode_int_big_k (struct list_decoder *dec) {
     decode_load_bit();
   }
   decode_load_bit();
-  int i = dec->k;
-  do {
-    d <<= 1;
-    if (decode_cur_bit) {
-      d++;
-    }
-    decode_load_bit();
-  } while (--i > 1);
-  if (d >= dec->p) {
-    d <<= 1;
-    if (decode_cur_bit) {
-      d++;
+  if (k > 1) {
+    int i = k;
+    do {
+      d <<= 1;
+      if (decode_cur_bit) {
+        d++;
+      }
+      decode_load_bit();
+    } while (--i > 1);
+    if (d >= dec->p) {
+      d <<= 1;
+      if (decode_cur_bit) {
+        d++;
+      }
+      decode_load_bit();
+      d -= dec->p;
     }
-    decode_load_bit();
-    d -= dec->p;
   }
   br->m = m;
   return dec->last = a + d + 1;
 }
 
+static int golomb_decode_int_small_k (struct list_decoder *dec) {
+  return golomb_decode_value (dec, 1);
+}
+
+static int golomb_decode_int_big_k (struct list_decoder *dec) {
+  return golomb_decode_value (dec, dec->k);
+}
+
 static void golomb_decoder_init (struct list_decoder *dec) {
   const int M = compute_golomb_parameter (dec->N, dec->K);
   dec->M = M;
@@ -810,6 +812,97 @@ static void golomb_decoder_init (struct list_decoder *dec) {
   dec->decode_int = dec->k > 1 ? &golomb_decode_int_big_k : &golomb_decode_int_small_k;
 }
 
+/******************** Golomb codes with skip table ********************/
+/* Byte aligned, starts with skip table of (K - 1) / LIST_BLOCK_SIZE entries (8 bytes each),
+   entry i: value L[(i + 1) * LIST_BLOCK_SIZE - 1] (4 bytes) and bit offset of the next value
+   relative to the start of Golomb codes (4 bytes), then usual Golomb codes of all values.
+   Decoder keeps Golomb k in dec->data[0], dec->k is the number of decoded values. */
+
+static void golomb_skip_encoder_init (struct list_encoder *enc) {
+  enc->L = malloc (enc->K * sizeof (enc->L[0]));
+  enc->k = 0;
+  enc->encode_int = &store_int;
+}
+
+static void golomb_skip_encoder_finish (struct list_encoder *enc) {
+  struct bitwriter *bw = &enc->bw;
+  assert (enc->k == enc->K);
+  int *L = enc->L, i;
+  const int skips = (enc->K - 1) / LIST_BLOCK_SIZE;
+  unsigned char *q = bw->m == 0x80 ? bw->ptr : bw->ptr + 1;
+  assert (q + 8 * skips < bw->end_ptr);
+  bw->ptr = q + 8 * skips - 1;
+  bw->m = 0;
+  const unsigned int base = bwrite_get_bits_written (bw);
+  golomb_encoder_init (enc);
+  for (i = 0; i < enc->K; i++) {
+    if (i && !(i & (LIST_BLOCK_SIZE - 1))) {
+      const unsigned int o = bwrite_get_bits_written (bw) - base;
+      memcpy (q, &L[i-1], 4);
+      memcpy (q + 4, &o, 4);
+      q += 8;
+    }
+    golomb_encode_int (enc, L[i]);
+  }
+  free (L);
+}
+
+static inline const unsigned char *golomb_skip_table (struct list_decoder *dec) {
+  return dec->br.start_ptr + ((dec->br.prefix_bit_offset + 7) >> 3);
+}
+
+static inline int golomb_skip_entry (const unsigned char *t, int i, int j) {
+  int x;
+  memcpy (&x, t + 8 * i + 4 * j, 4);
+  return x;
+}
+
+static int golomb_skip_decode_int (struct list_decoder *dec) {
+  dec->k++;
+  return golomb_decode_value (dec, dec->data[0]);
+}
+
+static void golomb_skip_decoder_init (struct list_decoder *dec) {
+  golomb_decoder_init (dec);
+  dec->data[0] = dec->k;
+  dec->k = 0;
+  dec->decode_int = &golomb_skip_decode_int;
+  bread_seek (&dec->br, (golomb_skip_table (dec) - dec->br.start_ptr + 8 * ((dec->K - 1) / LIST_BLOCK_SIZE)) << 3);
+}
+
+int list_golomb_skip_forward_decode_idx (struct list_decoder *dec, int doc_id_lowerbound) {
+  assert (dec->tp == le_golomb_skip);
+  const int skips = (dec->K - 1) / LIST_BLOCK_SIZE;
+  const unsigned char *t = golomb_skip_table (dec);
+  int a = dec->k / LIST_BLOCK_SIZE;
+  if (a < skips && golomb_skip_entry (t, a, 0) < doc_id_lowerbound) {
+    /* galloping search of the last skip entry with value < doc_id_lowerbound */
+    int b = a + 1, step = 1;
+    while (b < skips && golomb_skip_entry (t, b, 0) < doc_id_lowerbound) {
+      a = b;
+      step <<= 1;
+      b = a + step;
+    }
+    if (b > skips) {
+      b = skips;
+    }
+    while (b - a > 1) {
+      const int c = (a + b) >> 1;
+      if (golomb_skip_entry (t, c, 0) < doc_id_lowerbound) { a = c; } else { b = c; }
+    }
+    dec->k = (a + 1) * LIST_BLOCK_SIZE;
+    dec->last = golomb_skip_entry (t, a, 0);
+    bread_seek (&dec->br, ((t - dec->br.start_ptr + 8 * skips) << 3) + golomb_skip_entry (t, a, 1));
+  }
+  while (dec->k < dec->K) {
+    const int x = golomb_skip_decode_int (dec);
+    if (x >= doc_id_lowerbound) {
+      return x;
+    }
+  }
+  return 0x7fffffff;
+}
+
 /******************** Interpolative codes ********************/
 
 struct interpolative_decoder_stack_entry {
@@ -1166,6 +1259,211 @@ int list_interpolative_ext_forward_decode_idx (struct list_decoder *dec, int doc
   return -1;
 }
 */
+/******************** Block packed (SIMD-BP128 like) ********************/
+/* Byte aligned, d-gaps minus one are packed with the same bit width b in blocks of LIST_BLOCK_SIZE values.
+   Full block: b (1 byte), last value of the block (4 bytes, used for skipping),
+               then 16 * b bytes: value 4*k+j is k-th value of 32-bit lane j (vertical layout, unpacked by SSE2).
+   Last partial block (K % LIST_BLOCK_SIZE values): b (1 byte), then values packed LSB first in ceil(n * b / 8) bytes.
+   Decoder keeps current decoded block in dec->data, br.ptr - 1 points to the next block. */
+
+static void block_packed_encoder_init (struct list_encoder *enc) {
+  enc->L = malloc (enc->K * sizeof (enc->L[0]));
+  enc->k = 0;
+  enc->encode_int = &store_int;
+}
+
+static unsigned char *block_packed_encode_block (unsigned char *q, const int *L, int n, int last) {
+  int g[LIST_BLOCK_SIZE], i, b = 0;
+  unsigned m = 0;
+  for (i = 0; i < n; i++) {
+    g[i] = L[i] - last - 1;
+    assert (g[i] >= 0);
+    last = L[i];
+    m |= g[i];
+  }
+  if (m) {
+    b = bsr (m) + 1;
+  }
+  *q++ = b;
+  if (n == LIST_BLOCK_SIZE) {
+    memcpy (q, &last, 4);
+    q += 4;
+    int j, k;
+    for (j = 0; j < 4; j++) {
+      unsigned long long acc = 0;
+      int bits = 0, t = 0;
+      for (k = 0; k < 32; k++) {
+        acc |= (unsigned long long) g[4 * k + j] << bits;
+        bits += b;
+        if (bits >= 32) {
+          unsigned w = acc;
+          memcpy (q + 16 * t + 4 * j, &w, 4);
+          t++;
+          acc >>= 32;
+          bits -= 32;
+        }
+      }
+      assert (t == b && !bits);
+    }
+    return q + 16 * b;
+  }
+  unsigned long long acc = 0;
+  int bits = 0;
+  for (i = 0; i < n; i++) {
+    acc |= (unsigned long long) g[i] << bits;
+    for (bits += b; bits >= 8; bits -= 8) {
+      *q++ = acc;
+      acc >>= 8;
+    }
+  }
+  if (bits) {
+    *q++ = acc;
+  }
+  return q;
+}
+
+static void block_packed_encoder_finish (struct list_encoder *enc) {
+  struct bitwriter *bw = &enc->bw;
+  assert (enc->k == enc->K);
+  unsigned char *q = bw->m == 0x80 ? bw->ptr : bw->ptr + 1, *s = q;
+  int i, last = -1;
+  for (i = 0; i < enc->K; i += LIST_BLOCK_SIZE) {
+    const int n = enc->K - i < LIST_BLOCK_SIZE ? enc->K - i : LIST_BLOCK_SIZE;
+    assert (q + 5 + 4 * n <= bw->end_ptr);
+    q = block_packed_encode_block (q, enc->L + i, n, last);
+    last = enc->L[i + n - 1];
+  }
+  if (q > s) {
+    bw->ptr = q - 1;
+    bw->m = 0;
+  }
+  free (enc->L);
+}
+
+static void block_packed_decode_block (struct list_decoder *dec) {
+  const unsigned char *q = dec->br.ptr - 1;
+  const int n = dec->K - dec->k < LIST_BLOCK_SIZE ? dec->K - dec->k : LIST_BLOCK_SIZE;
+  const int b = *q++;
+  int *out = dec->data, last = dec->last, i;
+  assert (n > 0 && b <= 31);
+  if (n == LIST_BLOCK_SIZE) {
+    q += 4;
+    const __m128i mask = _mm_set1_epi32 ((1U << b) - 1), one = _mm_set1_epi32 (1);
+    const __m128i *I = (const __m128i *) q;
+    __m128i w = b ? _mm_loadu_si128 (I++) : _mm_setzero_si128 (), run = _mm_set1_epi32 (last);
+    int shift = 0, k;
+    for (k = 0; k < 32; k++) {
+      __m128i v = _mm_srl_epi32 (w, _mm_cvtsi32_si128 (shift));
+      shift += b;
+      if (shift >= 32) {
+        shift -= 32;
+        if (k < 31) {
+          w = _mm_loadu_si128 (I++);
+        }
+        if (shift) {
+          v = _mm_or_si128 (v, _mm_sll_epi32 (w, _mm_cvtsi32_si128 (b - shift)));
+        }
+      }
+      /* prefix sums of (gap + 1) inside the 4 values, then add the last value of the previous 4 */
+      v = _mm_add_epi32 (_mm_and_si128 (v, mask), one);
+      v = _mm_add_epi32 (v, _mm_slli_si128 (v, 4));
+      v = _mm_add_epi32 (v, _mm_slli_si128 (v, 8));
+      run = _mm_add_epi32 (v, run);
+      _mm_storeu_si128 ((__m128i *) (out + 4 * k), run);
+      run = _mm_shuffle_epi32 (run, 0xff);
+    }
+    q += 16 * b;
+  } else {
+    const unsigned mask = (1U << b) - 1;
+    unsigned long long acc = 0;
+    int bits = 0;
+    for (i = 0; i < n; i++) {
+      while (bits < b) {
+        acc |= (unsigned long long) *q++ << bits;
+        bits += 8;
+      }
+      last += (acc & mask) + 1;
+      out[i] = last;
+      acc >>= b;
+      bits -= b;
+    }
+  }
+  dec->last = out[n - 1];
+  dec->p = 0;
+  dec->M = n;
+  dec->br.ptr = q + 1;
+}
+
+static int block_packed_decode_int (struct list_decoder *dec) {
+  if (dec->p >= dec->M) {
+    if (dec->k >= dec->K) {
+      return 0x7fffffff;
+    }
+    block_packed_decode_block (dec);
+  }
+  dec->k++;
+  return dec->data[dec->p++];
+}
+
+static void block_packed_decoder_init (struct list_decoder *dec) {
+  const unsigned char *q = dec->br.start_ptr + ((dec->br.prefix_bit_offset + 7) >> 3);
+  dec->br.ptr = q + 1;
+  dec->br.m = 1 << 23;
+  dec->k = dec->p = dec->M = 0;
+  dec->last = -1;
+  dec->decode_int = &block_packed_decode_int;
+}
+
+int list_block_packed_decode_block (struct list_decoder *dec, const int **values) {
+  assert (dec->tp == le_block_packed);
+  if (dec->p >= dec->M) {
+    if (dec->k >= dec->K) {
+      return 0;
+    }
+    block_packed_decode_block (dec);
+  }
+  const int n = dec->M - dec->p;
+  *values = dec->data + dec->p;
+  dec->p = dec->M;
+  dec->k += n;
+  return n;
+}
+
+int list_block_packed_forward_decode_idx (struct list_decoder *dec, int doc_id_lowerbound) {
+  assert (dec->tp == le_block_packed);
+  while (1) {
+    if (dec->p < dec->M && dec->data[dec->M - 1] >= doc_id_lowerbound) {
+      int a = dec->p - 1, b = dec->M - 1;
+      while (b - a > 1) {
+        const int c = (a + b) >> 1;
+        if (dec->data[c] >= doc_id_lowerbound) { b = c; } else { a = c; }
+      }
+      dec->k += b + 1 - dec->p;
+      dec->p = b + 1;
+      return dec->data[b];
+    }
+    dec->k += dec->M - dec->p;
+    dec->p = dec->M;
+    /* skip full blocks using last values from their headers */
+    const unsigned char *q = dec->br.ptr - 1;
+    while (dec->K - dec->k >= LIST_BLOCK_SIZE) {
+      int last;
+      memcpy (&last, q + 1, 4);
+      if (last >= doc_id_lowerbound) {
+        break;
+      }
+      dec->last = last;
+      dec->k += LIST_BLOCK_SIZE;
+      q += 5 + 16 * q[0];
+    }
+    dec->br.ptr = q + 1;
+    if (dec->k >= dec->K) {
+      return 0x7fffffff;
+    }
+    block_packed_decode_block (dec);
+  }
+}
+
 /******************** List encoder/decoder ********************/
 int inline list_too_short_for_llrun (int N, int K) {
   return (K <= 80); /* huffman tree is more than 5% list data  */
@@ -1197,6 +1495,12 @@ void list_encoder_init (struct list_encoder *enc, int N, int K, unsigned char *p
       llrun_encoder_init (enc);
     }
     return;
+  case le_block_packed:
+    block_packed_encoder_init (enc);
+    return;
+  case le_golomb_skip:
+    golomb_skip_encoder_init (enc);
+    return;
   default:
     assert (0);
   }
@@ -1232,6 +1536,12 @@ static void list_decoder_init (struct list_decoder *dec, int N, int K, const uns
   case le_raw_int32:
     raw_int32_decoder_init (dec);
     break;
+  case le_block_packed:
+    block_packed_decoder_init (dec);
+    break;
+  case le_golomb_skip:
+    golomb_skip_decoder_init (dec);
+    break;
   default:
     assert (0);
   }
@@ -1258,6 +1568,12 @@ struct list_decoder *zmalloc_list_decoder (int N, int K, const unsigned char *st
     break;
   case le_raw_int32:
     break;
+  case le_block_packed:
+    sz += LIST_BLOCK_SIZE * sizeof (int);
+    break;
+  case le_golomb_skip:
+    sz += sizeof (int);
+    break;
   }
   struct list_decoder *dec = zmalloc (sz);
   dec->p = p;
@@ -1321,6 +1637,12 @@ void list_encoder_finish (struct list_encoder *enc) {
   case le_llrun:
     llrun_encoder_finish (enc);
     break;
+  case le_block_packed:
+    block_packed_encoder_finish (enc);
+    break;
+  case le_golomb_skip:
+    golomb_skip_encoder_finish (enc);
+    break;
   default:
     assert (0);
   }
@@ -30,9 +30,14 @@ enum list_coding_type {
   le_llrun = 1,
   le_interpolative = 2,
   le_interpolative_ext = 3,
-  le_raw_int32 = 4
+  le_raw_int32 = 4,
+  le_block_packed = 5,
+  le_golomb_skip = 6
 };
 
+/* number of values in one block of le_block_packed list (also skip table step of le_golomb_skip list) */
+#define LIST_BLOCK_SIZE 128
+
 struct bitwriter {
   unsigned char *ptr;
   unsigned char *start_ptr;
@@ -118,6 +123,14 @@ struct interpolative_ext_decoder_stack_entry {
 void interpolative_ext_decode_node (struct list_decoder *dec, struct interpolative_ext_decoder_stack_entry *data);
 int list_interpolative_ext_forward_decode_idx (struct list_decoder *dec, int doc_id_lowerbound);
 
+/* le_block_packed: returns number of decoded values of the current block (0 at the end of list) and pointer to them in *values,
+   returned values are consumed */
+int list_block_packed_decode_block (struct list_decoder *dec, const int **values);
+/* le_block_packed: skips blocks by their headers, returns first value >= doc_id_lowerbound or 0x7fffffff */
+int list_block_packed_forward_decode_idx (struct list_decoder *dec, int doc_id_lowerbound);
+/* le_golomb_skip: gallops over stored skip table, returns first value >= doc_id_lowerbound or 0x7fffffff */
+int list_golomb_skip_forward_decode_idx (struct list_decoder *dec, int doc_id_lowerbound);
+
 const char* list_get_compression_method_description (int compression_method);
 
 #define HUFFMAN_MAX_CODE_LENGTH 15
@@ -59,6 +59,15 @@ int memcache_auto_answer_mode __attribute__ ((weak));
 long long max_binlog_size __attribute__ ((weak));
 long long dynamic_data_buffer_size __attribute__ ((weak)); 
 double udp_drop_probability __attribute__ ((weak));
+int aio_uring_enabled __attribute__ ((weak));
+int conn_write_batching __attribute__ ((weak));
+int conn_zerocopy_threshold __attribute__ ((weak));
+int binlog_group_commit __attribute__ ((weak));
+double binlog_commit_delay __attribute__ ((weak));
+int binlog_commit_bytes __attribute__ ((weak));
+int kfs_no_mmap __attribute__ ((weak));
+int binlog_prefetch __attribute__ ((weak));
+int kfs_no_fadvise __attribute__ ((weak));
 int keyring_enabled;
 
 int quit_steps, start_time;
@@ -361,6 +370,14 @@ struct option global_longopts[10000] = {
   { "heap", required_argument, 0, 204},
   { "udp-drop-probability", required_argument, 0, 205},
   { "keyring", no_argument, 0, 206},
+  { "aio-uring", no_argument, 0, 207},
+  { "batch-writes", no_argument, 0, 208},
+  { "zerocopy-threshold", required_argument, 0, 209},
+  { "group-commit", optional_argument, 0, 210},
+  { "group-commit-bytes", required_argument, 0, 211},
+  { "no-mmap-index", no_argument, 0, 212},
+  { "prefetch-binlog", no_argument, 0, 213},
+  { "no-page-cache-hints", no_argument, 0, 214},
 };
 
 char *global_longopts_help[10000] = {
@@ -383,6 +400,14 @@ char *global_longopts_help[10000] = {
   "sets zmalloc heap size",
   NULL,
   "reads keyring from stdin for binlog/snapshot encryption",
+  "uses io_uring instead of POSIX aio for disk reads (falls back if unsupported)",
+  "coalesces all output queued to a connection during one event loop iteration into one writev()",
+  "sends rpc writes of at least <arg> bytes with MSG_ZEROCOPY (default 0 = never)",
+  "group commit: answers to updates are sent after write()+fdatasync() of a batch of binlog events;\nbatch waits at most {arg} milliseconds (default 0 = one event loop iteration)",
+  "group commit: commits batch as soon as it has <arg> binlog bytes (default 1m)",
+  "reads immutable index sections into memory instead of mapping snapshot file",
+  "replica mode: background thread tails binlog (inotify) and prefetches new events with their crc32",
+  "disables posix_fadvise hints (sequential binlog replay with dropping replayed pages, random snapshot reads)",
 };
 
 char global_optstring[20000] = "";
@@ -702,6 +727,41 @@ int parse_engine_options_long (int argc, char **argv,  int (*execute)(int val))
       case 206:
         keyring_enabled = 1;
         break;
+      case 207:
+        aio_uring_enabled = 1;
+        break;
+      case 208:
+        conn_write_batching = 1;
+        break;
+      case 209:
+        conn_zerocopy_threshold = atoi (optarg);
+        break;
+      case 210:
+        binlog_group_commit = 1;
+        if (optarg) {
+          binlog_commit_delay = atof (optarg) * 0.001;
+          if (binlog_commit_delay < 0 || binlog_commit_delay > 1) {
+            kprintf ("group commit delay must be between 0 and 1000 ms\n");
+            usage ();
+            exit (2);
+          }
+        }
+        break;
+      case 211:
+        x = parse_memory_limit (optarg);
+        if (x >= 512 && x <= (1LL << 30)) {
+          binlog_commit_bytes = x;
+        }
+        break;
+      case 212:
+        kfs_no_mmap = 1;
+        break;
+      case 213:
+        binlog_prefetch = 1;
+        break;
+      case 214:
+        kfs_no_fadvise = 1;
+        break;
       default:
         if (execute (c) < 0) {
           printf ("Unknown option c = %d\n", c);
@@ -850,6 +910,17 @@ vk_cpuid_t *vk_cpuid (void) {
         : "=a" (a), "=b" (cached.ebx) , "=c" (cached.ecx), "=d" (cached.edx)
         : "0" (1)
     );
+    int b, c, d;
+    asm ("cpuid\n\t"
+        : "=a" (a), "=b" (b), "=c" (c), "=d" (d)
+        : "0" (0)
+    );
+    if (a >= 7) {
+      asm ("cpuid\n\t"
+          : "=a" (a), "=b" (cached.ebx7), "=c" (cached.ecx7), "=d" (d)
+          : "0" (7), "2" (0)
+      );
+    }
   }
   return &cached;
 }
@@ -106,6 +106,8 @@ static __inline__ unsigned long long rdtsc(void) {
 
 typedef struct {
   int ebx, ecx, edx, computed;
+  int ebx7;	/* cpuid leaf 7 extended features (bit 5 = AVX2, bit 16 = AVX-512F) */
+  int ecx7;	/* cpuid leaf 7 extended features (bit 9 = VAES) */
 } vk_cpuid_t;
 vk_cpuid_t *vk_cpuid (void);
 
@@ -193,6 +193,7 @@ int copyexec_results_prepare_stats (struct connection *c) {
     alloc_tree_nodes,
     free_tree_nodes,
     FullVersionStr);
+  sb.pos += binlog_group_commit_stats (sb.buff + sb.pos, sb.size - sb.pos);
   return sb.pos;
 }
 
@@ -413,6 +414,10 @@ int rpc_execute_send_data (struct connection *c, struct copyexec_rpc_send_data *
     return -__LINE__;
   }
   E->binlog_pos = P->binlog_pos;
+  /* with group commit, copyexec-engine gets VALUE_POS only after the result is on disk */
+  if (binlog_group_commit) {
+    binlog_commit_request (release_connection_output, c, hold_connection_output (c));
+  }
   return rpc_send_query (Q, c);
 }
 
@@ -558,7 +563,7 @@ void start_server (void) {
       vkprintf (1, "epoll_work(): %d out of %d connections, network buffers: %d used, %d out of %d allocated\n",
 	       active_connections, maxconn, NB_used, NB_alloc, NB_max);
     }
-    epoll_work (71);
+    epoll_work (binlog_commit_pending () ? 1 : 71);
 
     if (interrupted_by_term_signal ()) {
       break;
@@ -581,6 +586,9 @@ void start_server (void) {
       prev_time = now;
       cron ();
     }
+
+    binlog_group_commit_work ();
+
     if (quit_steps && !--quit_steps) break;
   }
 
@@ -624,9 +632,10 @@ static void copyexec_results_make_empty_binlog (const char *binlog_name) {
 
 void usage (void) {
   printf ("%s\n", FullVersionStr);
-  printf ("usage: [-v] [-p<port>] [-u<username>] [-M<max-memory-transactions>] [-b<backlog>] [-c<max-conn>] [-a<binlog-name>] [-l<log-name>] [-E] <binlog>\n"
+  printf ("usage: [-v] [-p<port>] [-u<username>] [-M<max-memory-transactions>] [-b<backlog>] [-c<max-conn>] [-a<binlog-name>] [-l<log-name>] [-D<max-delay-ms>] [-E] <binlog>\n"
 	  "\tCollects transactions results from copyexec-engine.\n"
     "\t-E\tcreate copyexec-results empty binlog\n"
+    "\t-D<max-delay-ms>\tgroup commit: acknowledge results only after binlog fdatasync(), waiting at most <max-delay-ms> to batch them\n"
     "\t-M<max-memory-transactions>\tlimit memory transaction number (default value is %d).\n"
     "\t-v\toutput statistical and debug information into stderr\n", max_lru_size);
   exit (2);
@@ -638,8 +647,15 @@ int main (int argc, char *argv[]) {
   set_debug_handlers ();
 
   progname = argv[0];
-  while ((i = getopt (argc, argv, "a:b:c:l:p:dhu:vEM:")) != -1) {
+  while ((i = getopt (argc, argv, "a:b:c:l:p:dhu:vD:EM:")) != -1) {
     switch (i) {
+    case 'D':
+      binlog_group_commit = 1;
+      binlog_commit_delay = atof (optarg) * 0.001;
+      if (binlog_commit_delay < 0 || binlog_commit_delay > 1) {
+        usage ();
+      }
+      break;
     case 'E':
       new_binlog = 1;
       break;
@@ -20,6 +20,7 @@
 
 #include "crypto/aesni256.h"
 #include <stdint.h>
+#include <immintrin.h>
 #include "server-functions.h"
 
 static void *align16 (void *ptr) {
@@ -31,6 +32,17 @@ static int aesni256_is_supported (void) {
   return (p->ecx & (1 << 25)) && ((p->edx & 0x06000000) == 0x06000000);
 }
 
+static int vaes_is_supported (void) {
+  vk_cpuid_t *p = vk_cpuid ();
+  /* VAES and AVX-512F in leaf 7, OSXSAVE in leaf 1, and the OS must save zmm state (XCR0 bits 1-2 and 5-7) */
+  if (!(p->ecx7 & (1 << 9)) || !(p->ebx7 & (1 << 16)) || !(p->ecx & (1 << 27))) {
+    return 0;
+  }
+  unsigned lo, hi;
+  asm ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+  return (lo & 0xe6) == 0xe6;
+}
+
 static void aesni256_set_encrypt_key (struct aesni256_ctx *ctx, unsigned char key[32]) {
   int a, b;
   unsigned int *c, *d;
@@ -216,48 +228,51 @@ static void aesni256_cbc_encrypt (struct aesni256_ctx *ctx, const unsigned char
   );
 }
 
-static void aesni256_cbc_decrypt (struct aesni256_ctx *ctx, const unsigned char *in, unsigned char *out, int size, unsigned char iv[16]) {
-  void *p1, *p2;
-  if (size < 16) {
-    return;
+/* CBC decryption of different blocks is independent, so 8 blocks are decrypted at once */
+#define AES_ROUND8(op, k) \
+  b0 = op (b0, k); b1 = op (b1, k); b2 = op (b2, k); b3 = op (b3, k); \
+  b4 = op (b4, k); b5 = op (b5, k); b6 = op (b6, k); b7 = op (b7, k)
+
+#define AES_LOAD_KEYS(k, a) \
+  for (r = 0; r < 15; r++) { \
+    k[r] = _mm_load_si128 ((const __m128i *) ((a) + 16 * r)); \
   }
-  asm volatile (
-      "movdqu (%5), %%xmm1\n\t"
-      "1:\n\t"
-      "subl $0x10, %3\n\t"
-      "movdqu (%4), %%xmm2\n\t"
-      "pxor 0xe0(%6), %%xmm2\n\t"
-      "aesdec 0xd0(%6), %%xmm2\n\t"
-      "aesdec 0xc0(%6), %%xmm2\n\t"
-      "aesdec 0xb0(%6), %%xmm2\n\t"
-      "aesdec 0xa0(%6), %%xmm2\n\t"
-      "aesdec 0x90(%6), %%xmm2\n\t"
-      "aesdec 0x80(%6), %%xmm2\n\t"
-      "aesdec 0x70(%6), %%xmm2\n\t"
-      "aesdec 0x60(%6), %%xmm2\n\t"
-      "aesdec 0x50(%6), %%xmm2\n\t"
-      "aesdec 0x40(%6), %%xmm2\n\t"
-      "aesdec 0x30(%6), %%xmm2\n\t"
-      "aesdec 0x20(%6), %%xmm2\n\t"
-      "aesdec 0x10(%6), %%xmm2\n\t"
-      "aesdeclast 0x00(%6), %%xmm2\n\t"
-      "pxor %%xmm1, %%xmm2\n\t"
-      "movdqu (%4), %%xmm1\n\t"
-      "movdqu %%xmm2, (%7)\n\t"
-#ifdef __LP64__
-      "addq $0x10, %4\n\t"
-      "addq $0x10, %7\n\t"
-#else
-      "addl $0x10, %4\n\t"
-      "addl $0x10, %7\n\t"
-#endif
-      "cmpl $0x0f, %3\n\t"
-      "jg 1b\n\t"
-      "movdqu %%xmm1, (%5)\n\t"
-    : "=r" (size), "=r" (p1), "=r" (p2)
-    : "0" (size), "1r" (in), "r" (iv), "r" (align16 (ctx)), "2r" (out)
-    : "%xmm1", "%xmm2", "memory"
-  );
+
+static void __attribute__ ((target ("aes"))) aesni256_cbc_decrypt8 (struct aesni256_ctx *ctx, const unsigned char *in, unsigned char *out, int size, unsigned char iv[16]) {
+  const unsigned char *a = align16 (ctx);
+  const __m128i *I = (const __m128i *) in;
+  __m128i *O = (__m128i *) out;
+  __m128i k[15], prev = _mm_loadu_si128 ((const __m128i *) iv);
+  int n = size >> 4, r;
+  AES_LOAD_KEYS (k, a);
+  for (; n >= 8; n -= 8, I += 8, O += 8) {
+    __m128i c0 = _mm_loadu_si128 (I), c1 = _mm_loadu_si128 (I + 1), c2 = _mm_loadu_si128 (I + 2), c3 = _mm_loadu_si128 (I + 3);
+    __m128i c4 = _mm_loadu_si128 (I + 4), c5 = _mm_loadu_si128 (I + 5), c6 = _mm_loadu_si128 (I + 6), c7 = _mm_loadu_si128 (I + 7);
+    __m128i b0 = _mm_xor_si128 (c0, k[14]), b1 = _mm_xor_si128 (c1, k[14]), b2 = _mm_xor_si128 (c2, k[14]), b3 = _mm_xor_si128 (c3, k[14]);
+    __m128i b4 = _mm_xor_si128 (c4, k[14]), b5 = _mm_xor_si128 (c5, k[14]), b6 = _mm_xor_si128 (c6, k[14]), b7 = _mm_xor_si128 (c7, k[14]);
+    for (r = 13; r > 0; r--) {
+      AES_ROUND8 (_mm_aesdec_si128, k[r]);
+    }
+    AES_ROUND8 (_mm_aesdeclast_si128, k[0]);
+    _mm_storeu_si128 (O, _mm_xor_si128 (b0, prev));
+    _mm_storeu_si128 (O + 1, _mm_xor_si128 (b1, c0));
+    _mm_storeu_si128 (O + 2, _mm_xor_si128 (b2, c1));
+    _mm_storeu_si128 (O + 3, _mm_xor_si128 (b3, c2));
+    _mm_storeu_si128 (O + 4, _mm_xor_si128 (b4, c3));
+    _mm_storeu_si128 (O + 5, _mm_xor_si128 (b5, c4));
+    _mm_storeu_si128 (O + 6, _mm_xor_si128 (b6, c5));
+    _mm_storeu_si128 (O + 7, _mm_xor_si128 (b7, c6));
+    prev = c7;
+  }
+  for (; n > 0; n--, I++, O++) {
+    __m128i c = _mm_loadu_si128 (I), b = _mm_xor_si128 (c, k[14]);
+    for (r = 13; r > 0; r--) {
+      b = _mm_aesdec_si128 (b, k[r]);
+    }
+    _mm_storeu_si128 (O, _mm_xor_si128 (_mm_aesdeclast_si128 (b, k[0]), prev));
+    prev = c;
+  }
+  _mm_storeu_si128 ((__m128i *) iv, prev);
 }
 
 static void vk_aesni_cbc_encrypt (vk_aes_ctx_t *ctx, const unsigned char *in, unsigned char *out, int size, unsigned char iv[16]) {
@@ -265,7 +280,7 @@ static void vk_aesni_cbc_encrypt (vk_aes_ctx_t *ctx, const unsigned char *in, un
 }
 
 static void vk_aesni_cbc_decrypt (vk_aes_ctx_t *ctx, const unsigned char *in, unsigned char *out, int size, unsigned char iv[16]) {
-  aesni256_cbc_decrypt (&ctx->u.ctx, in, out, size, iv);
+  aesni256_cbc_decrypt8 (&ctx->u.ctx, in, out, size, iv);
 }
 
 static void vk_ssl_aes_cbc_encrypt (vk_aes_ctx_t *ctx, const unsigned char *in, unsigned char *out, int size, unsigned char iv[16]){
@@ -423,7 +438,75 @@ static void aesni256_encrypt (unsigned char *ctx, const unsigned char *in, unsig
   );
 }
 
-static void vk_aesni_ctr_crypt (vk_aes_ctx_t *ctx, const unsigned char *in, unsigned char *out, int size, unsigned char iv[16], unsigned long long offset) {
+/* n counter blocks: first 8 bytes from iv, last 8 bytes are little-endian counter starting from ctr */
+static void __attribute__ ((target ("aes"))) aesni256_ctr_blocks (const unsigned char *a, const unsigned char *in, unsigned char *out, int n, unsigned long long lo, unsigned long long ctr) {
+  const __m128i *I = (const __m128i *) in;
+  __m128i *O = (__m128i *) out;
+  __m128i k[15];
+  int r;
+  AES_LOAD_KEYS (k, a);
+  for (; n >= 8; n -= 8, ctr += 8, I += 8, O += 8) {
+    __m128i b0 = _mm_xor_si128 (_mm_set_epi64x (ctr, lo), k[0]), b1 = _mm_xor_si128 (_mm_set_epi64x (ctr + 1, lo), k[0]);
+    __m128i b2 = _mm_xor_si128 (_mm_set_epi64x (ctr + 2, lo), k[0]), b3 = _mm_xor_si128 (_mm_set_epi64x (ctr + 3, lo), k[0]);
+    __m128i b4 = _mm_xor_si128 (_mm_set_epi64x (ctr + 4, lo), k[0]), b5 = _mm_xor_si128 (_mm_set_epi64x (ctr + 5, lo), k[0]);
+    __m128i b6 = _mm_xor_si128 (_mm_set_epi64x (ctr + 6, lo), k[0]), b7 = _mm_xor_si128 (_mm_set_epi64x (ctr + 7, lo), k[0]);
+    for (r = 1; r < 14; r++) {
+      AES_ROUND8 (_mm_aesenc_si128, k[r]);
+    }
+    AES_ROUND8 (_mm_aesenclast_si128, k[14]);
+    _mm_storeu_si128 (O, _mm_xor_si128 (b0, _mm_loadu_si128 (I)));
+    _mm_storeu_si128 (O + 1, _mm_xor_si128 (b1, _mm_loadu_si128 (I + 1)));
+    _mm_storeu_si128 (O + 2, _mm_xor_si128 (b2, _mm_loadu_si128 (I + 2)));
+    _mm_storeu_si128 (O + 3, _mm_xor_si128 (b3, _mm_loadu_si128 (I + 3)));
+    _mm_storeu_si128 (O + 4, _mm_xor_si128 (b4, _mm_loadu_si128 (I + 4)));
+    _mm_storeu_si128 (O + 5, _mm_xor_si128 (b5, _mm_loadu_si128 (I + 5)));
+    _mm_storeu_si128 (O + 6, _mm_xor_si128 (b6, _mm_loadu_si128 (I + 6)));
+    _mm_storeu_si128 (O + 7, _mm_xor_si128 (b7, _mm_loadu_si128 (I + 7)));
+  }
+  for (; n > 0; n--, ctr++, I++, O++) {
+    __m128i b = _mm_xor_si128 (_mm_set_epi64x (ctr, lo), k[0]);
+    for (r = 1; r < 14; r++) {
+      b = _mm_aesenc_si128 (b, k[r]);
+    }
+    _mm_storeu_si128 (O, _mm_xor_si128 (_mm_aesenclast_si128 (b, k[14]), _mm_loadu_si128 (I)));
+  }
+}
+
+/* same with VAES: 16 blocks in 4 zmm registers per iteration, the rest is done by aesni256_ctr_blocks */
+static void __attribute__ ((target ("vaes,avx512f"))) aesni256_ctr_blocks_vaes (const unsigned char *a, const unsigned char *in, unsigned char *out, int n, unsigned long long lo, unsigned long long ctr) {
+  __m512i k[15];
+  int r;
+  for (r = 0; r < 15; r++) {
+    k[r] = _mm512_broadcast_i32x4 (_mm_load_si128 ((const __m128i *) (a + 16 * r)));
+  }
+  const __m512i four = _mm512_set_epi64 (4, 0, 4, 0, 4, 0, 4, 0);
+  __m512i c0 = _mm512_set_epi64 (ctr + 3, lo, ctr + 2, lo, ctr + 1, lo, ctr, lo);
+  int done = n & -16;
+  for (; n >= 16; n -= 16, in += 256, out += 256) {
+    __m512i c1 = _mm512_add_epi64 (c0, four), c2 = _mm512_add_epi64 (c1, four), c3 = _mm512_add_epi64 (c2, four);
+    __m512i b0 = _mm512_xor_si512 (c0, k[0]), b1 = _mm512_xor_si512 (c1, k[0]), b2 = _mm512_xor_si512 (c2, k[0]), b3 = _mm512_xor_si512 (c3, k[0]);
+    for (r = 1; r < 14; r++) {
+      b0 = _mm512_aesenc_epi128 (b0, k[r]);
+      b1 = _mm512_aesenc_epi128 (b1, k[r]);
+      b2 = _mm512_aesenc_epi128 (b2, k[r]);
+      b3 = _mm512_aesenc_epi128 (b3, k[r]);
+    }
+    b0 = _mm512_aesenclast_epi128 (b0, k[14]);
+    b1 = _mm512_aesenclast_epi128 (b1, k[14]);
+    b2 = _mm512_aesenclast_epi128 (b2, k[14]);
+    b3 = _mm512_aesenclast_epi128 (b3, k[14]);
+    _mm512_storeu_si512 (out, _mm512_xor_si512 (b0, _mm512_loadu_si512 (in)));
+    _mm512_storeu_si512 (out + 64, _mm512_xor_si512 (b1, _mm512_loadu_si512 (in + 64)));
+    _mm512_storeu_si512 (out + 128, _mm512_xor_si512 (b2, _mm512_loadu_si512 (in + 128)));
+    _mm512_storeu_si512 (out + 192, _mm512_xor_si512 (b3, _mm512_loadu_si512 (in + 192)));
+    c0 = _mm512_add_epi64 (c3, four);
+  }
+  if (n) {
+    aesni256_ctr_blocks (a, in, out, n, lo, ctr + done);
+  }
+}
+
+static inline void aesni256_ctr_crypt (vk_aes_ctx_t *ctx, const unsigned char *in, unsigned char *out, int size, unsigned char iv[16], unsigned long long offset, int use_vaes) {
   unsigned char *a = align16 (&ctx->u.ctx.a[0]);
   unsigned long long *p = (unsigned long long *) (iv + 8);
   const unsigned long long old_ctr_value = *p;
@@ -445,17 +528,18 @@ static void vk_aesni_ctr_crypt (vk_aes_ctx_t *ctx, const unsigned char *in, unsi
       *out++ = (*in++) ^ u.c[i++];
     } while (i < l);
   }
-  const unsigned long long *I = (const unsigned long long *) in;
-  unsigned long long *O = (unsigned long long *) out;
   int n = size >> 4;
-  while (--n >= 0) {
-    aesni256_encrypt (a, iv, (unsigned char *) u.d);
-    (*p)++;
-    *O++ = (*I++) ^ u.d[0];
-    *O++ = (*I++) ^ u.d[1];
+  if (n > 0) {
+    const unsigned long long lo = *(unsigned long long *) iv;
+    if (use_vaes && n >= 16) {
+      aesni256_ctr_blocks_vaes (a, in, out, n, lo, *p);
+    } else {
+      aesni256_ctr_blocks (a, in, out, n, lo, *p);
+    }
+    (*p) += n;
+    in += n << 4;
+    out += n << 4;
   }
-  in = (const unsigned char *) I;
-  out = (unsigned char *) O;
   l = size & 15;
   if (l) {
     aesni256_encrypt (a, iv, u.c);
@@ -467,6 +551,14 @@ static void vk_aesni_ctr_crypt (vk_aes_ctx_t *ctx, const unsigned char *in, unsi
   *p = old_ctr_value;
 }
 
+static void vk_aesni_ctr_crypt (vk_aes_ctx_t *ctx, const unsigned char *in, unsigned char *out, int size, unsigned char iv[16], unsigned long long offset) {
+  aesni256_ctr_crypt (ctx, in, out, size, iv, offset, 0);
+}
+
+static void vk_aesni_ctr_crypt_vaes (vk_aes_ctx_t *ctx, const unsigned char *in, unsigned char *out, int size, unsigned char iv[16], unsigned long long offset) {
+  aesni256_ctr_crypt (ctx, in, out, size, iv, offset, 1);
+}
+
 void vk_ssl_aes_ctr_crypt (vk_aes_ctx_t *ctx, const unsigned char *in, unsigned char *out, int size, unsigned char iv[16], unsigned long long offset) {
   unsigned long long *p = (unsigned long long *) (iv + 8);
   const unsigned long long old_ctr_value = *p;
@@ -515,7 +607,7 @@ void vk_aes_set_encrypt_key (vk_aes_ctx_t *ctx, unsigned char *key, int bits) {
     aesni256_set_encrypt_key (&ctx->u.ctx, key);
     ctx->cbc_crypt = vk_aesni_cbc_encrypt;
     ctx->ige_crypt = vk_aesni_ige_encrypt;
-    ctx->ctr_crypt = vk_aesni_ctr_crypt;
+    ctx->ctr_crypt = vaes_is_supported () ? vk_aesni_ctr_crypt_vaes : vk_aesni_ctr_crypt;
   } else {
     AES_set_encrypt_key (key, bits, &ctx->u.key);
     ctx->cbc_crypt = vk_ssl_aes_cbc_encrypt;
@@ -1860,13 +1860,23 @@ void start_server (void) {
   int i;
   int prev_time;
 
+  if (reactors > 1) {
+    if (!binlog_disabled) {
+      fprintf (stderr, "fatal: multiple reactors are supported only in replica mode (-r)\n");
+      exit (1);
+    }
+    if (start_reactors (reactors) > 0 && Binlog && kfs_reopen_file (Binlog) < 0) {
+      exit (1);
+    }
+  }
+
   init_epoll();
   init_netbuffers();
 
   prev_time = 0;
 
   if (!sfd) {
-    sfd = server_socket (port, settings_addr, backlog, 0);
+    sfd = server_socket (port, settings_addr, backlog, reactors > 1 ? SM_REUSEPORT : 0);
   }
 
   if (sfd < 0) {
@@ -2083,6 +2093,14 @@ int hints_parse_option (int val) {
     case 'z':
       fading = 0;
       break;
+    case 2000:
+      reactors = atoi (optarg);
+      if (reactors < 1 || reactors > MAX_REACTORS) {
+        fprintf (stderr, "error: illegal number of reactors %s\n", optarg);
+        usage ();
+        return 2;
+      }
+      break;
     default:
       return -1;
   }
@@ -2132,6 +2150,9 @@ int main (int argc, char *argv[]) {
     parse_option ("write-only", no_argument, NULL, 'w', "don't save changes in memory and don't answer queries");
   }
   parse_option ("discrete-rating", no_argument, NULL, 'z', "use discrete not fading rating");
+  if (!index_mode) {
+    parse_option ("reactors", required_argument, NULL, 2000, "<reactors> number of event-loop processes sharing the port, replica mode only (default is 1)");
+  }
 
   parse_engine_options_long (argc, argv, hints_parse_option);
   if (argc != optind + 1) {
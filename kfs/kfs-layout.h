@@ -39,6 +39,16 @@
 #define KFS_BINLOG_ZIP_MAX_ENCODED_CHUNK_SIZE ((1<<KFS_BINLOG_ZIP_CHUNK_SIZE_EXP) + (1<<(KFS_BINLOG_ZIP_CHUNK_SIZE_EXP-4)))
 #define KFS_BINLOG_ZIP_FORMAT_FLAG_HAS_TAG 0x01000000
 
+/* streaming zipped binlog (.bin.bz with KFS_BINLOG_ZS_MAGIC):
+   header, sequence of independently compressed frames, optional frame index with trailer.
+   Frames can be appended while the file is read, trailer is rewritten after last frame. */
+#define KFS_BINLOG_ZS_MAGIC 0x04735a4b
+#define KFS_BINLOG_ZS_FRAME_MAGIC 0x46735a4b
+#define KFS_BINLOG_ZS_TRAILER_MAGIC 0x54735a4b
+#define KFS_BINLOG_ZS_DEFAULT_FRAME_SIZE (1<<16)
+#define KFS_BINLOG_ZS_MAX_FRAME_SIZE (1<<20)
+#define KFS_BINLOG_ZS_MAX_ENCODED_FRAME_SIZE (KFS_BINLOG_ZS_MAX_FRAME_SIZE + (KFS_BINLOG_ZS_MAX_FRAME_SIZE >> 4) + 1024)
+
 enum kfs_file_type {
   kfs_binlog = 1,
   kfs_snapshot = 2,
@@ -163,6 +173,41 @@ typedef struct kfs_binlog_zip_header {
   long long chunk_offset[0];
 } kfs_binlog_zip_header_t;
 
+typedef struct kfs_binlog_zs_header {
+  int magic;		// KFS_BINLOG_ZS_MAGIC
+  int format;		// kfs_bz_format_t | (level << 4)
+  int frame_size;	// maximal original size of frame
+  int flags;
+  char first36_bytes[36];
+  int reserved[2];
+  unsigned header_crc32;
+} kfs_binlog_zs_header_t;
+
+typedef struct kfs_binlog_zs_frame {
+  int magic;		// KFS_BINLOG_ZS_FRAME_MAGIC
+  int orig_size;
+  int comp_size;	// compressed bytes following this header
+  unsigned orig_crc32;
+  long long orig_offset;
+  unsigned header_crc32;
+} kfs_binlog_zs_frame_t;
+
+typedef struct kfs_binlog_zs_index_entry {
+  long long orig_offset;
+  long long file_offset;
+} kfs_binlog_zs_index_entry_t;
+
+/* frames index entries are followed by trailer, which is the last 40 bytes of the file */
+typedef struct kfs_binlog_zs_trailer {
+  long long index_offset;
+  long long orig_file_size;
+  unsigned long long file_hash;	// 0 if file doesn't end by LEV_ROTATE_TO
+  int frames;
+  unsigned index_crc32;
+  unsigned trailer_crc32;
+  int magic;		// KFS_BINLOG_ZS_TRAILER_MAGIC
+} kfs_binlog_zs_trailer_t;
+
 #pragma	pack(pop)
 
 #endif
@@ -32,6 +32,7 @@
 #include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <aio.h>
 #include <errno.h>
 #include <zlib.h>
@@ -177,6 +178,9 @@ static void file_info_decref (struct kfs_file_info *FI) {
   if (FI->iv) {
     free (FI->iv);
   }
+  if (FI->zs) {
+    kfs_zs_free_index (FI->zs);
+  }
   if (FI->filename) {
     free (FI->filename);
   }
@@ -250,8 +254,8 @@ static int compute_iv (kfs_replica_handle_t R, const char *filename, int filenam
 
 int kfs_file_compute_initialization_vector (struct kfs_file_info *FI) {
   kfs_replica_handle_t R = FI->replica;
-  assert (R);
-  if (R->ctx_crypto == NULL || FI->iv != NULL) {
+  /* files opened by kfs_open_file don't belong to any replica and aren't encrypted */
+  if (R == NULL || R->ctx_crypto == NULL || FI->iv != NULL) {
     return 0;
   }
   const char *name = basename (FI->filename);
@@ -676,6 +680,41 @@ static int process_binlog_zip_header (struct kfs_file_info *FI, int fd, kfs_binl
   return process_first36_bytes (FI, fd, 36, (struct lev_start *) H->first36_bytes);
 }
 
+static int check_binlog_zs_header (kfs_binlog_zs_header_t *H) {
+  if (H->magic != KFS_BINLOG_ZS_MAGIC || compute_crc32 (H, sizeof (*H) - 4) != H->header_crc32) {
+    return -1;
+  }
+  if (H->frame_size <= 0 || H->frame_size > KFS_BINLOG_ZS_MAX_FRAME_SIZE) {
+    return -1;
+  }
+  if ((H->format & 15) != kfs_bzf_zlib && (H->format & 15) != kfs_bzf_xz) {
+    return -1;
+  }
+  return 0;
+}
+
+static int process_binlog_zs_header (struct kfs_file_info *FI, int fd, kfs_binlog_zs_header_t *H) {
+  assert (FI->preloaded_bytes >= sizeof (kfs_binlog_zs_header_t));
+  if (check_binlog_zs_header (H) < 0) {
+    fprintf (stderr, "%s: corrupted streaming zipped binlog header in the file '%s'.\n", __func__, FI->filename);
+    assert (close (fd) >= 0);
+    return -1;
+  }
+  if (FI->iv) {
+    fprintf (stderr, "%s: encrypted streaming zipped binlogs aren't supported, file '%s'.\n", __func__, FI->filename);
+    assert (close (fd) >= 0);
+    return -1;
+  }
+  if (!FI->zs) {
+    FI->zs = kfs_zs_load_index (fd, FI->filename);
+    if (!FI->zs) {
+      assert (close (fd) >= 0);
+      return -1;
+    }
+  }
+  return process_first36_bytes (FI, fd, 36, (struct lev_start *) H->first36_bytes);
+}
+
 int preload_file_info (struct kfs_file_info *FI) {
   if (!FI->start) {
     int fd = open (FI->filename, O_RDONLY);
@@ -773,6 +812,16 @@ int preload_file_info (struct kfs_file_info *FI) {
           return -2;
         }
         break;
+      case KFS_BINLOG_ZS_MAGIC:
+        if (headers || !(FI->flags & 16)) {
+          fprintf (stderr, "error: streaming zipped binlog file '%s' contains KFS headers or has wrong suffix\n", FI->filename);
+          assert (close (fd) >= 0);
+          return -2;
+        }
+        if (process_binlog_zs_header (FI, fd, (kfs_binlog_zs_header_t *) E) < 0) {
+          return -2;
+        }
+        break;
       default:
         fprintf (stderr, "warning: binlog file %s begins with wrong entry type %08x\n", FI->filename, E->type);
         assert (close (fd) >= 0);
@@ -831,13 +880,20 @@ kfs_binlog_zip_header_t *load_binlog_zip_header (struct kfs_file_info *FI) {
   if (fd >= 0) {
     assert (!close (fd));
   }
+  if (FI->zs) {
+    fprintf (stderr, "%s: file '%s' is streaming zipped binlog\n", __func__, FI->filename);
+    return 0;
+  }
   return ((kfs_binlog_zip_header_t *) FI->start);
 }
 
-static inline long long kfs_get_binlog_file_size (struct kfs_file_info *FI) {
+long long kfs_get_binlog_file_size (struct kfs_file_info *FI) {
   if (!(FI->flags & 16)) {
     return FI->file_size - 4096 * FI->kfs_headers;
   }
+  if (FI->zs) {
+    return FI->zs->orig_size;
+  }
   kfs_binlog_zip_header_t *H = (kfs_binlog_zip_header_t *) FI->start;
   assert (H);
   return H->orig_file_size;
@@ -935,7 +991,9 @@ kfs_file_handle_t open_binlog (kfs_replica_handle_t R, long long log_pos) {
       F->info = FI;
       F->fd = fd;
       F->offset = FI->kfs_headers * 4096;
+      F->drop_off = file_pos & -4096;
       FI->refcnt++;
+      kfs_set_access_pattern (F, KFS_ACCESS_SEQUENTIAL);
 
       return F;
     }
@@ -968,6 +1026,28 @@ int kfs_close_file (kfs_file_handle_t F, int close_handle) {
   return 0;
 }
 
+/* gives F its own open file description (and file offset) under the same fd, needed after fork() */
+int kfs_reopen_file (kfs_file_handle_t F) {
+  assert (F && F->fd >= 0 && F->info);
+  long long pos = lseek (F->fd, 0, SEEK_CUR);
+  if (pos < 0) {
+    fprintf (stderr, "lseek() failed for file %s: %m\n", F->info->filename);
+    return -1;
+  }
+  int fd = open (F->info->filename, O_RDONLY);
+  if (fd < 0) {
+    fprintf (stderr, "cannot reopen file %s: %m\n", F->info->filename);
+    return -1;
+  }
+  if (lseek (fd, pos, SEEK_SET) != pos || dup2 (fd, F->fd) != F->fd) {
+    fprintf (stderr, "cannot restore position %lld in reopened file %s: %m\n", pos, F->info->filename);
+    assert (close (fd) >= 0);
+    return -1;
+  }
+  assert (close (fd) >= 0);
+  return F->fd;
+}
+
 int close_binlog (kfs_file_handle_t F, int close_handle) {
   return kfs_close_file (F, close_handle);
 }
@@ -1036,6 +1116,7 @@ kfs_file_handle_t next_binlog (kfs_file_handle_t F) {
   F->fd = fd;
   F->offset = FI2->kfs_headers * 4096;
   FI2->refcnt++;
+  kfs_set_access_pattern (F, KFS_ACCESS_SEQUENTIAL);
 
   return F;
 }
@@ -1413,6 +1494,22 @@ kfs_file_handle_t open_recent_snapshot (kfs_replica_handle_t R) {
   return F;
 }
 
+kfs_file_handle_t open_previous_snapshot (kfs_replica_handle_t R, kfs_file_handle_t F) {
+  if (!R || !F) {
+    return 0;
+  }
+  int p = R->snapshot_num - 1;
+  while (p >= 0 && R->snapshots[p] != F->info) {
+    --p;
+  }
+  struct kfs_file *G = 0;
+  --p;
+  while (p >= 0 && (G = open_snapshot (R, p)) == 0) {
+    --p;
+  }
+  return G;
+}
+
 int close_snapshot (kfs_file_handle_t F, int close_handle) {
   return kfs_close_file (F, close_handle);
 }
@@ -1596,6 +1693,401 @@ kfs_file_handle_t kfs_open_file (const char *filename, int cut_backup_suffix) {
   return F;
 }
 
+/******************** streaming zipped binlogs ********************/
+
+static void zs_index_push (struct kfs_zs_index *Z, long long orig_offset, long long file_offset) {
+  if (Z->frames == Z->size) {
+    Z->size = Z->size ? 2 * Z->size : 256;
+    Z->E = realloc (Z->E, Z->size * sizeof (Z->E[0]));
+    assert (Z->E);
+  }
+  Z->E[Z->frames].orig_offset = orig_offset;
+  Z->E[Z->frames].file_offset = file_offset;
+  Z->frames++;
+}
+
+void kfs_zs_free_index (struct kfs_zs_index *Z) {
+  if (Z->E) {
+    free (Z->E);
+  }
+  free (Z);
+}
+
+static int zs_load_trailer (struct kfs_zs_index *Z, int fd, long long file_size) {
+  kfs_binlog_zs_trailer_t T;
+  if (file_size < sizeof (kfs_binlog_zs_header_t) + sizeof (T)) {
+    return -1;
+  }
+  if (pread (fd, &T, sizeof (T), file_size - sizeof (T)) != sizeof (T)) {
+    return -1;
+  }
+  if (T.magic != KFS_BINLOG_ZS_TRAILER_MAGIC || compute_crc32 (&T, offsetof (kfs_binlog_zs_trailer_t, trailer_crc32)) != T.trailer_crc32) {
+    return -1;
+  }
+  if (T.frames < 0 || T.index_offset < sizeof (kfs_binlog_zs_header_t) || T.index_offset + (long long) T.frames * sizeof (kfs_binlog_zs_index_entry_t) + sizeof (T) != file_size) {
+    return -1;
+  }
+  int sz = T.frames * sizeof (kfs_binlog_zs_index_entry_t);
+  kfs_binlog_zs_index_entry_t *E = malloc (sz + 1);
+  assert (E);
+  if (pread (fd, E, sz, T.index_offset) != sz || compute_crc32 (E, sz) != T.index_crc32) {
+    free (E);
+    return -1;
+  }
+  int i;
+  for (i = 0; i < T.frames; i++) {
+    if (E[i].orig_offset < (i ? E[i-1].orig_offset + 1 : 0) || E[i].orig_offset >= T.orig_file_size || E[i].file_offset >= T.index_offset) {
+      free (E);
+      return -1;
+    }
+  }
+  Z->E = E;
+  Z->frames = Z->size = T.frames;
+  Z->orig_size = T.orig_file_size;
+  Z->data_end = T.index_offset;
+  Z->file_hash = T.file_hash;
+  Z->sealed = 1;
+  return 0;
+}
+
+/* picks up frames appended after Z->data_end; an incomplete last frame is ignored until it is written completely */
+int kfs_zs_refresh_index (struct kfs_zs_index *Z, int fd, const char *filename) {
+  struct stat st;
+  if (fstat (fd, &st) < 0) {
+    fprintf (stderr, "%s: fstat for the file '%s' failed. %m\n", __func__, filename);
+    return -1;
+  }
+  int n = 0;
+  kfs_binlog_zs_frame_t H;
+  while (Z->data_end + (long long) sizeof (H) <= st.st_size) {
+    if (pread (fd, &H, sizeof (H), Z->data_end) != sizeof (H)) {
+      fprintf (stderr, "%s: fail to read frame header at offset %lld of the file '%s'. %m\n", __func__, Z->data_end, filename);
+      return -1;
+    }
+    if (H.magic != KFS_BINLOG_ZS_FRAME_MAGIC || compute_crc32 (&H, offsetof (kfs_binlog_zs_frame_t, header_crc32)) != H.header_crc32) {
+      break;
+    }
+    if (H.orig_offset != Z->orig_size || H.orig_size <= 0 || H.orig_size > KFS_BINLOG_ZS_MAX_FRAME_SIZE || H.comp_size <= 0 || H.comp_size > KFS_BINLOG_ZS_MAX_ENCODED_FRAME_SIZE) {
+      break;
+    }
+    if (Z->data_end + (long long) sizeof (H) + H.comp_size > st.st_size) {
+      break;
+    }
+    zs_index_push (Z, Z->orig_size, Z->data_end);
+    Z->data_end += sizeof (H) + H.comp_size;
+    Z->orig_size += H.orig_size;
+    n++;
+  }
+  if (n) {
+    Z->sealed = 0;
+    Z->file_hash = 0;
+    if (verbosity >= 2) {
+      fprintf (stderr, "%s: found %d new frames in the file '%s', original size is %lld now.\n", __func__, n, filename, Z->orig_size);
+    }
+  }
+  return n;
+}
+
+struct kfs_zs_index *kfs_zs_load_index (int fd, const char *filename) {
+  struct stat st;
+  if (fstat (fd, &st) < 0) {
+    fprintf (stderr, "%s: fstat for the file '%s' failed. %m\n", __func__, filename);
+    return 0;
+  }
+  struct kfs_zs_index *Z = calloc (sizeof (*Z), 1);
+  assert (Z);
+  if (zs_load_trailer (Z, fd, st.st_size) < 0) {
+    /* not sealed: recover index from frame headers */
+    Z->data_end = sizeof (kfs_binlog_zs_header_t);
+  }
+  if (kfs_zs_refresh_index (Z, fd, filename) < 0) {
+    kfs_zs_free_index (Z);
+    return 0;
+  }
+  return Z;
+}
+
+static int kfs_zs_decode (kfs_file_handle_t F, long long off, unsigned char *dst, int *dest_len, int *disk_bytes_read) {
+  struct kfs_file_info *FI = F->info;
+  struct kfs_zs_index *Z = FI->zs;
+  kfs_binlog_zs_header_t *H = (kfs_binlog_zs_header_t *) FI->start;
+  assert (Z && H);
+
+  if (off < 0) {
+    fprintf (stderr, "%s: negative file offset '%lld', file '%s'.\n", __func__, off, FI->filename);
+    return -1;
+  }
+  if (off >= Z->orig_size && kfs_zs_refresh_index (Z, F->fd, FI->filename) < 0) {
+    return -1;
+  }
+  if (off > Z->orig_size) {
+    fprintf (stderr, "%s: file offset '%lld' is greater than original file size '%lld', file '%s'.\n", __func__, off, Z->orig_size, FI->filename);
+    return -1;
+  }
+  if (off == Z->orig_size) {
+    *dest_len = 0;
+    return 0;
+  }
+
+  int l = 0, r = Z->frames;
+  while (r - l > 1) { // E[l].orig_offset <= off < E[r].orig_offset
+    int m = (l + r) >> 1;
+    if (Z->E[m].orig_offset <= off) {
+      l = m;
+    } else {
+      r = m;
+    }
+  }
+
+  static unsigned char src[sizeof (kfs_binlog_zs_frame_t) + KFS_BINLOG_ZS_MAX_ENCODED_FRAME_SIZE], buff[KFS_BINLOG_ZS_MAX_FRAME_SIZE];
+  int i = l, avail_out = *dest_len, written_bytes = 0;
+  long long o = off - (Z->frames ? Z->E[i].orig_offset : 0);
+
+  while (i < Z->frames && avail_out > 0) {
+    const long long frame_offset = Z->E[i].file_offset;
+    const long long frame_size = (i + 1 < Z->frames ? Z->E[i+1].file_offset : Z->data_end) - frame_offset;
+    if (frame_size <= (long long) sizeof (kfs_binlog_zs_frame_t) || frame_size > sizeof (src)) {
+      fprintf (stderr, "%s: illegal frame size (%lld), frame %d, file '%s'.\n", __func__, frame_size, i, FI->filename);
+      return -1;
+    }
+    ssize_t s = pread (F->fd, src, frame_size, frame_offset);
+    if (s != frame_size) {
+      fprintf (stderr, "%s: read %lld of expected %lld bytes, frame %d, offset %lld, file '%s'. %m\n", __func__, (long long) s, frame_size, i, frame_offset, FI->filename);
+      return -1;
+    }
+    if (disk_bytes_read) {
+      *disk_bytes_read += s;
+    }
+    kfs_binlog_zs_frame_t *FH = (kfs_binlog_zs_frame_t *) src;
+    if (FH->magic != KFS_BINLOG_ZS_FRAME_MAGIC || compute_crc32 (FH, offsetof (kfs_binlog_zs_frame_t, header_crc32)) != FH->header_crc32 ||
+        FH->orig_offset != Z->E[i].orig_offset || FH->comp_size != frame_size - sizeof (*FH) || FH->orig_size <= o || FH->orig_size > KFS_BINLOG_ZS_MAX_FRAME_SIZE) {
+      fprintf (stderr, "%s: corrupted header of frame %d, offset %lld, file '%s'.\n", __func__, i, frame_offset, FI->filename);
+      return -1;
+    }
+
+    int m = FH->orig_size, res;
+    unsigned char *out = (!o && avail_out >= m) ? dst : buff;
+    uLongf destLen;
+    switch (H->format & 15) {
+      case kfs_bzf_zlib:
+        destLen = m;
+        res = uncompress (out, &destLen, src + sizeof (*FH), FH->comp_size);
+        if (res != Z_OK) {
+          fprintf (stderr, "%s: uncompress returns error code %d, frame %d, offset %lld, file '%s'.\n", __func__, res, i, frame_offset, FI->filename);
+          return -1;
+        }
+        m = (int) destLen;
+        break;
+      case kfs_bzf_xz:
+        res = xz_uncompress2 (out, &m, src + sizeof (*FH), FH->comp_size);
+        if (res < 0) {
+          fprintf (stderr, "%s: xz_uncompress returns error code %d, frame %d, offset %lld, file '%s'.\n", __func__, res, i, frame_offset, FI->filename);
+          return -1;
+        }
+        break;
+      default:
+        fprintf (stderr, "%s: Unimplemented format '%d' in the file '%s'.\n", __func__, H->format & 15, FI->filename);
+        return -1;
+    }
+    if (m != FH->orig_size || compute_crc32 (out, m) != FH->orig_crc32) {
+      fprintf (stderr, "%s: frame %d (offset %lld) of the file '%s' decoded to %d bytes with wrong crc32.\n", __func__, i, frame_offset, FI->filename, m);
+      return -1;
+    }
+
+    int w = m - o;
+    if (w > avail_out) {
+      w = avail_out;
+    }
+    if (out != dst) {
+      memcpy (dst, buff + o, w);
+    }
+    dst += w;
+    avail_out -= w;
+    written_bytes += w;
+    o = 0;
+    i++;
+  }
+  *dest_len = written_bytes;
+  return 0;
+}
+
+static int zs_write_frame (kfs_zs_writer_t *W, unsigned char *data, int len) {
+  static unsigned char buff[sizeof (kfs_binlog_zs_frame_t) + KFS_BINLOG_ZS_MAX_ENCODED_FRAME_SIZE];
+  struct kfs_zs_index *Z = W->Z;
+  kfs_binlog_zs_frame_t *FH = (kfs_binlog_zs_frame_t *) buff;
+  int m = KFS_BINLOG_ZS_MAX_ENCODED_FRAME_SIZE;
+  if (W->compress) {
+    if (W->compress (buff + sizeof (*FH), &m, data, len, W->format, W->level) < 0) {
+      fprintf (stderr, "%s: fail to compress frame for the file '%s'.\n", __func__, W->filename);
+      return -1;
+    }
+  } else {
+    assert (W->format == kfs_bzf_zlib);
+    uLongf destLen = m;
+    if (compress2 (buff + sizeof (*FH), &destLen, data, len, W->level) != Z_OK) {
+      fprintf (stderr, "%s: fail to compress frame for the file '%s'.\n", __func__, W->filename);
+      return -1;
+    }
+    m = destLen;
+  }
+  assert (m > 0 && m <= KFS_BINLOG_ZS_MAX_ENCODED_FRAME_SIZE);
+  FH->magic = KFS_BINLOG_ZS_FRAME_MAGIC;
+  FH->orig_size = len;
+  FH->comp_size = m;
+  FH->orig_crc32 = compute_crc32 (data, len);
+  FH->orig_offset = Z->orig_size;
+  FH->header_crc32 = compute_crc32 (FH, offsetof (kfs_binlog_zs_frame_t, header_crc32));
+  m += sizeof (*FH);
+  if (pwrite (W->fd, buff, m, Z->data_end) != m) {
+    fprintf (stderr, "%s: fail to write %d bytes to the file '%s' at offset %lld. %m\n", __func__, m, W->filename, Z->data_end);
+    return -1;
+  }
+  zs_index_push (Z, Z->orig_size, Z->data_end);
+  Z->data_end += m;
+  Z->orig_size += len;
+  return 0;
+}
+
+int kfs_zs_writer_open (kfs_zs_writer_t *W, const char *filename, kfs_bz_format_t format, int level, int frame_size, const char first36_bytes[36]) {
+  memset (W, 0, sizeof (*W));
+  if (frame_size <= 0 || frame_size > KFS_BINLOG_ZS_MAX_FRAME_SIZE) {
+    fprintf (stderr, "%s: illegal frame size %d.\n", __func__, frame_size);
+    return -1;
+  }
+  kfs_binlog_zs_header_t H;
+  int fd = open (filename, O_RDWR);
+  if (fd >= 0) {
+    if (lock_whole_file (fd, F_WRLCK) <= 0) {
+      fprintf (stderr, "%s: cannot lock file '%s' for writing\n", __func__, filename);
+      assert (close (fd) >= 0);
+      return -1;
+    }
+    if (pread (fd, &H, sizeof (H), 0) != sizeof (H) || check_binlog_zs_header (&H) < 0) {
+      fprintf (stderr, "%s: '%s' isn't streaming zipped binlog.\n", __func__, filename);
+      assert (close (fd) >= 0);
+      return -1;
+    }
+    if (memcmp (H.first36_bytes, first36_bytes, 36)) {
+      fprintf (stderr, "%s: first 36 bytes of '%s' don't match appended binlog.\n", __func__, filename);
+      assert (close (fd) >= 0);
+      return -1;
+    }
+    W->Z = kfs_zs_load_index (fd, filename);
+    if (!W->Z) {
+      assert (close (fd) >= 0);
+      return -1;
+    }
+    /* drop index, trailer and possibly torn last frame */
+    if (ftruncate (fd, W->Z->data_end) < 0) {
+      fprintf (stderr, "%s: ftruncate (%lld) for the file '%s' failed. %m\n", __func__, W->Z->data_end, filename);
+      kfs_zs_free_index (W->Z);
+      assert (close (fd) >= 0);
+      return -1;
+    }
+    W->Z->sealed = 0;
+    W->Z->file_hash = 0;
+    W->format = H.format & 15;
+    W->level = (H.format >> 4) & 15;
+    W->frame_size = H.frame_size;
+  } else {
+    fd = open (filename, O_CREAT | O_EXCL | O_RDWR, 0640);
+    if (fd < 0) {
+      fprintf (stderr, "%s: cannot create file '%s'. %m\n", __func__, filename);
+      return -1;
+    }
+    if (lock_whole_file (fd, F_WRLCK) <= 0) {
+      fprintf (stderr, "%s: cannot lock file '%s' for writing\n", __func__, filename);
+      assert (close (fd) >= 0);
+      return -1;
+    }
+    memset (&H, 0, sizeof (H));
+    H.magic = KFS_BINLOG_ZS_MAGIC;
+    H.format = format | (level << 4);
+    H.frame_size = frame_size;
+    memcpy (H.first36_bytes, first36_bytes, 36);
+    H.header_crc32 = compute_crc32 (&H, sizeof (H) - 4);
+    if (write (fd, &H, sizeof (H)) != sizeof (H)) {
+      fprintf (stderr, "%s: fail to write header to the file '%s'. %m\n", __func__, filename);
+      assert (close (fd) >= 0);
+      unlink (filename);
+      return -1;
+    }
+    W->Z = calloc (sizeof (struct kfs_zs_index), 1);
+    assert (W->Z);
+    W->Z->data_end = sizeof (H);
+    W->format = format;
+    W->level = level;
+    W->frame_size = frame_size;
+  }
+  W->fd = fd;
+  W->filename = strdup (filename);
+  W->buff = malloc (W->frame_size);
+  assert (W->filename && W->buff);
+  return 0;
+}
+
+int kfs_zs_write (kfs_zs_writer_t *W, const void *data, int len) {
+  const unsigned char *d = data;
+  while (len > 0) {
+    int r = W->frame_size - W->buff_bytes;
+    if (r > len) {
+      r = len;
+    }
+    memcpy (W->buff + W->buff_bytes, d, r);
+    W->buff_bytes += r;
+    d += r;
+    len -= r;
+    if (W->buff_bytes == W->frame_size) {
+      if (zs_write_frame (W, W->buff, W->buff_bytes) < 0) {
+        return -1;
+      }
+      W->buff_bytes = 0;
+    }
+  }
+  return 0;
+}
+
+int kfs_zs_flush (kfs_zs_writer_t *W) {
+  if (W->buff_bytes > 0) {
+    if (zs_write_frame (W, W->buff, W->buff_bytes) < 0) {
+      return -1;
+    }
+    W->buff_bytes = 0;
+  }
+  return 0;
+}
+
+int kfs_zs_writer_close (kfs_zs_writer_t *W, int seal, kfs_hash_t file_hash) {
+  int res = kfs_zs_flush (W);
+  struct kfs_zs_index *Z = W->Z;
+  if (!res && seal) {
+    kfs_binlog_zs_trailer_t T;
+    int sz = Z->frames * sizeof (kfs_binlog_zs_index_entry_t);
+    memset (&T, 0, sizeof (T));
+    T.index_offset = Z->data_end;
+    T.orig_file_size = Z->orig_size;
+    T.file_hash = file_hash;
+    T.frames = Z->frames;
+    T.index_crc32 = compute_crc32 (Z->E, sz);
+    T.magic = KFS_BINLOG_ZS_TRAILER_MAGIC;
+    T.trailer_crc32 = compute_crc32 (&T, offsetof (kfs_binlog_zs_trailer_t, trailer_crc32));
+    if (pwrite (W->fd, Z->E, sz, Z->data_end) != sz || pwrite (W->fd, &T, sizeof (T), Z->data_end + sz) != sizeof (T)) {
+      fprintf (stderr, "%s: fail to write frames index to the file '%s'. %m\n", __func__, W->filename);
+      res = -1;
+    }
+  }
+  if (fsync (W->fd) < 0) {
+    fprintf (stderr, "%s: fsync for the file '%s' failed. %m\n", __func__, W->filename);
+    res = -1;
+  }
+  assert (close (W->fd) >= 0);
+  kfs_zs_free_index (Z);
+  free (W->buff);
+  free (W->filename);
+  memset (W, 0, sizeof (*W));
+  return res;
+}
+
 int kfs_bz_decode (kfs_file_handle_t F, long long off, void *dst, int *dest_len, int *disk_bytes_read) {
   if (verbosity >= 3) {
     fprintf (stderr, "%s: off = %lld, dst = %p, *dest_len = %d\n", __func__, off, dst, *dest_len);
@@ -1604,6 +2096,9 @@ int kfs_bz_decode (kfs_file_handle_t F, long long off, void *dst, int *dest_len,
     *disk_bytes_read = 0;
   }
   struct kfs_file_info *FI = F->info;
+  if (FI->zs) {
+    return kfs_zs_decode (F, off, dst, dest_len, disk_bytes_read);
+  }
   kfs_binlog_zip_header_t *H = (kfs_binlog_zip_header_t *) FI->start;
   assert (H);
   const int chunks = kfs_bz_get_chunks_no (H->orig_file_size), fd = F->fd;
@@ -1886,5 +2381,155 @@ long long kfs_read_file (kfs_file_handle_t F, void *buff, long long size) {
   if (off >= 0) {
     kfs_buffer_crypt (F, buff, r, off);
   }
+  kfs_account_read (F, r);
   return r;
 }
+
+/******************** snapshot mapping ********************/
+
+int kfs_no_mmap;
+long long kfs_mapped_bytes;
+
+static long kfs_page_size (void) {
+  static long page_size;
+  if (!page_size) {
+    page_size = sysconf (_SC_PAGESIZE);
+    assert (page_size > 0 && !(page_size & (page_size - 1)));
+  }
+  return page_size;
+}
+
+/* one zero page is mapped after data, since list decoders may read a few bytes beyond the end of a section */
+void *kfs_mmap_file (kfs_file_handle_t F, long long offset, long long size) {
+  if (kfs_no_mmap || !F || F->fd < 0 || offset < 0 || size < 0) {
+    return 0;
+  }
+  if (F->info->flags & 16) {
+    return 0;
+  }
+  const long page_size = kfs_page_size ();
+  const long long delta = offset & (page_size - 1);
+  const long long map_size = (delta + size + page_size - 1) & -page_size;
+  struct stat st;
+  if (fstat (F->fd, &st) < 0 || offset + size > st.st_size) {
+    return 0;
+  }
+  char *base = mmap (0, map_size + page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    fprintf (stderr, "%s: cannot reserve %lld bytes of address space. %m\n", __func__, map_size + page_size);
+    return 0;
+  }
+  if (!map_size) {
+    return base;
+  }
+  const int encrypted = F->info->iv != NULL;
+  if (mmap (base, map_size, encrypted ? PROT_READ | PROT_WRITE : PROT_READ, (encrypted ? MAP_PRIVATE : MAP_SHARED) | MAP_FIXED, F->fd, offset - delta) == MAP_FAILED) {
+    fprintf (stderr, "%s: cannot map %lld bytes at offset %lld of the file '%s'. %m\n", __func__, size, offset, F->info->filename);
+    assert (!munmap (base, map_size + page_size));
+    return 0;
+  }
+  if (encrypted) {
+    /* bulk decrypt: pages become private copies, so page cache isn't shared for encrypted snapshots */
+    kfs_buffer_crypt (F, base, map_size, offset - delta);
+    assert (!mprotect (base, map_size, PROT_READ));
+  }
+  kfs_mapped_bytes += size;
+  if (verbosity >= 2) {
+    fprintf (stderr, "%s: mapped %lld bytes at offset %lld of the file '%s'%s.\n", __func__, size, offset, F->info->filename, encrypted ? " (decrypted)" : "");
+  }
+  return base + delta;
+}
+
+void kfs_munmap_file (void *ptr, long long size) {
+  const long page_size = kfs_page_size ();
+  const long long delta = (long) ptr & (page_size - 1);
+  const long long map_size = (delta + size + page_size - 1) & -page_size;
+  assert (!munmap ((char *) ptr - delta, map_size + page_size));
+  kfs_mapped_bytes -= size;
+}
+
+/* kdb-data-common isn't linked into binlog utilities (log-split, backup-engine), which never load index sections */
+void *zmalloc (long size) __attribute__ ((weak));
+void zfree (void *ptr, long size) __attribute__ ((weak));
+
+void *kfs_load_file_section (kfs_file_handle_t F, long long offset, long long size, long long *loaded_bytes) {
+  void *data = kfs_mmap_file (F, offset, size);
+  if (data) {
+    /* callers may continue reading sequentially after the section */
+    assert (lseek (F->fd, offset + size, SEEK_SET) == offset + size);
+    return data;
+  }
+  assert (zmalloc);
+  data = zmalloc (size);
+  if (lseek (F->fd, offset, SEEK_SET) != offset) {
+    fprintf (stderr, "%s: cannot seek to offset %lld of the file '%s'. %m\n", __func__, offset, F->info->filename);
+    exit (1);
+  }
+  long long r = kfs_read_file (F, data, size);
+  if (r < size) {
+    fprintf (stderr, "%s: read only %lld bytes of %lld at offset %lld of the file '%s'.\n", __func__, r, size, offset, F->info->filename);
+    zfree (data, size);
+    return 0;
+  }
+  *loaded_bytes += r;
+  return data;
+}
+
+/******************** page cache hints ********************/
+
+int kfs_no_fadvise;
+long long kfs_read_bytes[KFS_ACCESS_PATTERNS], kfs_dropped_bytes, kfs_prefetched_bytes;
+
+/* pages behind replay cursor are dropped in batches, keeping some of them for readers of binlog tail */
+#define	KFS_DROP_BEHIND_BATCH	(8 << 20)
+#define	KFS_DROP_BEHIND_KEEP	(1 << 20)
+
+static void kfs_fadvise (kfs_file_handle_t F, long long offset, long long size, int advice) {
+  int err = posix_fadvise (F->fd, offset, size, advice);
+  if (err && verbosity >= 1) {
+    fprintf (stderr, "%s: posix_fadvise (%d) for the file '%s' failed. %s\n", __func__, advice, F->info ? F->info->filename : "?", strerror (err));
+  }
+}
+
+void kfs_set_access_pattern (kfs_file_handle_t F, int pattern) {
+  assert (pattern >= 0 && pattern < KFS_ACCESS_PATTERNS);
+  if (!F || F->fd < 0) {
+    return;
+  }
+  F->access_pattern = pattern;
+  if (kfs_no_fadvise) {
+    return;
+  }
+  static const int advice[KFS_ACCESS_PATTERNS] = { POSIX_FADV_NORMAL, POSIX_FADV_SEQUENTIAL, POSIX_FADV_RANDOM };
+  kfs_fadvise (F, 0, 0, advice[pattern]);
+  if (verbosity >= 3) {
+    fprintf (stderr, "%s: access pattern of the file '%s' is %d.\n", __func__, F->info ? F->info->filename : "?", pattern);
+  }
+}
+
+void kfs_account_read (kfs_file_handle_t F, long long size) {
+  if (F && size > 0) {
+    kfs_read_bytes[F->access_pattern] += size;
+  }
+}
+
+void kfs_drop_behind (kfs_file_handle_t F, long long file_offset) {
+  if (kfs_no_fadvise || !F || F->fd < 0 || F->access_pattern != KFS_ACCESS_SEQUENTIAL) {
+    return;
+  }
+  long long end = (file_offset - KFS_DROP_BEHIND_KEEP) & -kfs_page_size ();
+  if (end - F->drop_off < KFS_DROP_BEHIND_BATCH) {
+    return;
+  }
+  kfs_fadvise (F, F->drop_off, end - F->drop_off, POSIX_FADV_DONTNEED);
+  kfs_dropped_bytes += end - F->drop_off;
+  F->drop_off = end;
+}
+
+void kfs_prefetch_range (kfs_file_handle_t F, long long offset, long long size) {
+  if (kfs_no_fadvise || !F || F->fd < 0 || offset < 0 || size <= 0) {
+    return;
+  }
+  kfs_fadvise (F, offset, size, POSIX_FADV_WILLNEED);
+  kfs_prefetched_bytes += size;
+}
@@ -39,6 +39,17 @@ struct kfs_data_directory {
   char dirname[MAX_KFS_FNAME];
 };
 
+/* frame index of streaming zipped binlog (KFS_BINLOG_ZS_MAGIC) */
+struct kfs_zs_index {
+  long long orig_size;		// original bytes covered by known frames
+  long long data_end;		// file offset after the last known frame
+  kfs_hash_t file_hash;		// from trailer, 0 = unknown
+  int frames;
+  int size;
+  int sealed;			// index and trailer follow the last frame
+  kfs_binlog_zs_index_entry_t *E;
+};
+
 typedef struct kfs_replica *kfs_replica_handle_t;
 typedef struct kfs_file *kfs_file_handle_t;
 
@@ -74,6 +85,7 @@ struct kfs_file_info {
   int mtime;
   int inode;
   int device;
+  struct kfs_zs_index *zs;	// only for streaming zipped binlogs
 };
 
 struct kfs_file {
@@ -81,6 +93,8 @@ struct kfs_file {
   int fd;			// -1 = not open
   int lock;			// 0 = unlocked, >=1 = read lock(s), -1 = write lock
   long long offset;
+  int access_pattern;		// KFS_ACCESS_*
+  long long drop_off;		// file offset up to which pages were already dropped from page cache
 };
 
 typedef struct kfs_snapshot_write_stream {
@@ -90,6 +104,20 @@ typedef struct kfs_snapshot_write_stream {
   int newidx_fd;
 } kfs_snapshot_write_stream_t;
 
+typedef int (*kfs_zs_compress_t) (void *dst, int *dst_len, void *src, int src_len, kfs_bz_format_t format, int level);
+
+typedef struct kfs_zs_writer {
+  char *filename;
+  int fd;
+  int format;
+  int level;
+  int frame_size;
+  int buff_bytes;
+  unsigned char *buff;
+  kfs_zs_compress_t compress;	// NULL = zlib compress2
+  struct kfs_zs_index *Z;
+} kfs_zs_writer_t;
+
 int lock_whole_file (int fd, int mode);
 
 kfs_replica_handle_t open_replica (const char *replica_name, int force);
@@ -97,6 +125,7 @@ int close_replica (kfs_replica_handle_t R);
 int update_replica (kfs_replica_handle_t R, int force);
 
 int kfs_close_file (kfs_file_handle_t F, int close_handle);
+int kfs_reopen_file (kfs_file_handle_t F);
 
 kfs_file_handle_t open_binlog (kfs_replica_handle_t Replica, long long log_pos);
 kfs_file_handle_t next_binlog (kfs_file_handle_t log_handle);
@@ -113,6 +142,7 @@ long long get_binlog_start_pos (kfs_replica_handle_t R, int binlog_id, long long
 
 kfs_file_handle_t open_snapshot (kfs_replica_handle_t R, int snapshot_index);  // index must be in [0, R->snapshot_num)
 kfs_file_handle_t open_recent_snapshot (kfs_replica_handle_t Replica);  // file position is after kfs headers
+kfs_file_handle_t open_previous_snapshot (kfs_replica_handle_t R, kfs_file_handle_t F);  // most recent readable snapshot older than F (for delta snapshots)
 kfs_file_handle_t create_new_snapshot (kfs_replica_handle_t Replica, long long log_pos);
 char *get_new_snapshot_name (kfs_replica_handle_t R, long long log_pos, const char *replica_prefix);
 int close_snapshot (kfs_file_handle_t log_handle, int close_handle);
@@ -134,6 +164,19 @@ kfs_binlog_zip_header_t *load_binlog_zip_header (struct kfs_file_info *FI);
 int kfs_bz_get_chunks_no (long long orig_file_size);
 int kfs_bz_compute_header_size (long long orig_file_size);
 int kfs_bz_decode (kfs_file_handle_t F, long long off, void *dst, int *dest_len, int *disk_bytes_read);
+long long kfs_get_binlog_file_size (struct kfs_file_info *FI);
+
+/* streaming zipped binlogs */
+struct kfs_zs_index *kfs_zs_load_index (int fd, const char *filename);
+int kfs_zs_refresh_index (struct kfs_zs_index *Z, int fd, const char *filename);
+void kfs_zs_free_index (struct kfs_zs_index *Z);
+/* opens existing streaming zipped binlog for appending (drops trailer) or creates new one, returns -1 on failure */
+int kfs_zs_writer_open (kfs_zs_writer_t *W, const char *filename, kfs_bz_format_t format, int level, int frame_size, const char first36_bytes[36]);
+int kfs_zs_write (kfs_zs_writer_t *W, const void *data, int len);
+/* writes incomplete frame, after that readers see all written data */
+int kfs_zs_flush (kfs_zs_writer_t *W);
+/* seal != 0: writes frames index and trailer */
+int kfs_zs_writer_close (kfs_zs_writer_t *W, int seal, kfs_hash_t file_hash);
 int kfs_get_tag (unsigned char *start, int size, unsigned char tag[16]);
 int kfs_file_compute_initialization_vector (struct kfs_file_info *FI);
 
@@ -150,4 +193,32 @@ void kfs_buffer_crypt (kfs_file_handle_t F, void *buff, long long size, long lon
 /* for decryption snapshot in load_index functions */
 long long kfs_read_file (kfs_file_handle_t F, void *buff, long long size);
 
+/* maps size bytes from offset of F read-only instead of reading them into memory;
+   the mapping stays valid after F is closed, encrypted files are decrypted at once.
+   Returns NULL if mapping is disabled (--no-mmap-index) or impossible, then caller should read data. */
+void *kfs_mmap_file (kfs_file_handle_t F, long long offset, long long size);
+void kfs_munmap_file (void *ptr, long long size);
+/* immutable section of snapshot: mapped if possible, otherwise read (and decrypted) into zmalloc'ed memory,
+   which is never freed; bytes actually read are added to *loaded_bytes. File position is left at the end of section.
+   Returns NULL on short read. */
+void *kfs_load_file_section (kfs_file_handle_t F, long long offset, long long size, long long *loaded_bytes);
+extern int kfs_no_mmap;
+extern long long kfs_mapped_bytes;
+
+/* page cache hints: binlogs are replayed sequentially, snapshot metafiles are loaded randomly */
+#define KFS_ACCESS_NORMAL 0
+#define KFS_ACCESS_SEQUENTIAL 1
+#define KFS_ACCESS_RANDOM 2
+#define KFS_ACCESS_PATTERNS 3
+
+void kfs_set_access_pattern (kfs_file_handle_t F, int pattern);
+/* accounts size bytes read from F in kfs_read_bytes[F->access_pattern] */
+void kfs_account_read (kfs_file_handle_t F, long long size);
+/* drops already replayed pages before file_offset from page cache (sequential handles only) */
+void kfs_drop_behind (kfs_file_handle_t F, long long file_offset);
+/* starts asynchronous readahead of the range, engines call it for metafiles they are going to load soon */
+void kfs_prefetch_range (kfs_file_handle_t F, long long offset, long long size);
+extern int kfs_no_fadvise;
+extern long long kfs_read_bytes[KFS_ACCESS_PATTERNS], kfs_dropped_bytes, kfs_prefetched_bytes;
+
 #endif
@@ -1998,7 +1998,7 @@ int load_index (void) {
 
   if (crc32_check_mode) {
     assert (compute_crc32 (&Header, sizeof (Header) - 4) == Header.header_crc32);
-    assert (compute_crc32 (FileLists, (Header.tot_lists + 1) * file_list_index_entry_size) == Header.filelist_crc32);
+    assert (compute_crc32_parallel (FileLists, (Header.tot_lists + 1) * file_list_index_entry_size) == Header.filelist_crc32);
   }
   //revlist_metafile_mode = (Header.extra_mask & 1) && Header.tot_revlist_metafiles;
   vkprintf (1, "metafile_mode = %d\n", metafile_mode);
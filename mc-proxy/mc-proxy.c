@@ -296,6 +296,18 @@ static int cfg_getlex (void) {
       cfg_cur += 6;
       return cfg_lex = 'C';
     }
+    if (!memcmp (cfg_cur, "coalesce_window", 15)) {
+      cfg_cur += 15;
+      return cfg_lex = 'W';
+    }
+    if (!memcmp (cfg_cur, "cache_size", 10)) {
+      cfg_cur += 10;
+      return cfg_lex = 'K';
+    }
+    if (!memcmp (cfg_cur, "cache_ttl", 9)) {
+      cfg_cur += 9;
+      return cfg_lex = 'k';
+    }
     break;
   case 'd':
     if (!memcmp (cfg_cur, "disable", 7)) {
@@ -444,6 +456,9 @@ static int expect_lexem (int lexem) {
 #define Expect(l) { int t = expect_lexem (l); if (t < 0) { return t; } }
 
 static void build_mc_points (struct mc_cluster *C);
+void inflight_reset (void);
+void near_cache_free (struct mc_cluster *C);
+void near_cache_transfer (struct mc_config *MC, struct mc_config *MC_Old);
 
 void clear_config (struct mc_config *MC, int do_destroy_targets) {
   int i, j;
@@ -460,6 +475,7 @@ void clear_config (struct mc_config *MC, int do_destroy_targets) {
       free (C->points);
       C->points = 0;
     }
+    near_cache_free (C);
     if (C->cluster_name) {
       zfree (C->cluster_name, strlen (C->cluster_name) + 1);
       C->cluster_name = 0;
@@ -476,6 +492,7 @@ int parse_config (struct mc_config *MC, struct mc_config *MC_Old, int flags) {
   struct hostent *h;
   char *hostname;
   int dup_port_checked, cluster_disabled;
+  char *cluster_start;
 
   if (!(flags & 1)) {
     config_bytes = r = read (fd[0], config_buff, MAX_CONFIG_SIZE+1);
@@ -512,6 +529,7 @@ int parse_config (struct mc_config *MC, struct mc_config *MC_Old, int flags) {
     if (!l) {
       return syntax ("cluster name expected");
     }
+    cluster_start = cfg_cur;
     C->cluster_mode = default_cluster_mode;
     memcpy (&C->mc_proxy_inbound, &mc_proxy_inbound, sizeof (struct memcache_server_functions));
     C->mc_proxy_inbound.info = C;
@@ -534,10 +552,14 @@ int parse_config (struct mc_config *MC, struct mc_config *MC_Old, int flags) {
     C->port = 0;
     C->points_num = 0;
     C->crypto = 0;
+    C->coalesce_window = 0;
+    C->coalesce_inflight = 0;
+    C->cache_size = 0;
+    C->cache_ttl = 0.5;
     dup_port_checked = 0;
     cluster_disabled = 0;
-    C->a_req = C->a_rbytes = C->a_sbytes = C->a_timeouts = 0;
-    C->t_req = C->t_rbytes = C->t_sbytes = C->t_timeouts = 0;
+    C->a_req = C->a_rbytes = C->a_sbytes = C->a_timeouts = C->a_coalesced = 0;
+    C->t_req = C->t_rbytes = C->t_sbytes = C->t_timeouts = C->t_coalesced = C->t_coalesce_overflows = 0;
 
     if (!(flags & 1)) {
       C->other_cluster_no = -1;
@@ -772,6 +794,39 @@ int parse_config (struct mc_config *MC, struct mc_config *MC_Old, int flags) {
 
         vkprintf (1, "server #%d: ip %s, port %d\n", MC->ConfigServersCount, inet_ntoa (default_ct.target), default_ct.port);
         break;
+      case 'W':
+        C->coalesce_window = cfg_getint ();
+        if (C->coalesce_window < 0 || C->coalesce_window > 1000000) {
+          return syntax ("invalid coalesce window");
+        }
+        break;
+      case 'K':
+        C->cache_size = cfg_getint ();
+        switch (*cfg_cur | 0x20) {
+        case 'k':
+          C->cache_size <<= 10;
+          cfg_cur++;
+          break;
+        case 'm':
+          C->cache_size <<= 20;
+          cfg_cur++;
+          break;
+        case 'g':
+          C->cache_size <<= 30;
+          cfg_cur++;
+          break;
+        }
+        if (C->cache_size && (C->cache_size < (1 << 20) || C->cache_size > (1LL << 40))) {
+          return syntax ("invalid cache size");
+        }
+        break;
+      case 'k':
+        C->cache_ttl = cfg_getint ();
+        if (C->cache_ttl < 1 || C->cache_ttl > 3600000) {
+          return syntax ("invalid cache ttl");
+        }
+        C->cache_ttl /= 1000;
+        break;
       case 'X':
         C->max_connections = cfg_getint ();
         if (C->max_connections < C->min_connections || C->max_connections > 1000) {
@@ -800,6 +855,7 @@ int parse_config (struct mc_config *MC, struct mc_config *MC_Old, int flags) {
       Expect (';');
       cfg_getlex ();
     }
+    C->config_crc32 = compute_crc32 (cluster_start, cfg_cur - cluster_start);
     if (cluster_disabled) {
       if (verbosity > 1) {
 	fprintf (stderr, "Cluster #%d (%s) on port %d, mode %04x : DISABLED\n", C->cluster_no, C->cluster_name, C->port, C->cluster_mode);
@@ -829,6 +885,12 @@ int parse_config (struct mc_config *MC, struct mc_config *MC_Old, int flags) {
 	}
       }
     }
+    if (C->coalesce_window && (C->cluster_mode & -256)) {
+      return syntax ("coalesce_window can be used only in clusters without extensions");
+    }
+    if (C->cache_size && (C->cluster_mode & -256)) {
+      return syntax ("cache_size can be used only in clusters without extensions");
+    }
     if (C->points_num) {
       if ((C->cluster_mode & 255) != CLUSTER_MODE_MEMCACHED) {
         return syntax ("points can be defined for memcached mode clusters only");
@@ -986,11 +1048,14 @@ int do_reload_config (int create_conn) {
     transfer_listening_sockets (NextConf, CurConf);
   }
 
+  near_cache_transfer (NextConf, CurConf);
+
   struct mc_config *tmp = CurConf;
   CurConf = NextConf;
   NextConf = tmp;
 
   clear_config (NextConf, 1);
+  inflight_reset ();
 
   if (create_conn) {
     create_all_outbound_connections ();
@@ -1015,6 +1080,261 @@ void adjust_cluster_stats (void) {
     C->a_rbytes *= AMORT_FACTOR;
     C->a_sbytes *= AMORT_FACTOR;
     C->a_timeouts *= AMORT_FACTOR;
+    C->a_coalesced *= AMORT_FACTOR;
+  }
+}
+
+/*
+ *
+ *  NEAR CACHE
+ *
+ */
+
+/* complete "VALUE <key> <flags> <len>\r\n<data>\r\n" answers of upstream servers, kept for cache_ttl;
+   an item with data_len = 0 is a tombstone left by set/delete/incr: answers to gets sent
+   before the tombstone was created must not be cached */
+struct near_cache_item {
+  struct near_cache_item *hnext;
+  struct near_cache_item *next, *prev;	/* CLOCK ring */
+  double expires;
+  double invalidated_at;
+  unsigned key_hash;
+  int key_len, data_len;
+  int referenced;
+  char data[0];				/* key, then answer */
+};
+
+#define	NEAR_CACHE_FAILED_SLOTS	256
+
+struct near_cache {
+  struct near_cache_item **Hash;
+  int hash_size;
+  int items;
+  long long memory;
+  struct near_cache_item *hand;
+  double created_at;			/* answers to gets sent before this moment may miss a tombstone */
+  double failed_at[NEAR_CACHE_FAILED_SLOTS];	/* by key_hash: last invalidation whose tombstone did not fit */
+  long long hits, misses, stores, invalidations, evictions, invalidation_failures;
+};
+
+#define	NEAR_CACHE_MAX_ITEM	65536
+
+static inline long long near_cache_item_size (struct near_cache_item *I) {
+  return sizeof (struct near_cache_item) + I->key_len + I->data_len;
+}
+
+static struct near_cache *near_cache_create (struct mc_cluster *C) {
+  struct near_cache *N = calloc (1, sizeof (struct near_cache));
+  assert (N);
+  N->hash_size = 1024;
+  while (N->hash_size < (1 << 20) && N->hash_size * 256LL < C->cache_size) {
+    N->hash_size <<= 1;
+  }
+  N->Hash = calloc (N->hash_size, sizeof (void *));
+  assert (N->Hash);
+  N->created_at = precise_now;
+  return N;
+}
+
+static void near_cache_unlink (struct near_cache *N, struct near_cache_item *I) {
+  struct near_cache_item **p = &N->Hash[I->key_hash & (N->hash_size - 1)];
+  while (*p != I) {
+    assert (*p);
+    p = &(*p)->hnext;
+  }
+  *p = I->hnext;
+  if (I->next == I) {
+    N->hand = 0;
+  } else {
+    if (N->hand == I) {
+      N->hand = I->next;
+    }
+    I->next->prev = I->prev;
+    I->prev->next = I->next;
+  }
+  N->items--;
+  N->memory -= near_cache_item_size (I);
+  free (I);
+}
+
+static struct near_cache_item *near_cache_lookup (struct near_cache *N, const char *key, int key_len, unsigned key_hash) {
+  struct near_cache_item *I = N->Hash[key_hash & (N->hash_size - 1)];
+  while (I && !(I->key_hash == key_hash && I->key_len == key_len && !memcmp (I->data, key, key_len))) {
+    I = I->hnext;
+  }
+  if (I && I->expires <= precise_now) {
+    near_cache_unlink (N, I);
+    return 0;
+  }
+  return I;
+}
+
+/* CLOCK: free items until need more bytes fit, skipping (and un-marking) recently used ones */
+static void near_cache_evict (struct near_cache *N, long long limit, long long need) {
+  while (N->hand && N->memory + need > limit) {
+    struct near_cache_item *I = N->hand;
+    if (I->referenced && I->expires > precise_now) {
+      I->referenced = 0;
+      N->hand = I->next;
+    } else {
+      near_cache_unlink (N, I);
+      N->evictions++;
+    }
+  }
+}
+
+static struct near_cache_item *near_cache_insert (struct mc_cluster *C, const char *key, int key_len, unsigned key_hash, int data_len) {
+  struct near_cache *N = C->cache;
+  long long size = sizeof (struct near_cache_item) + key_len + data_len;
+  near_cache_evict (N, C->cache_size, size);
+  if (N->memory + size > C->cache_size) {
+    return 0;
+  }
+  struct near_cache_item *I = malloc (size);
+  assert (I);
+  I->key_hash = key_hash;
+  I->key_len = key_len;
+  I->data_len = data_len;
+  I->referenced = 0;
+  memcpy (I->data, key, key_len);
+  I->hnext = N->Hash[key_hash & (N->hash_size - 1)];
+  N->Hash[key_hash & (N->hash_size - 1)] = I;
+  if (N->hand) {
+    /* new item is the last one the hand reaches */
+    I->next = N->hand;
+    I->prev = N->hand->prev;
+    I->prev->next = I;
+    N->hand->prev = I;
+  } else {
+    N->hand = I->next = I->prev = I;
+  }
+  N->items++;
+  N->memory += size;
+  return I;
+}
+
+static unsigned near_cache_hash (const char *key, int key_len) {
+  return compute_crc32 (key, key_len);
+}
+
+/* returns 1 and writes the cached answer to c->Out on hit */
+static int near_cache_get (struct mc_cluster *C, struct connection *c, const char *key, int key_len) {
+  if (!C->cache) {
+    C->cache = near_cache_create (C);
+  }
+  struct near_cache_item *I = near_cache_lookup (C->cache, key, key_len, near_cache_hash (key, key_len));
+  if (!I || !I->data_len) {
+    C->cache->misses++;
+    return 0;
+  }
+  I->referenced = 1;
+  C->cache->hits++;
+  write_out (&c->Out, I->data + I->key_len, I->data_len);
+  return 1;
+}
+
+/* upstream connection c got a VALUE answer of len bytes for a get started at query_start_time */
+static void near_cache_store (struct mc_cluster *C, struct connection *c, int len, double query_start_time) {
+  struct mcc_data *D = MCC_DATA(c);
+  static char key[MAX_KEY_LEN + 4];
+  if (len > NEAR_CACHE_MAX_ITEM || len > C->cache_size / 16 || D->key_len > MAX_KEY_LEN) {
+    return;
+  }
+  if (!C->cache) {
+    C->cache = near_cache_create (C);
+  }
+  nb_iterator_t R;
+  nbit_set (&R, &c->In);
+  assert (nbit_advance (&R, D->key_offset) == D->key_offset);
+  int key_len = nbit_read_in (&R, key, D->key_len);
+  unsigned key_hash = near_cache_hash (key, key_len);
+  if (query_start_time < C->cache->created_at || query_start_time <= C->cache->failed_at[key_hash & (NEAR_CACHE_FAILED_SLOTS - 1)]) {
+    return;
+  }
+  struct near_cache_item *I = near_cache_lookup (C->cache, key, key_len, key_hash);
+  if (I) {
+    if (!I->data_len && I->invalidated_at >= query_start_time) {
+      return;
+    }
+    near_cache_unlink (C->cache, I);
+  }
+  I = near_cache_insert (C, key, key_len, key_hash, len);
+  if (!I) {
+    return;
+  }
+  I->expires = precise_now + C->cache_ttl;
+  I->invalidated_at = 0;
+  nbit_set (&R, &c->In);
+  assert (nbit_read_in (&R, I->data + key_len, len) == len);
+  C->cache->stores++;
+}
+
+/* set/add/replace/incr/decr/delete of key passes through cluster C */
+static void near_cache_invalidate (struct mc_cluster *C, const char *key, int key_len) {
+  if (!C->cache) {
+    return;
+  }
+  unsigned key_hash = near_cache_hash (key, key_len);
+  struct near_cache_item *I = near_cache_lookup (C->cache, key, key_len, key_hash);
+  if (I) {
+    near_cache_unlink (C->cache, I);
+  }
+  I = near_cache_insert (C, key, key_len, key_hash, 0);
+  if (I) {
+    /* answers may still be in flight for get_timeout */
+    I->invalidated_at = precise_now;
+    I->expires = precise_now + C->get_timeout + 0.2;
+  } else {
+    /* no room for the tombstone: refuse in-flight answers for every key sharing its slot */
+    C->cache->failed_at[key_hash & (NEAR_CACHE_FAILED_SLOTS - 1)] = precise_now;
+    C->cache->invalidation_failures++;
+  }
+  C->cache->invalidations++;
+}
+
+void near_cache_free (struct mc_cluster *C) {
+  struct near_cache *N = C->cache;
+  if (!N) {
+    return;
+  }
+  while (N->hand) {
+    near_cache_unlink (N, N->hand);
+  }
+  free (N->Hash);
+  free (N);
+  C->cache = 0;
+}
+
+static int same_cluster_servers (struct mc_cluster *C, struct mc_cluster *OC) {
+  int i;
+  if (C->tot_buckets != OC->tot_buckets) {
+    return 0;
+  }
+  for (i = 0; i < C->tot_buckets; i++) {
+    if (C->buckets[i]->target.s_addr != OC->buckets[i]->target.s_addr || C->buckets[i]->port != OC->buckets[i]->port) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* on config reload, a cluster listening on the same port with identical definition keeps its near cache */
+void near_cache_transfer (struct mc_config *MC, struct mc_config *MC_Old) {
+  int i;
+  for (i = 0; i < MC->clusters_num; i++) {
+    struct mc_cluster *C = &MC->Clusters[i];
+    int j = C->other_cluster_no;
+    if (j < 0 || !C->cache_size) {
+      continue;
+    }
+    assert (j < MC_Old->clusters_num);
+    struct mc_cluster *OC = &MC_Old->Clusters[j];
+    if (OC->cache && OC->config_crc32 == C->config_crc32 && OC->cache_size == C->cache_size && same_cluster_servers (C, OC)) {
+      vkprintf (1, "cluster %s keeps its near cache (%d items) across config reload\n", C->cluster_name, OC->cache->items);
+      assert (!C->cache);
+      C->cache = OC->cache;
+      OC->cache = 0;
+    }
   }
 }
 
@@ -1671,6 +1991,10 @@ int proxy_server_execute (struct connection *c, int op) {
       fprintf (stderr, "mc_set: op=%d, key '%s', key_len=%d, flags=%lld, time=%lld, value_len=%lld\n", op, key_buffer, D->key_len, D->args[0], D->args[1], D->args[2]);
     }
 
+    if (CC->cache_size) {
+      near_cache_invalidate (CC, key_buffer, D->key_len);
+    }
+
 #ifdef SEARCH_MODE_ENABLED
     if (MERGE_EXTENSION && search_check (mct_set, key_buffer, D->key_len)) {
       advance_skip_read_ptr (&c->In, D->query_len);
@@ -1851,6 +2175,10 @@ int proxy_server_execute (struct connection *c, int op) {
       fprintf (stderr, "mc_incr: op=%d, key '%s', key_len=%d, arg=%lld\n", op, key_buffer, D->key_len, D->args[0]);
     }
 
+    if (CC->cache_size) {
+      near_cache_invalidate (CC, key_buffer, D->key_len);
+    }
+
     if (LISTS_EXTENSION && op == mct_delete && D->key_len >= 6 && !strncmp (key_buffer, "object", 6)) {
       diagonal_forward = 1;
     }
@@ -1903,15 +2231,23 @@ int proxy_server_execute (struct connection *c, int op) {
         break;
       }
       len = 0;
-      while (ptr < ptr_e && *ptr != ' ' && *ptr != '\t' && *ptr != '\r' && *ptr != '\n') {
-        if (len <= MAX_KEY_LEN) {
-          key_buffer[len++] = *ptr;
+      while (1) {
+        char *q = mc_scan_word_end (ptr, ptr_e);
+        int l = q - ptr;
+        if (l > MAX_KEY_LEN + 1 - len) {
+          l = MAX_KEY_LEN + 1 - len;
         }
-        ptr++;
+        memcpy (key_buffer + len, ptr, l);
+        len += l;
+        ptr = q;
+        if (ptr < ptr_e) {
+          break;
+        }
+        advance_read_ptr (&c->In, ptr - ptr_s);
+        ptr = ptr_s = get_read_ptr (&c->In);
+        ptr_e = ptr + get_ready_bytes (&c->In);
         if (ptr == ptr_e) {
-          advance_read_ptr (&c->In, ptr - ptr_s);
-          ptr = ptr_s = get_read_ptr (&c->In);
-          ptr_e = ptr + get_ready_bytes (&c->In);
+          break;
         }
       }
       assert (ptr < ptr_e);
@@ -2019,7 +2355,21 @@ int mcp_prepare_stats (struct connection *c, char *stats_buffer, int stats_buffe
     "errors_received\t%lld\n"
     "client_errors_received\t%lld\n"
     "total_failed_connections\t%lld\n"
-    "total_connect_failures\t%lld\n",
+    "total_connect_failures\t%lld\n"
+    "coalesce_window\t%d\n"
+    "coalesce_inflight_keys\t%d\n"
+    "coalesced_get_keys\t%lld\n"
+    "coalesce_window_overflows\t%lld\n"
+    "near_cache_size\t%lld\n"
+    "near_cache_ttl\t%.3f\n"
+    "near_cache_items\t%d\n"
+    "near_cache_memory\t%lld\n"
+    "near_cache_hits\t%lld\n"
+    "near_cache_misses\t%lld\n"
+    "near_cache_stores\t%lld\n"
+    "near_cache_invalidations\t%lld\n"
+    "near_cache_evictions\t%lld\n"
+    "near_cache_invalidation_failures\t%lld\n",
     (long)(dyn_cur - dyn_first),
     (long)(dyn_last - dyn_first),
     wasted_blocks,
@@ -2049,7 +2399,21 @@ int mcp_prepare_stats (struct connection *c, char *stats_buffer, int stats_buffe
     errors_received,
     client_errors_received,
     total_failed_connections,
-    total_connect_failures);
+    total_connect_failures,
+    CC->coalesce_window,
+    CC->coalesce_inflight,
+    CC->t_coalesced,
+    CC->t_coalesce_overflows,
+    CC->cache_size,
+    CC->cache_ttl,
+    CC->cache ? CC->cache->items : 0,
+    CC->cache ? CC->cache->memory : 0,
+    CC->cache ? CC->cache->hits : 0,
+    CC->cache ? CC->cache->misses : 0,
+    CC->cache ? CC->cache->stores : 0,
+    CC->cache ? CC->cache->invalidations : 0,
+    CC->cache ? CC->cache->evictions : 0,
+    CC->cache ? CC->cache->invalidation_failures : 0);
 #ifdef SEARCH_MODE_ENABLED
   stats_len += search_stats (stats_buffer + stats_len, stats_buffer_len - stats_len);
 #endif
@@ -2193,13 +2557,13 @@ int mcp_get_clusters_stats (struct connection *c, const char *key, int key_len)
   char *stats_buff_ptr = stats_buff;
   struct mc_cluster *C = CurConf->Clusters;
  
-  stats_buff_ptr += sprintf (stats_buff_ptr, "Port\tBuckets\tReq*\tTX*\tRX*\tTOut*\tTot_Req\tTot_TX\tTot_RX\tTot_T/O\tName\n");
+  stats_buff_ptr += sprintf (stats_buff_ptr, "Port\tBuckets\tReq*\tTX*\tRX*\tTOut*\tCoal*\tTot_Req\tTot_TX\tTot_RX\tTot_T/O\tTot_Coal\tName\n");
   for (i = 0; i < CurConf->clusters_num; i++, C++) {
     assert (stats_buff_ptr < stats_buff + STATS_BUFF_SIZE - 1024);
-    stats_buff_ptr += sprintf (stats_buff_ptr, "%d\t%d\t%.1f\t%.1f\t%.1f\t%.1f\t%lld\t%lld\t%lld\t%lld\t%s\n",
+    stats_buff_ptr += sprintf (stats_buff_ptr, "%d\t%d\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f\t%lld\t%lld\t%lld\t%lld\t%lld\t%s\n",
 			       C->port, C->tot_buckets,
-			       C->a_req, C->a_sbytes, C->a_rbytes, C->a_timeouts,
-			       C->t_req, C->t_sbytes, C->t_rbytes, C->t_timeouts,
+			       C->a_req, C->a_sbytes, C->a_rbytes, C->a_timeouts, C->a_coalesced,
+			       C->t_req, C->t_sbytes, C->t_rbytes, C->t_timeouts, C->t_coalesced,
 			       C->cluster_name);
   }
   return return_one_key (c, key, stats_buff, stats_buff_ptr - stats_buff);
@@ -2273,9 +2637,201 @@ struct conn_query *create_query_type (struct connection *d, struct connection *c
   return Q;
 }
 
+/*
+ *
+ *  IN-FLIGHT GET COALESCING
+ *
+ */
+
+/* a get key already forwarded upstream (by the "leader" connection) and not yet answered;
+   gets for the same key in the same cluster wait for its VALUE instead of forwarding it again */
+struct mcp_inflight {
+  struct mcp_inflight *hnext;		/* chain in InflightByKey, valid while hashed */
+  struct mcp_inflight *qnext;		/* chain in InflightByQuery / get_inflight[] */
+  struct mc_cluster *cluster;		/* 0 after configuration reload */
+  struct conn_query *q;			/* upstream get query carrying the key, 0 until mcp_get_end() */
+  struct conn_query waiters;		/* list head, only next/prev are used */
+  int hashed;
+  int key_len;
+  unsigned key_hash;
+  char key[0];
+};
+
+#define	INFLIGHT_HASH_SIZE	(1 << 16)
+
+struct mcp_inflight *InflightByKey[INFLIGHT_HASH_SIZE], *InflightByQuery[INFLIGHT_HASH_SIZE];
+int inflight_entries;
+
+int delete_waiter_query (struct conn_query *q);
+
+conn_query_type_t proxy_waiter_query_type = {
+.magic = CQUERY_FUNC_MAGIC,
+.title = "mc-proxy-coalesced-get",
+.parse_execute = server_failed,
+.close = delete_waiter_query,
+.wakeup = delete_waiter_query
+};
+
+static inline unsigned inflight_query_bucket (struct conn_query *q) {
+  return (unsigned) (((unsigned long) q >> 4) * 0x9e3779b1U) >> 16;
+}
+
+static void inflight_unhash (struct mcp_inflight *e) {
+  struct mcp_inflight **p = &InflightByKey[e->key_hash & (INFLIGHT_HASH_SIZE - 1)];
+  while (*p != e) {
+    assert (*p);
+    p = &(*p)->hnext;
+  }
+  *p = e->hnext;
+  e->hashed = 0;
+}
+
+static struct mcp_inflight *inflight_lookup (struct mc_cluster *C, const char *key, int key_len, unsigned key_hash) {
+  struct mcp_inflight *e = InflightByKey[key_hash & (INFLIGHT_HASH_SIZE - 1)];
+  while (e && !(e->key_hash == key_hash && e->cluster == C && e->key_len == key_len && !memcmp (e->key, key, key_len))) {
+    e = e->hnext;
+  }
+  return e;
+}
+
+static struct mcp_inflight *inflight_create (struct mc_cluster *C, const char *key, int key_len, unsigned key_hash) {
+  struct mcp_inflight *e = zmalloc (sizeof (struct mcp_inflight) + key_len);
+  e->cluster = C;
+  e->q = 0;
+  e->waiters.next = e->waiters.prev = &e->waiters;
+  e->key_len = key_len;
+  e->key_hash = key_hash;
+  memcpy (e->key, key, key_len);
+  e->hnext = InflightByKey[key_hash & (INFLIGHT_HASH_SIZE - 1)];
+  InflightByKey[key_hash & (INFLIGHT_HASH_SIZE - 1)] = e;
+  e->hashed = 1;
+  C->coalesce_inflight++;
+  inflight_entries++;
+  return e;
+}
+
+/* completes all waiters (each one wakes its connection when it was the last pending query) and frees e */
+static void inflight_release (struct mcp_inflight *e) {
+  while (e->waiters.next != &e->waiters) {
+    struct conn_query *W = e->waiters.next;
+    struct connection *d = W->requester;
+    if (d->generation == W->req_generation) {
+      d->queries_ok++;
+      MCS_DATA(d)->complete_count++;
+    }
+    delete_conn_query (W);
+    zfree (W, sizeof (*W));
+  }
+  if (e->hashed) {
+    inflight_unhash (e);
+  }
+  if (e->cluster) {
+    e->cluster->coalesce_inflight--;
+  }
+  inflight_entries--;
+  zfree (e, sizeof (struct mcp_inflight) + e->key_len);
+}
+
+static void inflight_join (struct mcp_inflight *e, struct connection *c) {
+  struct conn_query *W = zmalloc (sizeof (struct conn_query));
+  W->custom_type = mct_get;
+  W->outbound = 0;
+  W->requester = c;
+  W->start_time = c->query_start_time;
+  W->extra = e;
+  W->cq_type = &proxy_waiter_query_type;
+  W->timer.wakeup_time = 0;
+  insert_conn_query_into_list (W, &e->waiters);
+  e->cluster->a_coalesced++;
+  e->cluster->t_coalesced++;
+}
+
+int delete_waiter_query (struct conn_query *q) {
+  delete_conn_query (q);
+  zfree (q, sizeof (*q));
+  return 0;
+}
+
+/* attaches the entries created for one upstream connection in mcp_get() to the query sent there */
+static void inflight_attach (struct mcp_inflight *e, struct conn_query *Q) {
+  unsigned b = inflight_query_bucket (Q);
+  while (e) {
+    struct mcp_inflight *n = e->qnext;
+    e->q = Q;
+    e->qnext = InflightByQuery[b];
+    InflightByQuery[b] = e;
+    e = n;
+  }
+}
+
+/* upstream query Q is answered, failed or dropped: nothing more will arrive for its keys */
+void inflight_query_done (struct conn_query *Q) {
+  struct mcp_inflight **p = &InflightByQuery[inflight_query_bucket (Q)], *e;
+  while ((e = *p) != 0) {
+    if (e->q == Q) {
+      *p = e->qnext;
+      inflight_release (e);
+    } else {
+      p = &e->qnext;
+    }
+  }
+}
+
+/* VALUE of response_len bytes for the first query of upstream connection c is at the start of c->In:
+   copy it to all connections waiting for this key */
+void inflight_value (struct connection *c, int response_len) {
+  struct mcc_data *D = MCC_DATA(c);
+  struct conn_query *Q = c->first_query;
+  struct mcp_inflight **p = &InflightByQuery[inflight_query_bucket (Q)], *e;
+  static char key[MAX_KEY_LEN + 4];
+  int key_len = -1;
+  while ((e = *p) != 0) {
+    if (e->q == Q) {
+      if (key_len < 0) {
+        nb_iterator_t R;
+        nbit_set (&R, &c->In);
+        assert (nbit_advance (&R, D->key_offset) == D->key_offset);
+        key_len = nbit_read_in (&R, key, D->key_len);
+      }
+      if (e->key_len == key_len && !memcmp (e->key, key, key_len)) {
+        struct conn_query *W;
+        for (W = e->waiters.next; W != &e->waiters; W = W->next) {
+          struct connection *d = W->requester;
+          if (d->generation == W->req_generation) {
+            assert (copy_through_nondestruct (&d->Out, &c->In, response_len) == response_len);
+            if (e->cluster) {
+              e->cluster->a_rbytes += response_len;
+              e->cluster->t_rbytes += response_len;
+            }
+          }
+        }
+        *p = e->qnext;
+        inflight_release (e);
+        return;
+      }
+    }
+    p = &e->qnext;
+  }
+}
+
+/* after configuration reload old clusters are cleared: stop coalescing into their entries */
+void inflight_reset (void) {
+  int i;
+  for (i = 0; i < INFLIGHT_HASH_SIZE; i++) {
+    struct mcp_inflight *e = InflightByKey[i];
+    while (e) {
+      e->hashed = 0;
+      e->cluster = 0;
+      e = e->hnext;
+    }
+    InflightByKey[i] = 0;
+  }
+}
+
 int get_targets = 0, get_keys = 0, get_search_queries = 0;
 struct conn_target *get_target[MAX_CLUSTER_SERVERS];
 struct connection *get_connection[MAX_CLUSTER_SERVERS];
+struct mcp_inflight *get_inflight[MAX_CLUSTER_SERVERS];
 
 int mcp_get_start (struct connection *c) {
   get_targets = 0;
@@ -2350,6 +2906,30 @@ int mcp_get (struct connection *c, const char *key, int key_len) {
     return 1;
   }
 #endif
+  if (CC->cache_size && !c->Tmp && near_cache_get (CC, c, key, key_len)) {
+    if (verbosity > 1) {
+      fprintf (stderr, "proxy_get (%.*s): near cache hit\n", key_len, key);
+    }
+    return 1;
+  }
+  struct mcp_inflight *e = 0;
+  unsigned key_hash = 0;
+  if (CC->coalesce_window) {
+    key_hash = compute_crc32 (key, key_len) + CC->cluster_no;
+    e = inflight_lookup (CC, key, key_len, key_hash);
+    if (e && (!e->q || e->q->start_time + CC->get_timeout > precise_now)) {
+      if (verbosity > 1) {
+        fprintf (stderr, "proxy_get (%.*s): waiting for in-flight query %p\n", key_len, key, e->q);
+      }
+      inflight_join (e, c);
+      get_keys++;
+      return 1;
+    }
+    if (e) {
+      /* upstream answer is late: do not let new gets wait for it */
+      inflight_unhash (e);
+    }
+  }
   struct conn_target *S = calculate_key_target (key, key_len);
   struct connection *d;
   int x;
@@ -2383,6 +2963,7 @@ int mcp_get (struct connection *c, const char *key, int key_len) {
     S->custom_field = x+1;
     get_target[x] = S;
     get_connection[x] = d;
+    get_inflight[x] = 0;
     if (/*get_targets == 1 && */ c->Tmp) {
       int query_len = get_total_ready_bytes (c->Tmp);
       assert (copy_through_nondestruct (&d->Out, c->Tmp, query_len) == query_len);
@@ -2407,6 +2988,16 @@ int mcp_get (struct connection *c, const char *key, int key_len) {
   CC->a_sbytes += key_len;
   CC->t_sbytes += key_len;
   get_keys++;
+  if (CC->coalesce_window) {
+    if (CC->coalesce_inflight < CC->coalesce_window) {
+      e = inflight_create (CC, key, key_len, key_hash);
+      x = S->custom_field - 1;
+      e->qnext = get_inflight[x];
+      get_inflight[x] = e;
+    } else {
+      CC->t_coalesce_overflows++;
+    }
+  }
   return 1;
 }
 
@@ -2418,6 +3009,12 @@ int mcp_get_end (struct connection *c, int key_count) {
   }
   if (!get_targets) {
     free_tmp_buffers (c);
+    if (c->pending_queries) {
+      /* all keys are coalesced with gets of other connections */
+      c->status = conn_wait_net;
+      set_connection_timeout (c, CC->get_timeout);
+      return 0;
+    }
     write_out (&c->Out, "END\r\n", 5);
     return 0;
   }
@@ -2436,10 +3033,19 @@ int mcp_get_end (struct connection *c, int key_count) {
       if (/* !i && */ c->Tmp) {
         Q->custom_type |= 0x1000;
       }
+      if (get_inflight[i]) {
+        inflight_attach (get_inflight[i], Q);
+        get_inflight[i] = 0;
+      }
       flush_output (d);
       d->last_query_sent_time = precise_now;
       accumulate_query_timeout (d, CC->get_timeout);
     }
+    while (get_inflight[i]) {
+      struct mcp_inflight *e = get_inflight[i];
+      get_inflight[i] = e->qnext;
+      inflight_release (e);
+    }
   }
   set_connection_timeout (c, CC->get_timeout);
   free_tmp_buffers (c);
@@ -2500,6 +3106,9 @@ int query_complete (struct connection *c, int ok) {
   struct conn_query *q = c->first_query;
   struct connection *d = c->first_query->requester;
   assert (d);
+  if (inflight_entries) {
+    inflight_query_done (q);
+  }
   if (d->generation == c->first_query->req_generation) {
     d->queries_ok += ok;
     MCS_DATA(d)->complete_count++;
@@ -2516,6 +3125,9 @@ int query_complete_custom (struct conn_query *q, int ok) {
   struct connection *d = q->requester;
   assert (d);
   assert (c);
+  if (inflight_entries) {
+    inflight_query_done (q);
+  }
   if (d->generation == q->req_generation) {
     d->queries_ok += ok;
     MCS_DATA(d)->complete_count++;
@@ -2528,6 +3140,9 @@ int query_complete_custom (struct conn_query *q, int ok) {
 }
 
 int delete_query (struct conn_query *q) {
+  if (inflight_entries) {
+    inflight_query_done (q);
+  }
   active_queries--;
   delete_conn_query (q);
   zfree (q, sizeof (*q));
@@ -2650,6 +3265,16 @@ int proxy_client_execute (struct connection *c, int op) {
     }
 #endif
     if (!search_mode) {
+      struct conn_query *Q = c->first_query;
+      if (Q->requester->generation == Q->req_generation) {
+        struct mc_cluster *C = ((struct memcache_server_functions *) Q->requester->extra)->info;
+        if (C->cache_size) {
+          near_cache_store (C, c, D->response_len + D->args[1] + len, Q->start_time);
+        }
+      }
+      if (inflight_entries) {
+        inflight_value (c, D->response_len + D->args[1] + len);
+      }
       forward_response (c, D->response_len + D->args[1] + len);
     } else {
 #ifdef SEARCH_MODE_ENABLED
@@ -3013,7 +3638,7 @@ void start_server (void) {
  */
 
 void usage (void) {
-  printf ("usage: %s [-v] [-p<port>] [-u<username>] [-b<backlog>] [-c<max-conn>] [-l<log-name>] [-F] [-X <extension>] [-P <passfile>] [-y <default-min-connections] [-z <default-max-connections>] [-f] <cluster-descr-file>\n"
+  printf ("usage: %s [-v] [-p<port>] [-u<username>] [-b<backlog>] [-c<max-conn>] [-l<log-name>] [-F] [-X <extension>] [-P <passfile>] [-y <default-min-connections] [-z <default-max-connections>] [-f] [-W] <cluster-descr-file>\n"
 	  "\t" VERSION_STR " compiled at " __DATE__ " " __TIME__ " by gcc " __VERSION__ " "
 #ifdef __LP64__
 	  "64-bit"
@@ -3030,7 +3655,8 @@ void usage (void) {
 	  "\t-T<ping-interval>\tsets ping interval for remote servers (default: %.1f)\n"
 	  "\t-y\tdefines default minimum number of connections (default: 2)\n"
 	  "\t-z\tdefines default maximum number of connections (default: 3)\n"
-	  "\t-P\tpath to file with AES encryption key\n",
+	  "\t-P\tpath to file with AES encryption key\n"
+	  "\t-W\tbatch writes: send everything queued to a connection during one event loop iteration in one syscall\n",
 	  progname,
 	  (double) PING_INTERVAL);
   exit(2);
@@ -3045,7 +3671,7 @@ int main (int argc, char *argv[]) {
 
   progname = argv[0];
   char *custom_encr = 0;
-  while ((i = getopt (argc, argv, "b:c:l:p:n:dhu:vfFP:X:E:H:T:y:z:")) != -1) {
+  while ((i = getopt (argc, argv, "b:c:l:p:n:dhu:vfFP:X:E:H:T:y:z:W")) != -1) {
     switch (i) {
     case 'v':
       verbosity++;
@@ -3102,6 +3728,9 @@ int main (int argc, char *argv[]) {
     case 'P':
       aes_pwd_file = optarg;
       break;
+    case 'W':
+      conn_write_batching = 1;
+      break;
     case 'X':
       strncpy (extension_name, optarg, 15);
       if (!strcmp (optarg, "text")) {
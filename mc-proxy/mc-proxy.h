@@ -105,6 +105,8 @@
 
 typedef struct mc_point mc_point_t;
 
+struct near_cache;
+
 struct mc_point {
   unsigned long long x;
   struct conn_target *target;
@@ -127,8 +129,13 @@ struct mc_cluster {
   struct connection *listening_connection;
   struct conn_target *buckets[MAX_CLUSTER_SERVERS];
   double get_timeout, set_timeout;
-  double a_req, a_rbytes, a_sbytes, a_timeouts;
-  long long t_req, t_rbytes, t_sbytes, t_timeouts;
+  int coalesce_window, coalesce_inflight;	/* max/current in-flight get keys that later gets may share */
+  long long cache_size;				/* near cache memory limit, 0 = no near cache */
+  double cache_ttl;
+  struct near_cache *cache;
+  unsigned config_crc32;			/* of the cluster definition text, to detect unchanged clusters on reload */
+  double a_req, a_rbytes, a_sbytes, a_timeouts, a_coalesced;
+  long long t_req, t_rbytes, t_sbytes, t_timeouts, t_coalesced, t_coalesce_overflows;
 };
 
 extern struct mc_cluster *CC;
@@ -161,10 +161,11 @@ int memcache_delete (struct connection *c, const char *key, int key_len);
 int memcache_stats (struct connection *c);
 int memcache_get_start (struct connection *c);
 int memcache_get_end (struct connection *c, int key_count);
+int money_engine_execute (struct connection *c, int op);
 
 
 struct memcache_server_functions memcache_methods = {
-  .execute = mcs_execute,
+  .execute = money_engine_execute,
   .mc_store = memcache_store,
   .mc_get_start = memcache_get_start,
   .mc_get = memcache_get,
@@ -564,6 +565,7 @@ int memcache_store (struct connection *c, int op, const char *key, int key_len,
 
 int memcache_stats (struct connection *c) {
   int len = money_prepare_stats ();
+  len += binlog_group_commit_stats (stats_buff + len, STATS_BUFF_SIZE - len);
   int len2 = prepare_stats (c, stats_buff + len, STATS_BUFF_SIZE - len);
   write_out (&c->Out, stats_buff, len + len2);
   write_out (&c->Out, "END\r\n", 5);
@@ -1063,6 +1065,16 @@ int memcache_delete (struct connection *c, const char *key, int key_len) {
 }
 
 
+/* with group commit, an answer which might depend on events not yet on disk
+   is kept in the output buffer until these events are fdatasync()'ed */
+int money_engine_execute (struct connection *c, int op) {
+  int res = mcs_execute (c, op);
+  if (binlog_group_commit && log_last_pos () > log_durable_pos) {
+    binlog_commit_request (release_connection_output, c, hold_connection_output (c));
+  }
+  return res;
+}
+
 int money_engine_wakeup (struct connection *c) {
 //  struct mcs_data *D = MCS_DATA(c);
   return 0;
@@ -1218,7 +1230,7 @@ void start_server (void) {
 	       active_connections, maxconn, NB_used, NB_alloc, NB_max);
     }
 
-    epoll_work (10);
+    epoll_work (binlog_commit_pending () ? 1 : 10);
 
     if (sigpoll_cnt > 0) {
       vkprintf (2, "after epoll_work(), sigpoll_cnt=%d\n", sigpoll_cnt);
@@ -1242,6 +1254,8 @@ void start_server (void) {
       epoll_pre_event();
     }
 
+    binlog_group_commit_work ();
+
     if (now > quit_at && quit_at) break;
   }
 
@@ -1260,7 +1274,7 @@ void start_server (void) {
  */
 
 void usage (void) {
-  printf ("usage: %s [-v] [-r] [-M] [-S<rem>,<mod>,<master-host>:<port>] [-p<port>] [-i<acc-id>] [-u<username>] [-b<backlog>] [-c<max-conn>] [-a<binlog-name>] [-t<cutoff-time>] [-l<log-name>] <index-file>\n"
+  printf ("usage: %s [-v] [-r] [-M] [-D<max-delay-ms>] [-S<rem>,<mod>,<master-host>:<port>] [-p<port>] [-i<acc-id>] [-u<username>] [-b<backlog>] [-c<max-conn>] [-a<binlog-name>] [-t<cutoff-time>] [-l<log-name>] <index-file>\n"
   	  "\t" VERSION_STR " compiled at " __DATE__ " " __TIME__ " by gcc " __VERSION__ " "
 #ifdef __LP64__
 	  "64-bit"
@@ -1275,6 +1289,7 @@ void usage (void) {
 	  "\t-S<rem>,<mod>,<master-host>:<port>\tenables slave mode; connect to master at <master-host>:<port>\n"
 	  "\t-H<heap-size>\tdefines maximum heap size\n"
 	  "\t-B<max-binlog-size>\tdefines maximum size of each binlog file\n"
+	  "\t-D<max-delay-ms>\tgroup commit: answers are sent only after binlog fdatasync(), updates wait at most <max-delay-ms> to be batched\n"
 	  "\t-r\tread-only binlog (don't log new events)\n",
 	  progname);
   exit(2);
@@ -1290,7 +1305,7 @@ int main (int argc, char *argv[]) {
   progname = argv[0];
   max_binlog_size = (1LL << 62);
 
-  while ((i = getopt (argc, argv, "a:b:c:dhi:l:p:rt:u:vB:H:MS:")) != -1) {
+  while ((i = getopt (argc, argv, "a:b:c:dhi:l:p:rt:u:vB:D:H:MS:")) != -1) {
     switch (i) {
     case 'v':
       verbosity++;
@@ -1325,6 +1340,13 @@ int main (int argc, char *argv[]) {
     case 'a':
       binlogname = optarg;
       break;
+    case 'D':
+      binlog_group_commit = 1;
+      binlog_commit_delay = atof (optarg) * 0.001;
+      if (binlog_commit_delay < 0 || binlog_commit_delay > 1) {
+        usage ();
+      }
+      break;
     case 'M':
       assert (!master_slave_mode);
       master_slave_mode = 1;
@@ -32,6 +32,10 @@
 #include <aio.h>
 #include <netdb.h>
 #include <signal.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <linux/io_uring.h>
 
 #include "kdb-data-common.h"
 #include "crc32.h"
@@ -44,8 +48,190 @@
 extern int verbosity;
 
 long long tot_aio_queries = 0, active_aio_queries = 0, expired_aio_queries = 0;
+long long tot_aio_uring_queries = 0, tot_aio_uring_submits = 0, tot_aio_uring_posix_retries = 0;
 double total_aio_time;
 
+/*
+ * io_uring backend
+ *
+ * Reads are queued into the submission ring and submitted in one io_uring_enter()
+ * per event loop iteration (from check_all_aio_completions). Completions are signalled
+ * through an eventfd registered in epoll, so no SIGPOLL is raised and no glibc helper
+ * threads are involved.
+ */
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup	425
+#define __NR_io_uring_enter	426
+#define __NR_io_uring_register	427
+#endif
+
+#define	AIO_URING_ENTRIES	1024
+
+int aio_uring_enabled;
+
+static int aio_backend = -1;
+
+static struct {
+  int fd, event_fd, event_registered;
+  int to_submit, in_flight;
+  unsigned sq_entries, cq_entries;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+} U = { .fd = -1, .event_fd = -1 };
+
+static int aio_uring_reap (void);
+static void aio_posix_read (struct aio_connection *a);
+
+static int aio_uring_eventfd_handler (int fd, void *data, event_t *ev) {
+  long long x;
+  while (read (fd, &x, 8) == 8) {
+  }
+  aio_uring_reap ();
+  return EVA_CONTINUE;
+}
+
+static void aio_uring_register_eventfd (void) {
+  if (U.event_fd < 0 || U.event_registered || !epoll_fd) {
+    return;
+  }
+  epoll_sethandler (U.event_fd, 0, aio_uring_eventfd_handler, 0);
+  epoll_insert (U.event_fd, EVT_READ);
+  U.event_registered = 1;
+}
+
+/* IORING_OP_READ appeared in 5.6 together with IORING_REGISTER_PROBE,
+   on older kernels io_uring_setup succeeds, but every read completes with -EINVAL */
+static int aio_uring_read_supported (int fd) {
+  struct {
+    struct io_uring_probe probe;
+    struct io_uring_probe_op ops[IORING_OP_READ + 1];
+  } P;
+  memset (&P, 0, sizeof (P));
+  if (syscall (__NR_io_uring_register, fd, IORING_REGISTER_PROBE, &P, IORING_OP_READ + 1) < 0) {
+    return 0;
+  }
+  return P.probe.last_op >= IORING_OP_READ && (P.ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+}
+
+static int aio_uring_init (void) {
+  struct io_uring_params p;
+  memset (&p, 0, sizeof (p));
+  int fd = syscall (__NR_io_uring_setup, AIO_URING_ENTRIES, &p);
+  if (fd < 0) {
+    vkprintf (0, "io_uring_setup() failed: %m, falling back to POSIX aio\n");
+    return -1;
+  }
+  if (!aio_uring_read_supported (fd)) {
+    vkprintf (0, "kernel io_uring doesn't support IORING_OP_READ, falling back to POSIX aio\n");
+    close (fd);
+    return -1;
+  }
+  char *sq = mmap (0, p.sq_off.array + p.sq_entries * sizeof (unsigned), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  char *cq = mmap (0, p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+  void *sqes = mmap (0, p.sq_entries * sizeof (struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED) {
+    vkprintf (0, "cannot map io_uring rings: %m, falling back to POSIX aio\n");
+    close (fd);
+    return -1;
+  }
+  U.fd = fd;
+  U.sq_entries = p.sq_entries;
+  U.cq_entries = p.cq_entries;
+  U.sq_head = (unsigned *) (sq + p.sq_off.head);
+  U.sq_tail = (unsigned *) (sq + p.sq_off.tail);
+  U.sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+  U.sq_array = (unsigned *) (sq + p.sq_off.array);
+  U.cq_head = (unsigned *) (cq + p.cq_off.head);
+  U.cq_tail = (unsigned *) (cq + p.cq_off.tail);
+  U.cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+  U.cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+  U.sqes = sqes;
+
+  U.event_fd = eventfd (0, EFD_NONBLOCK);
+  if (U.event_fd >= 0 && syscall (__NR_io_uring_register, fd, IORING_REGISTER_EVENTFD, &U.event_fd, 1) < 0) {
+    vkprintf (0, "cannot register eventfd in io_uring: %m\n");
+    close (U.event_fd);
+    U.event_fd = -1;
+  }
+  aio_uring_register_eventfd ();
+  vkprintf (1, "io_uring initialized: %d sq entries, %d cq entries, eventfd %d\n", U.sq_entries, U.cq_entries, U.event_fd);
+  return 0;
+}
+
+int init_aio_backend (void) {
+  if (aio_backend < 0) {
+    aio_backend = (aio_uring_enabled && aio_uring_init () >= 0) ? AIO_BACKEND_URING : AIO_BACKEND_POSIX;
+  }
+  return aio_backend;
+}
+
+static int aio_uring_submit (void) {
+  aio_uring_register_eventfd ();
+  if (!U.to_submit) {
+    return 0;
+  }
+  int r = syscall (__NR_io_uring_enter, U.fd, U.to_submit, 0, 0, NULL, 0);
+  if (r < 0) {
+    if (errno != EAGAIN && errno != EBUSY && errno != EINTR) {
+      fprintf (stderr, "io_uring_enter() failed: %m\n");
+      exit (3);
+    }
+    return 0;
+  }
+  U.to_submit -= r;
+  tot_aio_uring_submits++;
+  return r;
+}
+
+static int aio_uring_queue_read (struct aio_connection *a, void *target, off_t offset, int len) {
+  unsigned tail = *U.sq_tail;
+  if (U.in_flight >= U.cq_entries) {
+    return -1;
+  }
+  if (tail - __atomic_load_n (U.sq_head, __ATOMIC_ACQUIRE) >= U.sq_entries) {
+    aio_uring_submit ();
+    if (tail - __atomic_load_n (U.sq_head, __ATOMIC_ACQUIRE) >= U.sq_entries) {
+      return -1;
+    }
+  }
+  unsigned idx = tail & *U.sq_mask;
+  struct io_uring_sqe *sqe = &U.sqes[idx];
+  memset (sqe, 0, sizeof (*sqe));
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = a->fd;
+  sqe->off = offset;
+  sqe->addr = (unsigned long) target;
+  sqe->len = len;
+  sqe->user_data = (unsigned long) a;
+  U.sq_array[idx] = idx;
+  __atomic_store_n (U.sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  a->backend = AIO_BACKEND_URING;
+  a->uring_res = -EINPROGRESS;
+  U.to_submit++;
+  U.in_flight++;
+  tot_aio_uring_queries++;
+  return 0;
+}
+
+static int aio_uring_reap (void) {
+  unsigned head = *U.cq_head, cnt = 0;
+  while (head != __atomic_load_n (U.cq_tail, __ATOMIC_ACQUIRE)) {
+    struct io_uring_cqe *cqe = &U.cqes[head & *U.cq_mask];
+    struct aio_connection *a = (struct aio_connection *) (unsigned long) cqe->user_data;
+    assert (a && a->backend == AIO_BACKEND_URING && a->uring_res == -EINPROGRESS);
+    a->uring_res = cqe->res;
+    head++;
+    cnt++;
+  }
+  __atomic_store_n (U.cq_head, head, __ATOMIC_RELEASE);
+  U.in_flight -= cnt;
+  return cnt;
+}
+
 struct {
   int fd, flags;
   struct aio_connection *first, *last;
@@ -64,7 +250,6 @@ struct aio_connection *create_aio_read_connection (int fd, void *target, off_t o
   a->fd = fd;
   a->flags = C_AIO;
   a->type = type;
-  a->cb = zmalloc0 (sizeof (struct aiocb));
   a->first_query = a->last_query = (struct conn_query *)a;
   a->extra = extra;
   a->basic_type = ct_aio;
@@ -76,6 +261,8 @@ struct aio_connection *create_aio_read_connection (int fd, void *target, off_t o
   aio_list.last->next = a;
   aio_list.last = a;
 
+  /* request is kept in aiocb in both backends, so that io_uring read may be retried through POSIX aio */
+  a->cb = zmalloc0 (sizeof (struct aiocb));
   a->cb->aio_fildes = fd;
   a->cb->aio_buf = target;
   a->cb->aio_offset = offset;
@@ -83,16 +270,26 @@ struct aio_connection *create_aio_read_connection (int fd, void *target, off_t o
   a->cb->aio_sigevent.sigev_notify = SIGEV_SIGNAL;
   a->cb->aio_sigevent.sigev_signo = SIGPOLL;
 
+  if (init_aio_backend () == AIO_BACKEND_URING && aio_uring_queue_read (a, target, offset, len) >= 0) {
+    return a;
+  }
+
+  aio_posix_read (a);
+  return a;
+}
+
+static void aio_posix_read (struct aio_connection *a) {
+  a->backend = AIO_BACKEND_POSIX;
   if (aio_read (a->cb) < 0) {
     fprintf (stderr, "aio_read returned -1: %m\n");
     exit (3);
   };
-
-  return a;
 }
 
 int aio_errors_verbosity;
 
+static int complete_aio_connection (struct aio_connection *a, int res);
+
 int check_aio_completion (struct aio_connection *a) {
 
   if (verbosity > 1) {
@@ -101,7 +298,31 @@ int check_aio_completion (struct aio_connection *a) {
 
   errno = 0;
 
-  int err = aio_error (a->cb);
+  int err, res;
+
+  if (a->backend == AIO_BACKEND_URING) {
+    if (a->uring_res == -EINPROGRESS) {
+      if (verbosity > 1) {
+        fprintf (stderr, "aio_query %p in progress...\n", a);
+      }
+      return 0;
+    }
+    if (a->uring_res == -EINVAL) {
+      /* opcode or request rejected by io_uring itself, POSIX aio either reads it or reports the real error */
+      vkprintf (1, "io_uring read of aio_query %p returns EINVAL, retrying through POSIX aio\n", a);
+      tot_aio_uring_posix_retries++;
+      aio_posix_read (a);
+      return 0;
+    }
+    res = a->uring_res < 0 ? -1 : a->uring_res;
+    err = a->uring_res < 0 ? -a->uring_res : 0;
+    if (verbosity > 1 || (aio_errors_verbosity && err)) {
+      fprintf (stderr, "io_uring read returns %d, errno=%d (%s)\n", res, err, strerror (err));
+    }
+    return complete_aio_connection (a, res);
+  }
+
+  err = aio_error (a->cb);
   
   if (err == EINPROGRESS) {
     if (verbosity > 1) {
@@ -129,11 +350,15 @@ int check_aio_completion (struct aio_connection *a) {
     }
   }
 
-  int res = aio_return (a->cb);
+  res = aio_return (a->cb);
   if (verbosity > 1 || (aio_errors_verbosity && err)) {
     fprintf (stderr, "aio_return() returns %d, errno=%d (%s)\n", res, err, strerror (err));
   }
 
+  return complete_aio_connection (a, res);
+}
+
+static int complete_aio_connection (struct aio_connection *a, int res) {
   a->type->wakeup_aio ((struct connection *)a, res);
 
   a->next->prev = a->prev;
@@ -155,7 +380,9 @@ int check_aio_completion (struct aio_connection *a) {
     fprintf (stderr, "freeing aio_connection at %p\n", a);
   }
 
-  zfree (a->cb, sizeof (struct aiocb));
+  if (a->cb) {
+    zfree (a->cb, sizeof (struct aiocb));
+  }
   zfree (a, sizeof (struct aio_connection));
 
   return 1;
@@ -170,6 +397,11 @@ int check_all_aio_completions (void) {
     fprintf (stderr, "check_all_aio_completions ()\n");
   }
 
+  if (aio_backend == AIO_BACKEND_URING) {
+    aio_uring_submit ();
+    aio_uring_reap ();
+  }
+
   for (tmp = aio_list.first; tmp != (struct aio_connection *)&aio_list; tmp = tnext) {
     tnext = tmp->next;
     //fprintf (stderr, "scanning aio_connection %p,next = %p\n", tmp, tnext);
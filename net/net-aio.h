@@ -42,10 +42,20 @@ struct aio_connection {
   int skip_bytes;
   int pending_queries;
   int queries_ok;
+  int backend;
+  int uring_res;
 };
 
+#define	AIO_BACKEND_POSIX	0
+#define	AIO_BACKEND_URING	1
+
 extern long long tot_aio_queries, active_aio_queries, expired_aio_queries;
+extern long long tot_aio_uring_queries, tot_aio_uring_submits, tot_aio_uring_posix_retries;
 extern double total_aio_time;
+extern int aio_uring_enabled;
+
+/* io_uring backend is used when aio_uring_enabled is set and the kernel supports it; returns current backend */
+int init_aio_backend (void);
 
 struct aio_connection *create_aio_read_connection (int fd, void *target, off_t offset, int len, conn_type_t *type, void *extra);
 int check_aio_completion (struct aio_connection *a);
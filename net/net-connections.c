@@ -30,6 +30,10 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/uio.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include <errno.h>
 #include <aio.h>
 #include <netdb.h>
 #include <math.h>
@@ -60,6 +64,18 @@ int conn_generation;
 
 long long netw_queries, netw_update_queries, total_failed_connections, total_connect_failures;
 
+/* write batching: flush_connection_output() only schedules the connection, so that
+   everything queued to it during one event loop iteration leaves in a single writev() */
+int conn_write_batching;
+long long batched_flushes, conn_writev_calls;
+
+/* raw-message writes of at least conn_zerocopy_threshold bytes use MSG_ZEROCOPY (0 = never) */
+int conn_zerocopy_threshold;
+long long zerocopy_sends, zerocopy_bytes, zerocopy_completions, zerocopy_copied;
+/* defined in net-aio.c, not every binary is linked with it */
+int aio_uring_enabled __attribute__ ((weak));
+long long tot_aio_uring_queries __attribute__ ((weak)), tot_aio_uring_submits __attribute__ ((weak)), tot_aio_uring_posix_retries __attribute__ ((weak));
+
 long long rpc_queries_received, rpc_queries_ok, rpc_queries_error, 
           rpc_answers_received, rpc_answers_ok, rpc_answers_error, rpc_answers_timedout,
           rpc_sent_queries, rpc_sent_answers, rpc_sent_errors;
@@ -223,6 +239,36 @@ int prepare_stats (struct connection *c, char *buff, int buff_size) {
   if (stats_len >= buff_size) {
     return buff_size - 1;
   }
+
+  stats_len += snprintf (buff + stats_len, buff_size - stats_len,
+    "write_batching\t%d\n"
+    "batched_flushes\t%lld\n"
+    "writev_calls\t%lld\n"
+    "zerocopy_threshold\t%d\n"
+    "zerocopy_sends\t%lld\n"
+    "zerocopy_bytes\t%lld\n"
+    "zerocopy_completions\t%lld\n"
+    "zerocopy_copied\t%lld\n",
+    conn_write_batching,
+    batched_flushes,
+    conn_writev_calls,
+    conn_zerocopy_threshold,
+    zerocopy_sends,
+    zerocopy_bytes,
+    zerocopy_completions,
+    zerocopy_copied
+  );
+
+  if (aio_uring_enabled) {
+    stats_len += snprintf (buff + stats_len, buff_size - stats_len,
+      "aio_uring_queries\t%lld\n"
+      "aio_uring_submits\t%lld\n"
+      "aio_uring_posix_retries\t%lld\n",
+      tot_aio_uring_queries,
+      tot_aio_uring_submits,
+      tot_aio_uring_posix_retries
+    );
+  }
   
   if (udp_packets_received || udp_packets_sent) {
     stats_len += snprintf (buff + stats_len, buff_size - stats_len,
@@ -290,6 +336,9 @@ int prepare_stats (struct connection *c, char *buff, int buff_size) {
       allocated_buffer_chunks, 
       max_buffer_chunks
     );
+    if (stats_len < buff_size) {
+      stats_len += msg_buffers_prepare_stats (buff + stats_len, buff_size - stats_len);
+    }
   }
 
 
@@ -342,7 +391,7 @@ int prepare_iovec (struct iovec *iov, int *iovcnt, int maxcnt, netbuffer_t *H) {
 /* returns # of bytes in c->Out remaining after all write operations;
    anything is written if (1) C_WANTWR is set 
                       AND (2) c->Out.total_bytes > 0 after encryption 
-                      AND (3) C_NOWR is not set
+                      AND (3) neither C_NOWR nor C_HOLDWR is set
    if c->Out.total_bytes becomes 0, C_WANTWR is cleared ("nothing to write") and C_WANTRD is set
    if c->Out.total_bytes remains >0, C_WANTRD is cleared ("stop reading until all bytes are sent")
 */ 
@@ -367,7 +416,7 @@ int server_writer (struct connection *c) {
         break;
       }
 
-      if (c->flags & C_NOWR) {
+      if (c->flags & (C_NOWR | C_HOLDWR)) {
         break;
       }
 
@@ -388,6 +437,7 @@ int server_writer (struct connection *c) {
       //// cond_disable_qack (c);
 
       r = writev (c->fd, iov, iovcnt);
+      conn_writev_calls++;
 
       #if 0
       long long interval = rdtsc () - before;
@@ -444,7 +494,7 @@ int server_writer (struct connection *c) {
         }
       }
     }
-  } while ((c->flags & (C_WANTWR | C_NOWR)) == C_WANTWR);
+  } while ((c->flags & (C_WANTWR | C_NOWR | C_HOLDWR)) == C_WANTWR);
 
   if (c->Out.total_bytes) {
     c->flags &= ~C_WANTRD;
@@ -658,6 +708,9 @@ int server_close_connection (struct connection *c, int who) {
   c->status = conn_none;
   c->flags = 0;
   c->generation = -1;
+  c->hold_generation = -1;
+  c->hold_output = 0;
+  c->rpc_in_flight = 0;
 
   if (c->basic_type == ct_listen) {
     return 0;
@@ -717,19 +770,22 @@ int client_close_connection (struct connection *c, int who) {
   c->status = conn_none;
   c->flags = 0;
   c->generation = -1;
+  c->hold_generation = -1;
+  c->hold_output = 0;
+  c->rpc_in_flight = 0;
 
   return c->type->free_buffers(c);
 }
 
 #if USE_EPOLLET
 static inline int compute_conn_events (struct connection *c) {
-  return (((c->flags & (C_WANTRD | C_STOPREAD)) == C_WANTRD) ? EVT_READ : 0) | (c->flags & C_WANTWR ? EVT_WRITE : 0) | EVT_SPEC;
+  return (((c->flags & (C_WANTRD | C_STOPREAD)) == C_WANTRD) ? EVT_READ : 0) | ((c->flags & (C_WANTWR | C_HOLDWR)) == C_WANTWR ? EVT_WRITE : 0) | EVT_SPEC;
 }
 #else
 static inline int compute_conn_events (struct connection *c) {
-  return (((c->flags & (C_WANTRD | C_STOPREAD)) == C_WANTRD) ? EVT_READ : 0) | (c->flags & C_WANTWR ? EVT_WRITE : 0) | EVT_SPEC 
+  return (((c->flags & (C_WANTRD | C_STOPREAD)) == C_WANTRD) ? EVT_READ : 0) | ((c->flags & (C_WANTWR | C_HOLDWR)) == C_WANTWR ? EVT_WRITE : 0) | EVT_SPEC 
        | (((c->flags & (C_WANTRD | C_NORD)) == (C_WANTRD | C_NORD))
-         || ((c->flags & (C_WANTWR | C_NOWR)) == (C_WANTWR | C_NOWR)) ? EVT_LEVEL : 0);
+         || ((c->flags & (C_WANTWR | C_NOWR | C_HOLDWR)) == (C_WANTWR | C_NOWR)) ? EVT_LEVEL : 0);
 }
 #endif
 
@@ -787,6 +843,11 @@ int server_read_write (struct connection *c) {
 
   c->flags |= C_INCONN;
 
+  if ((ev->epoll_ready & EPOLLERR) && c->zc && !(ev->epoll_ready & (EPOLLHUP | EPOLLRDHUP)) && conn_zerocopy_reap (c) >= 0) {
+    /* only zerocopy completions were queued, the socket itself is fine */
+    ev->epoll_ready &= ~EPOLLERR;
+  }
+
   if (ev->epoll_ready & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) {
     vkprintf (1, "socket %d: disconnected, cleaning\n", c->fd);
     force_clear_connection (c);
@@ -855,7 +916,7 @@ int server_read_write (struct connection *c) {
      3) we want re-parse input */
   while (
 	 ((c->flags & C_WANTRD) && !(c->flags & (C_NORD | C_FAILED | C_STOPREAD))) || 
-	 ((c->flags & C_WANTWR) && !(c->flags & (C_NOWR | C_FAILED))) || 
+	 ((c->flags & C_WANTWR) && !(c->flags & (C_NOWR | C_FAILED | C_HOLDWR))) || 
 	 ((c->flags & C_REPARSE) && (c->status == conn_expect_query || c->status == conn_reading_query || c->status == conn_wait_answer || c->status == conn_reading_answer))
 	 ) {
 
@@ -1000,9 +1061,111 @@ int fail_connection (struct connection *c, int err) {
   return 0;
 }
 
+/*
+ *	MSG_ZEROCOPY support for raw-message connections
+ */
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+/* returns 1 if next write to c may be sent with MSG_ZEROCOPY */
+int conn_zerocopy_enable (struct connection *c) {
+  struct conn_zerocopy *Z = c->zc;
+  if (!Z) {
+    Z = c->zc = calloc (1, sizeof (struct conn_zerocopy));
+    assert (Z);
+    rwm_init (&Z->pinned, 0);
+    if (setsockopt (c->fd, SOL_SOCKET, SO_ZEROCOPY, (int[]){1}, sizeof (int)) < 0) {
+      vkprintf (1, "socket %d: cannot enable SO_ZEROCOPY: %m\n", c->fd);
+      Z->disabled = 1;
+    }
+  }
+  return !Z->disabled && Z->next_seq - Z->first_seq < CONN_ZC_MAX_PENDING;
+}
+
+/* moves first bytes of raw (just sent with MSG_ZEROCOPY) to the pinned list */
+void conn_zerocopy_pin (struct connection *c, struct raw_message *raw, int bytes) {
+  struct conn_zerocopy *Z = c->zc;
+  struct raw_message head;
+  assert (Z && bytes > 0 && bytes <= raw->total_bytes);
+  assert (Z->next_seq - Z->first_seq < CONN_ZC_MAX_PENDING);
+  rwm_split_head (&head, raw, bytes);
+  rwm_union (&Z->pinned, &head);
+  Z->lens[Z->next_seq++ % CONN_ZC_MAX_PENDING] = bytes;
+  zerocopy_sends++;
+  zerocopy_bytes += bytes;
+}
+
+static void conn_zerocopy_release (struct conn_zerocopy *Z, unsigned hi) {
+  while (Z->first_seq != Z->next_seq && (int) (hi - Z->first_seq) >= 0) {
+    rwm_fetch_data (&Z->pinned, 0, Z->lens[Z->first_seq++ % CONN_ZC_MAX_PENDING]);
+    zerocopy_completions++;
+  }
+}
+
+/* drains the socket error queue; returns number of released sends, or -1 if a real socket error was found */
+int conn_zerocopy_reap (struct connection *c) {
+  struct conn_zerocopy *Z = c->zc;
+  static char control[256];
+  int res = 0;
+  assert (Z);
+  while (1) {
+    struct msghdr msg = { .msg_control = control, .msg_controllen = sizeof (control) };
+    if (recvmsg (c->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+      if (errno == EAGAIN || errno == EINTR) {
+        return res;
+      }
+      return -1;
+    }
+    struct cmsghdr *cm;
+    for (cm = CMSG_FIRSTHDR (&msg); cm; cm = CMSG_NXTHDR (&msg, cm)) {
+      if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+        continue;
+      }
+      struct sock_extended_err *E = (struct sock_extended_err *) CMSG_DATA (cm);
+      if (E->ee_origin != SO_EE_ORIGIN_ZEROCOPY || E->ee_errno) {
+        return -1;
+      }
+      if (E->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+        /* kernel had to copy anyway (e.g. loopback); plain writev() is cheaper then */
+        zerocopy_copied++;
+        Z->disabled = 1;
+      }
+      unsigned before = Z->first_seq;
+      conn_zerocopy_release (Z, E->ee_data);
+      res += Z->first_seq - before;
+    }
+  }
+}
+
+/* called from free_buffers: the socket is being closed, nothing is pinned any more */
+void conn_zerocopy_free (struct connection *c) {
+  struct conn_zerocopy *Z = c->zc;
+  if (Z) {
+    rwm_free (&Z->pinned);
+    free (Z);
+    c->zc = 0;
+  }
+}
+
 int flush_connection_output (struct connection *c) {
   if (out_total_processed_bytes (c) + out_total_unprocessed_bytes (c) > 0) {
     c->flags |= C_WANTWR;
+    if (conn_write_batching && c->type->run == server_read_write && !out_total_unprocessed_bytes (c) && c->status != conn_connecting) {
+      /* server_read_write() will write out everything accumulated by then */
+      batched_flushes++;
+      if (!(c->flags & C_INCONN) && !c->ev->in_queue) {
+        put_event_into_heap (c->ev);
+      }
+      return out_total_processed_bytes (c);
+    }
     int res = c->type->writer (c);
     if (out_total_processed_bytes (c) > 0 && !(c->flags & C_INCONN)) {
       epoll_insert (c->fd, compute_conn_events (c));
@@ -1027,6 +1190,35 @@ int flush_later (struct connection *c) {
   return 0;
 }
 
+/* returns token for release_connection_output (); c->generation can't be used,
+   since it is changed by wakeups and alarms of a live connection */
+int hold_connection_output (struct connection *c) {
+  assert (c->hold_output >= 0);
+  if (!c->hold_output++) {
+    c->flags |= C_HOLDWR;
+  }
+  return c->hold_generation;
+}
+
+/* hold_generation is returned by hold_connection_output (); a closed connection is ignored */
+void release_connection_output (void *_c, int hold_generation) {
+  struct connection *c = _c;
+  if (c->hold_generation != hold_generation || c->hold_output <= 0) {
+    return;
+  }
+  if (--c->hold_output) {
+    return;
+  }
+  c->flags &= ~C_HOLDWR;
+  if (out_total_processed_bytes (c) + out_total_unprocessed_bytes (c) > 0) {
+    c->flags |= C_WANTWR;
+  }
+  /* server_read_write () will write the answers out and resume reading */
+  if (!(c->flags & C_INCONN) && c->ev && !c->ev->in_queue) {
+    put_event_into_heap (c->ev);
+  }
+}
+
 int accept_new_connections (struct connection *cc) {
   char buf[64], buf2[64];
   union sockaddr_in46 peer, self;
@@ -1093,6 +1285,7 @@ int accept_new_connections (struct connection *cc) {
     c->fd = cfd;
     c->ev = ev;
     c->generation = ++conn_generation;
+    c->hold_generation = c->generation;
     c->flags = C_WANTRD;
     if ((cc->flags & C_RAWMSG) || (cc->type->flags & C_RAWMSG)) {
       c->flags |= C_RAWMSG;
@@ -1193,6 +1386,91 @@ int server_check_ready (struct connection *c) {
   return c->ready = cr_ok;
 }
 
+/*
+ *	rpc load accounting: every rpc query written to a connection is kept in a direct-mapped
+ *	table of pending qids, rpc_in_flight of a connection is the number of its entries in this table;
+ *	an entry is removed when the answer arrives, when the query times out, or when it is evicted
+ *	by a colliding qid (then only a latency sample is lost); closed connections forget their queries
+ */
+
+#define	RPC_PENDING_QUERIES	(1 << 16)
+#define	RPC_LATENCY_ALPHA	0.1
+
+double rpc_latency_decay_time = 2.0, rpc_error_penalty = 0.1;
+
+static struct rpc_pending_query {
+  long long qid;
+  int fd, generation;
+  double sent_time;
+} RpcPendingQueries[RPC_PENDING_QUERIES];
+
+static inline struct rpc_pending_query *rpc_pending_slot (long long qid) {
+  return &RpcPendingQueries[(unsigned long long) qid * 0x9e3779b97f4a7c15ULL >> 48];
+}
+
+/* returns connection owning pending query P, or 0 if it was closed since */
+static struct connection *rpc_pending_conn (struct rpc_pending_query *P) {
+  if (!P->qid || P->fd < 0 || P->fd >= MAX_CONNECTIONS) {
+    return 0;
+  }
+  struct connection *c = Connections + P->fd;
+  return c->generation == P->generation ? c : 0;
+}
+
+static void rpc_pending_remove (struct rpc_pending_query *P) {
+  struct connection *c = rpc_pending_conn (P);
+  if (c && c->rpc_in_flight > 0) {
+    c->rpc_in_flight--;
+  }
+  P->qid = 0;
+}
+
+void rpc_conn_query_sent (struct connection *c, long long qid) {
+  struct rpc_pending_query *P = rpc_pending_slot (qid);
+  rpc_pending_remove (P);
+  c->rpc_in_flight++;
+  P->qid = qid;
+  P->fd = c->fd;
+  P->generation = c->generation;
+  P->sent_time = precise_now;
+}
+
+/* peak latency decays to zero while no answers arrive, so that a replica penalized once gets probed again */
+double rpc_conn_latency (struct connection *c) {
+  double dt = precise_now - c->rpc_latency_time;
+  if (dt <= 0 || !c->rpc_latency) {
+    return c->rpc_latency;
+  }
+  return c->rpc_latency * exp (-dt / rpc_latency_decay_time);
+}
+
+void rpc_conn_answer_received (struct connection *c, long long qid, int error) {
+  struct rpc_pending_query *P = rpc_pending_slot (qid);
+  if (P->qid != qid || P->fd != c->fd || P->generation != c->generation) {
+    return;
+  }
+  rpc_pending_remove (P);
+  double t = precise_now - P->sent_time, l = rpc_conn_latency (c);
+  if (error) {
+    t += rpc_error_penalty;
+  }
+  c->rpc_latency = (t > l ? t : l + (t - l) * RPC_LATENCY_ALPHA);
+  c->rpc_latency_time = precise_now;
+}
+
+/* called by the query owner when it gives up waiting for the answer */
+void rpc_conn_query_timeout (long long qid) {
+  struct rpc_pending_query *P = rpc_pending_slot (qid);
+  if (P->qid == qid) {
+    rpc_pending_remove (P);
+  }
+}
+
+/* expected wait for one more query: lower is better */
+double rpc_conn_load (struct connection *c) {
+  return (c->rpc_in_flight + 1) * (rpc_conn_latency (c) + 1e-4);
+}
+
 
 int server_noop (struct connection *c) {
   return 0;
@@ -1492,6 +1770,7 @@ int create_new_connections (struct conn_target *S) {
     c->ev = ev;
     c->target = S;
     c->generation = ++conn_generation;
+    c->hold_generation = c->generation;
     c->flags = C_WANTWR;
 
     if (S->type->flags & C_RAWMSG) {
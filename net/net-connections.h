@@ -67,6 +67,7 @@
 #define	C_RAWMSG	0x40000
 #define	C_CRYPTOIN	0x100000
 #define	C_CRYPTOOUT	0x200000
+#define	C_HOLDWR	0x400000
 
 #define C_PERMANENT (C_IPV6 | C_RAWMSG)
 /* for connection status */
@@ -210,12 +211,17 @@ struct connection {
   double last_query_sent_time;
   double last_response_time;
   double last_query_timeout;
+  double rpc_latency, rpc_latency_time;	/* peak-EWMA of rpc answer time (seconds) and time of its last update */
+  int rpc_in_flight;			/* rpc queries sent through this connection and not answered yet */
+  int hold_output;			/* output is not written while positive, see hold_connection_output () */
+  int hold_generation;			/* generation at creation, unlike generation it isn't changed by wakeups */
   event_timer_t timer;
   int unreliability;
   int ready;
   int parse_state;
   int write_low_watermark;
   void *crypto;
+  struct conn_zerocopy *zc;
   int listening, listening_generation;
   int window_clamp;
   struct raw_message in_u, in, out, out_p;
@@ -225,6 +231,17 @@ struct connection {
   char out_buff[BUFF_SIZE];
 };
 
+/* MSG_ZEROCOPY state of a raw-message connection: bytes handed to the kernel stay
+   referenced here until the socket error queue reports their completion */
+#define CONN_ZC_MAX_PENDING 64
+
+struct conn_zerocopy {
+  struct raw_message pinned;
+  int lens[CONN_ZC_MAX_PENDING];
+  unsigned first_seq, next_seq;
+  int disabled;
+};
+
 extern struct connection Connections[MAX_CONNECTIONS];
 extern int max_connection;
 extern int active_connections;
@@ -233,6 +250,10 @@ extern int outbound_connections, active_outbound_connections, ready_outbound_con
 extern int conn_generation;
 extern int ready_targets;
 extern long long total_failed_connections, total_connect_failures;
+extern int conn_write_batching;
+extern long long batched_flushes, conn_writev_calls;
+extern int conn_zerocopy_threshold;
+extern long long zerocopy_sends, zerocopy_bytes, zerocopy_completions, zerocopy_copied;
 extern long long rpc_queries_received, rpc_queries_ok, rpc_queries_error, 
                  rpc_answers_received, rpc_answers_ok, rpc_answers_error, rpc_answers_timedout,
                  rpc_sent_queries, rpc_sent_answers, rpc_sent_errors;
@@ -254,6 +275,14 @@ int default_parse_execute (struct connection *c); // DO NOT USE!!!
 int client_init_outbound (struct connection *c);
 int server_check_ready (struct connection *c);
 
+/* rpc query accounting for load-aware choice of outbound connections */
+extern double rpc_latency_decay_time, rpc_error_penalty;
+void rpc_conn_query_sent (struct connection *c, long long qid);
+void rpc_conn_answer_received (struct connection *c, long long qid, int error);
+void rpc_conn_query_timeout (long long qid);
+double rpc_conn_latency (struct connection *c);
+double rpc_conn_load (struct connection *c);
+
 int conn_timer_wakeup_gateway (event_timer_t *et);
 int server_read_write_gateway (int fd, void *data, event_t *ev);
 int check_conn_functions (conn_type_t *type);
@@ -271,6 +300,15 @@ int fail_connection (struct connection *c, int err);
 int flush_connection_output (struct connection *c);
 int flush_later (struct connection *c);
 
+/* answers kept in output buffer until every hold is released (e.g. until binlog commit) */
+int hold_connection_output (struct connection *c);
+void release_connection_output (void *c, int hold_generation);
+
+int conn_zerocopy_enable (struct connection *c);
+void conn_zerocopy_pin (struct connection *c, struct raw_message *raw, int bytes);
+int conn_zerocopy_reap (struct connection *c);
+void conn_zerocopy_free (struct connection *c);
+
 int set_connection_timeout (struct connection *c, double timeout);
 int clear_connection_timeout (struct connection *c);
 
@@ -27,7 +27,9 @@
 #include <unistd.h>
 #include <pwd.h>
 #include <time.h>
+#include <signal.h>
 #include <sys/socket.h>
+#include <sys/prctl.h>
 #include <netinet/in.h>
 #include <ifaddrs.h>
 
@@ -53,9 +55,6 @@ long long ev_timestamp;
 event_t *ev_heap[MAX_EVENTS+1];
 int ev_heap_size;
 
-event_timer_t *et_heap[MAX_EVENT_TIMERS+1];
-int et_heap_size;
-
 int epoll_remove (int fd);
 
 double get_utime_monotonic (void) {
@@ -298,81 +297,212 @@ int epoll_close (int fd) {
   return 0;
 }
 
-static inline int basic_et_adjust (event_timer_t *et, int i) {
-  int j;
-  while (i > 1) {
-    j = (i >> 1);
-    if (et_heap[j]->wakeup_time <= et->wakeup_time) {
-      break;
-    }
-    et_heap[i] = et_heap[j];
-    et_heap[i]->h_idx = i;
-    i = j;
+/*
+ * event timers: hierarchical timing wheel
+ *
+ * ET_WHEEL_LEVELS levels of ET_WHEEL_SIZE slots each; a level-L slot covers
+ * ET_WHEEL_SIZE^L ticks of 1/ET_TICKS_PER_SEC seconds.  Insert and remove are O(1),
+ * a level-L slot is re-distributed into lower levels when the wheel clock reaches it.
+ * A timer fires once the tick containing its wakeup_time is over, i.e. at most
+ * one tick late, which is below the millisecond granularity of epoll_wait() anyway.
+ */
+
+#define	ET_TICKS_PER_SEC	1000
+#define	ET_WHEEL_BITS	6
+#define	ET_WHEEL_SIZE	(1 << ET_WHEEL_BITS)
+#define	ET_WHEEL_LEVELS	5
+#define	ET_FIRING_IDX	(ET_WHEEL_LEVELS * ET_WHEEL_SIZE + 1)
+
+static event_timer_t *et_wheel[ET_WHEEL_LEVELS][ET_WHEEL_SIZE];
+static unsigned long long et_wheel_mask[ET_WHEEL_LEVELS];
+static event_timer_t *et_firing;	// timers of the slot being expired right now
+static long long et_clock;		// first tick not expired yet
+int active_event_timers;
+
+static inline long long et_now_tick (void) {
+  return (long long) (precise_now * ET_TICKS_PER_SEC);
+}
+
+static inline event_timer_t **et_slot_head (int h_idx) {
+  if (h_idx == ET_FIRING_IDX) {
+    return &et_firing;
   }
-  j = 2*i;
-  while (j <= et_heap_size) {
-    if (j < et_heap_size && et_heap[j]->wakeup_time > et_heap[j+1]->wakeup_time) {
-      j++;
+  assert (h_idx > 0 && h_idx < ET_FIRING_IDX);
+  return &et_wheel[(h_idx - 1) >> ET_WHEEL_BITS][(h_idx - 1) & (ET_WHEEL_SIZE - 1)];
+}
+
+static inline void et_link (event_timer_t *et, int h_idx) {
+  event_timer_t **head = et_slot_head (h_idx);
+  et->prev = 0;
+  et->next = *head;
+  if (*head) {
+    (*head)->prev = et;
+  }
+  *head = et;
+  et->h_idx = h_idx;
+  if (h_idx != ET_FIRING_IDX) {
+    et_wheel_mask[(h_idx - 1) >> ET_WHEEL_BITS] |= 1ULL << ((h_idx - 1) & (ET_WHEEL_SIZE - 1));
+  }
+}
+
+static inline void et_unlink (event_timer_t *et) {
+  event_timer_t **head = et_slot_head (et->h_idx);
+  if (et->prev) {
+    et->prev->next = et->next;
+  } else {
+    assert (*head == et);
+    *head = et->next;
+  }
+  if (et->next) {
+    et->next->prev = et->prev;
+  }
+  if (!*head && et->h_idx != ET_FIRING_IDX) {
+    et_wheel_mask[(et->h_idx - 1) >> ET_WHEEL_BITS] &= ~(1ULL << ((et->h_idx - 1) & (ET_WHEEL_SIZE - 1)));
+  }
+  et->h_idx = 0;
+}
+
+static void et_wheel_add (event_timer_t *et) {
+  if (et->wakeup_time <= precise_now) {
+    /* already due: fire it from the next (or the current) epoll_run_timers () */
+    et_link (et, ET_FIRING_IDX);
+    return;
+  }
+  long long e = (long long) (et->wakeup_time * ET_TICKS_PER_SEC);
+  if (e < et_clock) {
+    e = et_clock;
+  }
+  long long d = e - et_clock;
+  int level = 0;
+  while (level < ET_WHEEL_LEVELS - 1 && d >= (1LL << (ET_WHEEL_BITS * (level + 1)))) {
+    level++;
+  }
+  if (d >= (1LL << (ET_WHEEL_BITS * ET_WHEEL_LEVELS))) {
+    /* too far away: park it in the farthest slot, it will be re-inserted from there */
+    e = et_clock + (1LL << (ET_WHEEL_BITS * ET_WHEEL_LEVELS)) - 1;
+  }
+  int slot = (e >> (ET_WHEEL_BITS * level)) & (ET_WHEEL_SIZE - 1);
+  et_link (et, (level << ET_WHEEL_BITS) + slot + 1);
+}
+
+/* et_clock has just reached a multiple of ET_WHEEL_SIZE: move due upper-level slots down */
+static void et_wheel_cascade (void) {
+  int level;
+  for (level = 1; level < ET_WHEEL_LEVELS; level++) {
+    int slot = (et_clock >> (ET_WHEEL_BITS * level)) & (ET_WHEEL_SIZE - 1);
+    event_timer_t *et = et_wheel[level][slot];
+    et_wheel[level][slot] = 0;
+    et_wheel_mask[level] &= ~(1ULL << slot);
+    while (et) {
+      event_timer_t *next = et->next;
+      et_wheel_add (et);
+      et = next;
     }
-    if (et->wakeup_time <= et_heap[j]->wakeup_time) {
+    if (slot) {
       break;
     }
-    et_heap[i] = et_heap[j];
-    et_heap[i]->h_idx = i;
-    i = j;
-    j <<= 1;
   }
-  et_heap[i] = et;
-  et->h_idx = i;
-  return i;
+}
+
+/* smallest k >= 0 such that bit (from + k) mod ET_WHEEL_SIZE of mask is set; mask != 0 */
+static inline int et_wheel_next_bit (unsigned long long mask, int from) {
+  return __builtin_ctzll (from ? (mask >> from) | (mask << (ET_WHEEL_SIZE - from)) : mask);
+}
+
+/* moves the wheel clock forward to tick t, never past a multiple of ET_WHEEL_SIZE */
+static inline void et_wheel_advance (long long t) {
+  et_clock = t;
+  if (!(t & (ET_WHEEL_SIZE - 1))) {
+    et_wheel_cascade ();
+  }
+}
+
+/* first tick at which a slot has to be expired or cascaded; current slots of upper levels are already cascaded */
+static long long et_wheel_next_tick (void) {
+  long long next = 0x7fffffffffffffffLL;
+  int level;
+  for (level = 0; level < ET_WHEEL_LEVELS; level++) {
+    if (et_wheel_mask[level]) {
+      long long cur = et_clock >> (ET_WHEEL_BITS * level);
+      int k = level ? et_wheel_next_bit (et_wheel_mask[level], (cur + 1) & (ET_WHEEL_SIZE - 1)) + 1 : et_wheel_next_bit (et_wheel_mask[0], cur & (ET_WHEEL_SIZE - 1));
+      long long t = (cur + k) << (ET_WHEEL_BITS * level);
+      if (t < next) {
+        next = t;
+      }
+    }
+  }
+  return next;
 }
 
 int insert_event_timer (event_timer_t *et) {
-  int i;
   if (et->h_idx) {
-    i = et->h_idx;
-    assert (i > 0 && i <= et_heap_size && et_heap[i] == et);
+    et_unlink (et);
   } else {
-    assert (et_heap_size < MAX_EVENT_TIMERS);
-    i = ++et_heap_size;
+    if (!active_event_timers) {
+      long long t = et_now_tick ();
+      if (t > et_clock) {
+        et_clock = t;
+      }
+    }
+    active_event_timers++;
   }
-  return basic_et_adjust (et, i);
+  et_wheel_add (et);
+  return et->h_idx;
 }
 
 int remove_event_timer (event_timer_t *et) {
-  int i = et->h_idx;
-  if (!i) {
+  if (!et->h_idx) {
     return 0;
   }
-  assert (i > 0 && i <= et_heap_size && et_heap[i] == et);
-  et->h_idx = 0;
-
-  et = et_heap[et_heap_size--];
-  if (i > et_heap_size) {
-    return 1;
-  }
-  basic_et_adjust (et, i);
+  et_unlink (et);
+  active_event_timers--;
   return 1;
 }
 
 int epoll_run_timers (void) {
-  double wait_time;
+  if (!active_event_timers) {
+    return 100000;
+  }
+  long long now_tick = et_now_tick ();
   event_timer_t *et;
-  if (!et_heap_size) {
+  while (1) {
+    /* wakeup() may insert or remove any timer, including the rest of this batch */
+    while ((et = et_firing)) {
+      et_unlink (et);
+      active_event_timers--;
+      et->wakeup (et);
+    }
+    if (et_clock >= now_tick || pending_signals) {
+      break;
+    }
+    int idx = et_clock & (ET_WHEEL_SIZE - 1);
+    if (!(et_wheel_mask[0] & (1ULL << idx))) {
+      /* nothing expires at this tick: jump to the next occupied slot or the next cascade */
+      long long next = et_clock - idx + ET_WHEEL_SIZE;
+      unsigned long long m = et_wheel_mask[0] >> idx;
+      if (m) {
+        next = et_clock + __builtin_ctzll (m);
+      }
+      et_wheel_advance (next < now_tick ? next : now_tick);
+      continue;
+    }
+    et_firing = et_wheel[0][idx];
+    et_wheel[0][idx] = 0;
+    et_wheel_mask[0] &= ~(1ULL << idx);
+    for (et = et_firing; et; et = et->next) {
+      et->h_idx = ET_FIRING_IDX;
+    }
+    et_wheel_advance (et_clock + 1);
+  }
+  if (!active_event_timers) {
     return 100000;
   }
-  wait_time = et_heap[1]->wakeup_time - precise_now;
+  double wait_time = (double) (et_wheel_next_tick () + 1) / ET_TICKS_PER_SEC - precise_now;
   if (wait_time > 0) {
     //do not remove this useful debug!
-    vkprintf (2, "%d event timers, next in %.3f seconds\n", et_heap_size, wait_time);
+    vkprintf (2, "%d event timers, next in %.3f seconds\n", active_event_timers, wait_time);
     return (int) (wait_time*1000) + 1;
   }
-  while (et_heap_size > 0 && et_heap[1]->wakeup_time <= precise_now && !pending_signals) {
-    et = et_heap[1];
-    assert (et->h_idx == 1);
-    remove_event_timer (et);
-    et->wakeup (et); 
-  }
   return 0;
 }
 
@@ -461,7 +591,7 @@ int epoll_fetch_events (int timeout) {
 int epoll_work (int timeout) {
   int res;
   int timeout2 = 10000;
-  if (ev_heap_size || et_heap_size) {
+  if (ev_heap_size || active_event_timers) {
     now = time (0);
     get_utime_monotonic ();
     do {
@@ -497,6 +627,53 @@ int epoll_work (int timeout) {
   return epoll_runqueue();
 }
 
+/*
+ * multi-reactor mode
+ *
+ * Engine state (Events, timer heap, Connections, netbuffers) is process-global,
+ * so additional reactors are created by fork() before init_epoll(): every copy
+ * gets its own epoll instance and timers, while listening sockets opened afterwards
+ * with SM_REUSEPORT let the kernel spread inbound connections between them.
+ * Sockets opened before the call are shared and accepted by whoever is woken first.
+ * Returns reactor id (0 in the original process).
+ */
+
+int reactors = 1, reactor_id;
+pid_t reactor_pids[MAX_REACTORS];
+
+int start_reactors (int n) {
+  int i;
+  pid_t parent_pid = getpid ();
+  assert (!epoll_fd);
+  if (n > MAX_REACTORS) {
+    n = MAX_REACTORS;
+  }
+  if (n <= 1) {
+    return 0;
+  }
+  kprintf_multiprocessing_mode_enable ();
+  vkprintf (0, "starting %d reactors\n", n);
+  for (i = 1; i < n; i++) {
+    pid_t pid = fork ();
+    if (pid < 0) {
+      kprintf ("fork() failed while starting reactor #%d: %m\n", i);
+      break;
+    }
+    if (!pid) {
+      reactor_id = i;
+      reactors = n;
+      prctl (PR_SET_PDEATHSIG, SIGTERM);
+      if (getppid () != parent_pid) {
+        exit (0);
+      }
+      return i;
+    }
+    reactor_pids[i] = pid;
+  }
+  reactors = i;
+  return 0;
+}
+
 // ------- end of definitions ----------
 
 /*
@@ -630,6 +807,11 @@ int server_socket (int port, struct in_addr in_addr, int backlog, int mode) {
     setsockopt (sfd, SOL_IP, IP_RECVERR, &flags, sizeof (flags));
   } else {
     setsockopt (sfd, SOL_SOCKET, SO_REUSEADDR, &flags, sizeof (flags));
+    if ((mode & SM_REUSEPORT) && setsockopt (sfd, SOL_SOCKET, SO_REUSEPORT, &flags, sizeof (flags)) < 0) {
+      perror ("setting SO_REUSEPORT");
+      close (sfd);
+      return -1;
+    }
     if (tcp_maximize_buffers) {
       maximize_sndbuf (sfd, 0);
       maximize_rcvbuf (sfd, 0);
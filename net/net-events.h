@@ -37,8 +37,11 @@
 #define EPOLLRDHUP 0x2000
 #endif
 
+#ifndef SO_REUSEPORT
+#define SO_REUSEPORT 15
+#endif
+
 #define	MAX_EVENTS		131072
-#define	MAX_EVENT_TIMERS	131072
 
 #define	EVT_READ	4
 #define EVT_WRITE	2
@@ -87,15 +90,18 @@ struct event_descr {
 
 typedef struct event_timer event_timer_t;
 
+/* h_idx != 0 iff the timer is armed; it encodes the timing wheel slot holding it */
 struct event_timer {
   int h_idx;
   int (*wakeup)(event_timer_t *et);
   double wakeup_time;
+  event_timer_t *next, *prev;
 };
 
 extern int now;
 extern double precise_now;
 extern int ev_heap_size;
+extern int active_event_timers;
 extern event_t Events[MAX_EVENTS];
 
 extern double tot_idle_time, a_idle_time, a_idle_quotient;
@@ -120,6 +126,13 @@ extern volatile long long pending_signals;
 int insert_event_timer (event_timer_t *et);
 int remove_event_timer (event_timer_t *et);
 
+/* multi-reactor mode: each reactor is a forked copy of the engine with its own epoll instance, timer heap and connection table */
+#define	MAX_REACTORS	64
+
+extern int reactors, reactor_id;
+
+int start_reactors (int n);
+
 double get_utime_monotonic (void);
 
 #define	PRIVILEGED_TCP_PORTS	1024
@@ -133,6 +146,7 @@ int tcp_maximize_buffers;
 #define	SM_SPECIAL	0x10000
 #define	SM_NOQACK	0x20000
 #define	SM_RAWMSG	0x40000
+#define	SM_REUSEPORT	0x80000
 
 int server_socket (int port, struct in_addr in_addr, int backlog, int mode);
 // int server_socket(int port, int is_udp);
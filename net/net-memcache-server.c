@@ -30,6 +30,7 @@
 #include <sys/types.h>
 #include <aio.h>
 #include <netdb.h>
+#include <immintrin.h>
 
 #include "crc32.h"
 #include "net-events.h"
@@ -125,6 +126,141 @@ struct memcache_server_functions default_memcache_server = {
   .mc_init_crypto = mcs_init_crypto
 };
 
+/*
+ *
+ *		DELIMITER SCANNERS
+ *
+ */
+
+/* simd scanners never read outside [ptr, ptr_e): the head is checked by one unaligned load,
+   then aligned blocks lying entirely before ptr_e are scanned, and the tail is scanned byte by byte */
+
+static inline unsigned mc_sse2_eoln_mask (__m128i x) {
+  return _mm_movemask_epi8 (_mm_or_si128 (_mm_cmpeq_epi8 (x, _mm_set1_epi8 ('\r')), _mm_cmpeq_epi8 (x, _mm_set1_epi8 ('\n'))));
+}
+
+static inline unsigned mc_sse2_word_mask (__m128i x) {
+  __m128i s = _mm_or_si128 (_mm_cmpeq_epi8 (x, _mm_set1_epi8 (' ')), _mm_cmpeq_epi8 (x, _mm_set1_epi8 ('\t')));
+  return _mm_movemask_epi8 (_mm_or_si128 (s, _mm_or_si128 (_mm_cmpeq_epi8 (x, _mm_set1_epi8 ('\r')), _mm_cmpeq_epi8 (x, _mm_set1_epi8 ('\n')))));
+}
+
+static inline unsigned mc_sse2_key_mask (__m128i x) {
+  return mc_sse2_word_mask (x) | _mm_movemask_epi8 (_mm_cmpeq_epi8 (x, _mm_setzero_si128 ()));
+}
+
+__attribute__ ((target ("avx2"))) static inline unsigned mc_avx2_eoln_mask (__m256i x) {
+  return _mm256_movemask_epi8 (_mm256_or_si256 (_mm256_cmpeq_epi8 (x, _mm256_set1_epi8 ('\r')), _mm256_cmpeq_epi8 (x, _mm256_set1_epi8 ('\n'))));
+}
+
+__attribute__ ((target ("avx2"))) static inline unsigned mc_avx2_word_mask (__m256i x) {
+  __m256i s = _mm256_or_si256 (_mm256_cmpeq_epi8 (x, _mm256_set1_epi8 (' ')), _mm256_cmpeq_epi8 (x, _mm256_set1_epi8 ('\t')));
+  return _mm256_movemask_epi8 (_mm256_or_si256 (s, _mm256_or_si256 (_mm256_cmpeq_epi8 (x, _mm256_set1_epi8 ('\r')), _mm256_cmpeq_epi8 (x, _mm256_set1_epi8 ('\n')))));
+}
+
+__attribute__ ((target ("avx2"))) static inline unsigned mc_avx2_key_mask (__m256i x) {
+  return mc_avx2_word_mask (x) | _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (x, _mm256_setzero_si256 ()));
+}
+
+#define	MC_SCAN_SCALAR(name, cond)	\
+  static char *name (const char *ptr, const char *ptr_e) {	\
+    while (ptr < ptr_e && !(cond)) {	\
+      ptr++;	\
+    }	\
+    return (char *) ptr;	\
+  }
+
+#define	MC_SCAN_SIMD(attr, name, vtype, width, load, loadu, mask, scalar)	\
+  attr static char *name (const char *ptr, const char *ptr_e) {	\
+    if (ptr_e - ptr < (width)) {	\
+      return scalar (ptr, ptr_e);	\
+    }	\
+    unsigned m = mask (loadu ((const vtype *) ptr));	\
+    if (m) {	\
+      return (char *) ptr + __builtin_ctz (m);	\
+    }	\
+    const vtype *a = (const vtype *) (((long) ptr & -(width)) + (width));	\
+    while ((const char *) (a + 1) <= ptr_e) {	\
+      m = mask (load (a));	\
+      if (m) {	\
+        return (char *) a + __builtin_ctz (m);	\
+      }	\
+      a++;	\
+    }	\
+    return scalar ((const char *) a, ptr_e);	\
+  }
+
+MC_SCAN_SCALAR (mc_scan_key_end_scalar, !*ptr || *ptr == ' ' || *ptr == '\t' || *ptr == '\r' || *ptr == '\n')
+MC_SCAN_SCALAR (mc_scan_word_end_scalar, *ptr == ' ' || *ptr == '\t' || *ptr == '\r' || *ptr == '\n')
+MC_SCAN_SCALAR (mc_scan_eoln_scalar, *ptr == '\r' || *ptr == '\n')
+
+MC_SCAN_SIMD (, mc_scan_key_end_sse2, __m128i, 16, _mm_load_si128, _mm_loadu_si128, mc_sse2_key_mask, mc_scan_key_end_scalar)
+MC_SCAN_SIMD (, mc_scan_word_end_sse2, __m128i, 16, _mm_load_si128, _mm_loadu_si128, mc_sse2_word_mask, mc_scan_word_end_scalar)
+MC_SCAN_SIMD (, mc_scan_eoln_sse2, __m128i, 16, _mm_load_si128, _mm_loadu_si128, mc_sse2_eoln_mask, mc_scan_eoln_scalar)
+
+MC_SCAN_SIMD (__attribute__ ((target ("avx2"))), mc_scan_key_end_avx2, __m256i, 32, _mm256_load_si256, _mm256_loadu_si256, mc_avx2_key_mask, mc_scan_key_end_scalar)
+MC_SCAN_SIMD (__attribute__ ((target ("avx2"))), mc_scan_word_end_avx2, __m256i, 32, _mm256_load_si256, _mm256_loadu_si256, mc_avx2_word_mask, mc_scan_word_end_scalar)
+MC_SCAN_SIMD (__attribute__ ((target ("avx2"))), mc_scan_eoln_avx2, __m256i, 32, _mm256_load_si256, _mm256_loadu_si256, mc_avx2_eoln_mask, mc_scan_eoln_scalar)
+
+static int mc_avx2_supported (void) {
+  vk_cpuid_t *p = vk_cpuid ();
+  /* AVX2 in leaf 7, OSXSAVE and AVX in leaf 1, and the OS must save ymm state (XCR0 bits 1-2) */
+  if (!(p->ebx7 & (1 << 5)) || (p->ecx & (3 << 27)) != (3 << 27)) {
+    return 0;
+  }
+  unsigned lo, hi;
+  asm ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+  return (lo & 6) == 6;
+}
+
+int mc_scan_level = -1;
+
+int mc_scan_init (int level) {
+  if (level < 0 || level > 2) {
+    level = 2;
+  }
+  if (level == 2 && !mc_avx2_supported ()) {
+    level = 1;
+  }
+  switch (level) {
+  case 0:
+    mc_scan_key_end = mc_scan_key_end_scalar;
+    mc_scan_word_end = mc_scan_word_end_scalar;
+    mc_scan_eoln = mc_scan_eoln_scalar;
+    break;
+  case 1:
+    mc_scan_key_end = mc_scan_key_end_sse2;
+    mc_scan_word_end = mc_scan_word_end_sse2;
+    mc_scan_eoln = mc_scan_eoln_sse2;
+    break;
+  case 2:
+    mc_scan_key_end = mc_scan_key_end_avx2;
+    mc_scan_word_end = mc_scan_word_end_avx2;
+    mc_scan_eoln = mc_scan_eoln_avx2;
+    break;
+  }
+  vkprintf (2, "memcache parser uses %s delimiter scanner\n", level == 2 ? "avx2" : level == 1 ? "sse2" : "scalar");
+  return mc_scan_level = level;
+}
+
+static char *mc_scan_key_end_cpuid (const char *ptr, const char *ptr_e) {
+  mc_scan_init (-1);
+  return mc_scan_key_end (ptr, ptr_e);
+}
+
+static char *mc_scan_word_end_cpuid (const char *ptr, const char *ptr_e) {
+  mc_scan_init (-1);
+  return mc_scan_word_end (ptr, ptr_e);
+}
+
+static char *mc_scan_eoln_cpuid (const char *ptr, const char *ptr_e) {
+  mc_scan_init (-1);
+  return mc_scan_eoln (ptr, ptr_e);
+}
+
+char *(*mc_scan_key_end)(const char *ptr, const char *ptr_e) = mc_scan_key_end_cpuid;
+char *(*mc_scan_word_end)(const char *ptr, const char *ptr_e) = mc_scan_word_end_cpuid;
+char *(*mc_scan_eoln)(const char *ptr, const char *ptr_e) = mc_scan_eoln_cpuid;
+
 int mcs_execute (struct connection *c, int op) {
   struct mcs_data *D = MCS_DATA(c);
   static char key_buffer[MAX_KEY_LEN+4];
@@ -258,16 +394,24 @@ int mcs_execute (struct connection *c, int op) {
       }
       len = 0;
       skip = 0;
-      while (ptr < ptr_e && *ptr != ' ' && *ptr != '\t' && *ptr != '\r' && *ptr != '\n') {
-        if (len <= MAX_KEY_LEN) {
-          key_buffer[len++] = *ptr;
+      while (1) {
+        char *q = mc_scan_word_end (ptr, ptr_e);
+        int l = q - ptr;
+        if (l > MAX_KEY_LEN + 1 - len) {
+          l = MAX_KEY_LEN + 1 - len;
         }
-        ptr++;
+        memcpy (key_buffer + len, ptr, l);
+        len += l;
+        ptr = q;
+        if (ptr < ptr_e) {
+          break;
+        }
+        nbit_advance (&r_it, ptr - ptr_s);
+        skip += ptr - ptr_s;
+        ptr = ptr_s = nbit_get_ptr (&r_it);
+        ptr_e = ptr + nbit_ready_bytes (&r_it);
         if (ptr == ptr_e) {
-          nbit_advance (&r_it, ptr - ptr_s);
-          skip += ptr - ptr_s;
-          ptr = ptr_s = nbit_get_ptr (&r_it);
-          ptr_e = ptr + nbit_ready_bytes (&r_it);
+          break;
         }
       }
       assert (ptr < ptr_e);
@@ -512,9 +656,10 @@ int mcs_parse_execute (struct connection *c) {
         }
        
       case mqp_readkey:
-	while (ptr < ptr_e && *ptr && *ptr != ' ' && *ptr != '\t' && *ptr != '\r' && *ptr != '\n') {
-	  D->key_len++;
-          ptr++;
+	{
+	  char *q = mc_scan_key_end (ptr, ptr_e);
+	  D->key_len += q - ptr;
+	  ptr = q;
 	}
 	if (ptr == ptr_e) {
           break;
@@ -580,9 +725,7 @@ int mcs_parse_execute (struct connection *c) {
 
       case mqp_readtoeoln:
 
-        while (ptr < ptr_e && (*ptr != '\r' && *ptr != '\n')) {
-          ptr++;
-        }
+        ptr = mc_scan_eoln (ptr, ptr_e);
         if (ptr == ptr_e) {
           break;
         }
@@ -106,6 +106,15 @@ int mcs_init_crypto (struct connection *c, char *auth_key, int auth_len);
 
 void mcs_pad_response (struct connection *c);
 
+/* delimiter scanners used by the query parser; return ptr_e if no delimiter found */
+extern char *(*mc_scan_key_end)(const char *ptr, const char *ptr_e);	/* ' ', '\t', '\r', '\n', '\0' */
+extern char *(*mc_scan_word_end)(const char *ptr, const char *ptr_e);	/* ' ', '\t', '\r', '\n' */
+extern char *(*mc_scan_eoln)(const char *ptr, const char *ptr_e);	/* '\r', '\n' */
+
+// 0 = scalar, 1 = sse2 (16 bytes), 2 = avx2 (32 bytes), -1 = best supported by cpu; returns selected level
+int mc_scan_init (int level);
+extern int mc_scan_level;
+
 /* useful functions */
 int return_one_key (struct connection *c, const char *key, char *val, int vlen);
 int return_one_key_list (struct connection *c, const char *key, int key_len, int res, int mode, const int *R, int R_cnt);
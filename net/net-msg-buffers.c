@@ -44,7 +44,18 @@ int buffer_size_values;
 
 struct msg_buffers_chunk ChunkHeaders[MAX_BUFFER_SIZE_VALUES];
 
-int default_buffer_sizes[] = { 48, 512, 2048 };
+int default_buffer_sizes[] = { MSG_TINY_BUFFER, MSG_SMALL_BUFFER, MSG_STD_BUFFER, MSG_PAGE_BUFFER, MSG_LARGE_BUFFER, MSG_HUGE_BUFFER };
+
+/* LIFO caches of freed buffers, one per size class: a hot buffer is reused without
+   walking the chunk free trees, and frees reach the trees in batches.
+   Reactors are separate processes, so these are already per-reactor. */
+struct msg_buffers_cache {
+  int cnt;
+  struct msg_buffer *B[MSG_BUFFERS_CACHE_SIZE];
+};
+
+struct msg_buffers_cache BuffersCache[MAX_BUFFER_SIZE_VALUES];
+long long msg_buffers_cache_hits, msg_buffers_cache_flushes;
 
 int free_std_msg_buffer (struct msg_buffers_chunk *C, struct msg_buffer *X);
 
@@ -331,11 +342,21 @@ struct msg_buffer *alloc_msg_buffer (struct msg_buffer *neighbor, int size_hint)
       si--;
     }
   }
+  struct msg_buffers_cache *Q = &BuffersCache[si];
+  if (Q->cnt) {
+    struct msg_buffer *X = Q->B[--Q->cnt];
+    assert (X->magic == MSG_BUFFER_FREE_MAGIC && X->chunk->ch_head == &ChunkHeaders[si]);
+    X->refcnt = 1;
+    X->magic = MSG_BUFFER_USED_MAGIC;
+    total_used_buffers_size += X->chunk->buffer_size;
+    total_used_buffers ++;
+    msg_buffers_cache_hits ++;
+    return X;
+  }
   return alloc_msg_buffer_internal (neighbor, &ChunkHeaders[si]);
 }
 
-int free_std_msg_buffer (struct msg_buffers_chunk *C, struct msg_buffer *X) {
-  assert (!X->refcnt && X->magic == MSG_BUFFER_USED_MAGIC && C->magic == MSG_CHUNK_USED_MAGIC && X->chunk == C);
+static void release_msg_buffer (struct msg_buffers_chunk *C, struct msg_buffer *X) {
   int x = get_buffer_no (C, X);
   int two_power = C->two_power;
   if (verbosity > 2) {
@@ -347,20 +368,85 @@ int free_std_msg_buffer (struct msg_buffers_chunk *C, struct msg_buffer *X) {
     assert (++C->free_cnt[x] > 0);
   } while (x >>= 1);
 
+  ++ C->ch_head->free_buffers;
+
+  if (!C->free_cnt[1] && C->ch_head->free_buffers * 4 >= C->tot_buffers * 5) {
+    free_msg_buffers_chunk (C);
+  }
+}
+
+/* returns all but the keep most recently freed buffers of Q to their chunks */
+static void flush_msg_buffers_cache (struct msg_buffers_cache *Q, int keep) {
+  int i, n = Q->cnt - keep;
+  if (n <= 0) {
+    return;
+  }
+  for (i = 0; i < n; i++) {
+    release_msg_buffer (Q->B[i]->chunk, Q->B[i]);
+  }
+  memmove (Q->B, Q->B + n, keep * sizeof (struct msg_buffer *));
+  Q->cnt = keep;
+  msg_buffers_cache_flushes ++;
+}
+
+int free_std_msg_buffer (struct msg_buffers_chunk *C, struct msg_buffer *X) {
+  assert (!X->refcnt && X->magic == MSG_BUFFER_USED_MAGIC && C->magic == MSG_CHUNK_USED_MAGIC && X->chunk == C);
+
   X->magic = MSG_BUFFER_FREE_MAGIC;
   X->refcnt = -0x40000000;
-  ++ C->ch_head->free_buffers;
-  
+
   total_used_buffers_size -= C->buffer_size;
   total_used_buffers --;
 
-  if (!C->free_cnt[1] && C->ch_head->free_buffers * 4 >= C->tot_buffers * 5) {
-    free_msg_buffers_chunk (C);
+  struct msg_buffers_cache *Q = &BuffersCache[C->ch_head - ChunkHeaders];
+  if (Q->cnt == MSG_BUFFERS_CACHE_SIZE) {
+    flush_msg_buffers_cache (Q, MSG_BUFFERS_CACHE_SIZE / 2);
   }
+  Q->B[Q->cnt++] = X;
 
   return 1;
 }
 
+/* returns all cached buffers to their chunks */
+int msg_buffers_flush_cache (void) {
+  int i, res = 0;
+  for (i = 0; i < buffer_size_values; i++) {
+    res += BuffersCache[i].cnt;
+    flush_msg_buffers_cache (&BuffersCache[i], 0);
+  }
+  return res;
+}
+
+int msg_buffers_prepare_stats (char *buff, int buff_size) {
+  int i, stats_len = 0;
+  for (i = 0; i < buffer_size_values && stats_len < buff_size; i++) {
+    struct msg_buffers_chunk *CH = &ChunkHeaders[i];
+    if (!CH->tot_chunks) {
+      continue;
+    }
+    long long free_buffers = CH->free_buffers + BuffersCache[i].cnt;
+    stats_len += snprintf (buff + stats_len, buff_size - stats_len,
+      "msg_buffers_%d_chunks\t%d\n"
+      "msg_buffers_%d_used_bytes\t%lld\n"
+      "msg_buffers_%d_free_bytes\t%lld\n"
+      "msg_buffers_%d_cached\t%d\n",
+      CH->buffer_size, CH->tot_chunks,
+      CH->buffer_size, (CH->tot_buffers - free_buffers) * CH->buffer_size,
+      CH->buffer_size, free_buffers * CH->buffer_size,
+      CH->buffer_size, BuffersCache[i].cnt
+    );
+  }
+  if (stats_len < buff_size) {
+    stats_len += snprintf (buff + stats_len, buff_size - stats_len,
+      "msg_buffers_cache_hits\t%lld\n"
+      "msg_buffers_cache_flushes\t%lld\n",
+      msg_buffers_cache_hits,
+      msg_buffers_cache_flushes
+    );
+  }
+  return stats_len < buff_size ? stats_len : buff_size - 1;
+}
+
 int free_msg_buffer (struct msg_buffer *X) {
   assert (!X->refcnt);
   struct msg_buffers_chunk *C = X->chunk;
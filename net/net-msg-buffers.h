@@ -21,10 +21,16 @@
 
 #pragma once
 
+#define	MSG_HUGE_BUFFER	65536
+#define	MSG_LARGE_BUFFER	16384
+#define	MSG_PAGE_BUFFER	4096
 #define MSG_STD_BUFFER	2048
 #define	MSG_SMALL_BUFFER	512
 #define	MSG_TINY_BUFFER	48
 
+/* per size class cache of recently freed buffers; overflow is returned to chunks in batches */
+#define	MSG_BUFFERS_CACHE_SIZE	64
+
 #define	MSG_BUFFERS_CHUNK_SIZE	((1L << 21) - 64)
 
 #define MSG_DEFAULT_MAX_ALLOCATED_BYTES	(1L << 28)
@@ -81,3 +87,5 @@ int init_msg_buffers (long max_buffer_bytes);
 struct msg_buffer *alloc_msg_buffer (struct msg_buffer *neighbor, int size_hint);
 
 int free_msg_buffer (struct msg_buffer *buffer);
+int msg_buffers_flush_cache (void);
+int msg_buffers_prepare_stats (char *buff, int buff_size);
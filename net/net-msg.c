@@ -263,7 +263,7 @@ int rwm_push_data (struct raw_message *raw, const void *data, int alloc_bytes) {
   }
   while (alloc_bytes > 0) {
     mpl = mp;
-    struct msg_buffer *X = alloc_msg_buffer (mpl->part, raw->total_bytes + alloc_bytes >= MSG_STD_BUFFER ? MSG_STD_BUFFER : MSG_SMALL_BUFFER);
+    struct msg_buffer *X = alloc_msg_buffer (mpl->part, alloc_bytes >= MSG_HUGE_BUFFER ? MSG_HUGE_BUFFER : alloc_bytes >= MSG_LARGE_BUFFER ? MSG_LARGE_BUFFER : (raw->total_bytes + alloc_bytes >= MSG_STD_BUFFER ? MSG_STD_BUFFER : MSG_SMALL_BUFFER));
     if (!X) {
       return res;
     }
@@ -391,6 +391,14 @@ int rpcc_parse_execute (struct connection *c) {
     } else {
       /* main case */
       c->status = conn_running;
+      if ((D->packet_type == RPC_REQ_RESULT || D->packet_type == RPC_REQ_ERROR) && D->packet_len >= 24) {
+        long long qid;
+        nb_iterator_t R;
+        nbit_set (&R, &c->In);
+        assert (nbit_advance (&R, 12) == 12);
+        assert (nbit_read_in (&R, &qid, 8) == 8);
+        rpc_conn_answer_received (c, qid, D->packet_type == RPC_REQ_ERROR);
+      }
       if (D->packet_type == RPC_PING) {
         res = rpcc_default_execute (c, D->packet_type, D->packet_len);
       } else {
@@ -223,18 +223,37 @@ struct rpc_target *rpc_target_lookup_target (struct conn_target *targ) {
   return T ? T->x : 0;
 }
 
+/*
+ *	ready connections are chosen by "power of two choices": two of them are sampled
+ *	at random and the one with smaller rpc_conn_load () (in-flight queries times
+ *	answer latency) wins, so a slow or failing peer gets less traffic but is still probed
+ */
+
+#define	RPC_TARGET_MAX_CHALLENGERS	64
+#define	RPC_TARGET_UNAVAILABLE_LOAD	1e9
+
+static inline void rpc_target_sample (struct connection *c, struct connection *X[], int limit, int *count) {
+  int t = (*count)++;
+  if (t >= limit) {
+    t = lrand48 () % (t + 1);
+  }
+  if (t < limit) {
+    X[t] = c;
+  }
+}
+
 struct connection *rpc_target_choose_connection (struct rpc_target *S, struct process_id *PID) {
   if (!S) {
     return 0;
   }
-  struct connection *c, *d = 0;
-  int r, u = 10000;
+  struct connection *c, *d = 0, *X[2];
+  int r, u = 10000, count = 0;
   if (S->target) {
     for (c = S->target->first_conn; c != (struct connection *) (S->target); c = c->next) {
       r = server_check_ready (c);
       if (r == cr_ok) {
         if (!PID || matches_pid (&RPCS_DATA(c)->remote_pid, PID) >= 1) {
-          return c;
+          rpc_target_sample (c, X, 2, &count);
         }
       } else if (r == cr_stopped && c->unreliability < u) {
         if (!PID || matches_pid (&RPCS_DATA(c)->remote_pid, PID) >= 1) {
@@ -248,7 +267,7 @@ struct connection *rpc_target_choose_connection (struct rpc_target *S, struct pr
     r = server_check_ready (c);
     if (r == cr_ok) {
       if (!PID || matches_pid (&RPCS_DATA(c)->remote_pid, PID) >= 1) {
-        return c;
+        rpc_target_sample (c, X, 2, &count);
       }
     } else if (r == cr_stopped && c->unreliability < u) {
       if (!PID || matches_pid (&RPCS_DATA(c)->remote_pid, PID) >= 1) {
@@ -257,48 +276,89 @@ struct connection *rpc_target_choose_connection (struct rpc_target *S, struct pr
       }
     }
   }
-  return d;
+  if (count >= 2) {
+    return rpc_conn_load (X[1]) < rpc_conn_load (X[0]) ? X[1] : X[0];
+  }
+  return count ? X[0] : d;
 }
 
+/* samples up to 2 * limit distinct ready connections and keeps the less loaded one of each pair */
 int rpc_target_choose_random_connections (struct rpc_target *S, struct process_id *PID, int limit, struct connection *buf[]) {
   if (!S) {
     return 0;
   }
-  struct connection *c;
-  int pos = 0;
-  int count = 0;
+  static struct connection *X[2 * RPC_TARGET_MAX_CHALLENGERS];
+  struct connection *c, **Y = X;
+  int i, count = 0, m = 2 * limit;
   int r;
+  if (limit > RPC_TARGET_MAX_CHALLENGERS) {
+    Y = buf;
+    m = limit;
+  }
   if (S->target) {
     for (c = S->target->first_conn; c != (struct connection *) (S->target); c = c->next) {
       r = server_check_ready (c);
       if ((r == cr_ok) && (!PID || matches_pid (&RPCS_DATA(c)->remote_pid, PID) >= 1)) {
-        if (pos < limit) {
-          buf[pos ++] = c;
-        } else {
-          int t = lrand48 () % (count + 1);
-          if (t < limit) {
-            buf[t] = c;
-          }
-        }
-        count ++;
+        rpc_target_sample (c, Y, m, &count);
       }
     }
   }
   for (c = S->first; c != (struct connection *) (S); c = c->next) {
     r = server_check_ready (c);
     if ((r == cr_ok) && (!PID || matches_pid (&RPCS_DATA(c)->remote_pid, PID) >= 1)) {
-      if (pos < limit) {
-        buf[pos ++] = c;
-      } else {
-        int t = lrand48 () % (count + 1);
-        if (t < limit) {
-          buf[t] = c;
+      rpc_target_sample (c, Y, m, &count);
+    }
+  }
+  if (count > m) {
+    count = m;
+  }
+  if (Y == buf) {
+    return count;
+  }
+  if (count <= limit) {
+    memcpy (buf, X, count * sizeof (struct connection *));
+    return count;
+  }
+  for (i = 0; i < limit; i++) {
+    buf[i] = (i + limit < count && rpc_conn_load (X[i + limit]) < rpc_conn_load (X[i])) ? X[i + limit] : X[i];
+  }
+  return limit;
+}
+
+/* load of the peer as a whole, for callers choosing between replicas */
+double rpc_target_get_load (struct rpc_target *S, struct process_id *PID) {
+  if (!S) {
+    return RPC_TARGET_UNAVAILABLE_LOAD;
+  }
+  struct connection *c;
+  int in_flight = 0, ready = 0;
+  double latency = 0;
+  if (S->target) {
+    for (c = S->target->first_conn; c != (struct connection *) (S->target); c = c->next) {
+      if (server_check_ready (c) == cr_ok && (!PID || matches_pid (&RPCS_DATA(c)->remote_pid, PID) >= 1)) {
+        double l = rpc_conn_latency (c);
+        in_flight += c->rpc_in_flight;
+        if (l > latency) {
+          latency = l;
         }
+        ready++;
       }
-      count ++;
     }
   }
-  return pos;
+  for (c = S->first; c != (struct connection *) (S); c = c->next) {
+    if (server_check_ready (c) == cr_ok && (!PID || matches_pid (&RPCS_DATA(c)->remote_pid, PID) >= 1)) {
+      double l = rpc_conn_latency (c);
+      in_flight += c->rpc_in_flight;
+      if (l > latency) {
+        latency = l;
+      }
+      ready++;
+    }
+  }
+  if (!ready) {
+    return RPC_TARGET_UNAVAILABLE_LOAD;
+  }
+  return (in_flight + 1) * (latency + 1e-4);
 }
 
 int rpc_target_get_state (struct rpc_target *S, struct process_id *PID) {
@@ -36,6 +36,7 @@ struct rpc_target *rpc_target_lookup_target (struct conn_target *targ);
 
 struct connection *rpc_target_choose_connection (struct rpc_target *S, struct process_id *PID);
 int rpc_target_choose_random_connections (struct rpc_target *S, struct process_id *PID, int limit, struct connection *buf[]);
+double rpc_target_get_load (struct rpc_target *S, struct process_id *PID);
 
 void rpc_target_insert_conn (struct connection *c);
 void rpc_target_insert_target (struct conn_target *t);
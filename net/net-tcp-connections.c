@@ -21,6 +21,8 @@
 */
 
 #include <sys/uio.h>
+#include <sys/socket.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
@@ -35,7 +37,12 @@
 #define MAX_TCP_RECV_BUFFERS 128
 #define TCP_RECV_BUFFER_SIZE 1024
 
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
 int tcp_free_connection_buffers (struct connection *c) {
+  conn_zerocopy_free (c);
   rwm_free (&c->in);
   rwm_free (&c->in_u);
   rwm_free (&c->out);
@@ -88,7 +95,7 @@ int prealloc_tcp_buffers (void) {
 /* returns # of bytes in c->Out remaining after all write operations;
    anything is written if (1) C_WANTWR is set 
                       AND (2) c->Out.total_bytes > 0 after encryption 
-                      AND (3) C_NOWR is not set
+                      AND (3) neither C_NOWR nor C_HOLDWR is set
    if c->Out.total_bytes becomes 0, C_WANTWR is cleared ("nothing to write") and C_WANTRD is set
    if c->Out.total_bytes remains >0, C_WANTRD is cleared ("stop reading until all bytes are sent")
 */ 
@@ -112,7 +119,7 @@ int tcp_server_writer (struct connection *c) {
         break;
       }
 
-      if (c->flags & C_NOWR) {
+      if (c->flags & (C_NOWR | C_HOLDWR)) {
         break;
       }
 
@@ -122,7 +129,20 @@ int tcp_server_writer (struct connection *c) {
       s = tcp_prepare_iovec (iov, &iovcnt, 64, out);
       assert (iovcnt > 0 && s > 0);
 
-      r = writev (c->fd, iov, iovcnt);
+      /* large writes are sent with MSG_ZEROCOPY; their buffers stay pinned until the kernel releases them */
+      int zc = conn_zerocopy_threshold > 0 && s >= conn_zerocopy_threshold && c->status != conn_write_close && conn_zerocopy_enable (c);
+      if (zc) {
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = iovcnt };
+        r = sendmsg (c->fd, &msg, MSG_ZEROCOPY);
+        if (r < 0 && errno == ENOBUFS) {
+          /* out of optmem for notifications, fall back to copying */
+          zc = 0;
+          r = writev (c->fd, iov, iovcnt);
+        }
+      } else {
+        r = writev (c->fd, iov, iovcnt);
+      }
+      conn_writev_calls++;
 
       if (verbosity > 0) {
         fprintf (stderr, "send/writev() to %d: %d written out of %d in %d chunks\n", c->fd, r, s, iovcnt);
@@ -132,7 +152,11 @@ int tcp_server_writer (struct connection *c) {
       }
 
       if (r > 0) {
-        rwm_fetch_data (out, 0, r);
+        if (zc) {
+          conn_zerocopy_pin (c, out, r);
+        } else {
+          rwm_fetch_data (out, 0, r);
+        }
         t += r;
       }
 
@@ -154,7 +178,7 @@ int tcp_server_writer (struct connection *c) {
         }
       }
     }
-  } while ((c->flags & (C_WANTWR | C_NOWR)) == C_WANTWR);
+  } while ((c->flags & (C_WANTWR | C_NOWR | C_HOLDWR)) == C_WANTWR);
 
   if (out->total_bytes) {
     c->flags &= ~C_WANTRD;
@@ -343,6 +343,11 @@ int tcp_rpcc_parse_execute (struct connection *c) {
     } else {
       /* main case */
       c->status = conn_running;
+      if ((D->packet_type == RPC_REQ_RESULT || D->packet_type == RPC_REQ_ERROR) && msg.total_bytes >= 12) {
+        int x[3];
+        assert (rwm_fetch_lookup (&msg, x, 12) == 12);
+        rpc_conn_answer_received (c, *(long long *) (x + 1), D->packet_type == RPC_REQ_ERROR);
+      }
       if (D->packet_type == RPC_PING) {
         res = tcp_rpcc_default_execute (c, D->packet_type, &msg);
       } else {
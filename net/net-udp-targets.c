@@ -1788,8 +1788,8 @@ void out_buf_add (struct raw_message *raw) {
   __out_buf_add (raw, S->send_num - 1);
 }
 
-int R[10000];
-int Rpos;
+static int R[10000];
+static int Rpos;
 
 void __dump_R (int x) {
   assert (Rpos < 10000);
@@ -0,0 +1,625 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#ifndef TL_CONSTANTS_H
+#define TL_CONSTANTS_H
+#define TL_INT 0xa8509bda
+#define TL_LONG 0x22076cba
+#define TL_DOUBLE 0x2210c154
+#define TL_STRING 0xb5286e24
+#define TL_BOOL_FALSE 0xbc799737
+#define TL_BOOL_TRUE 0x997275b5
+#define TL_BOOL_STAT 0x92cbcbfa
+#define TL_VECTOR 0x1cb5c415
+#define TL_TUPLE 0x9770768a
+#define TL_VECTOR_TOTAL 0x10133f47
+#define TL_STAT_ONE 0x74b0604b
+#define TL_STAT 0x9d56e6b2
+#define TL_RESULT_FALSE 0x27930a7b
+#define TL_RESULT_TRUE 0x3f9c8ef8
+#define TL_PAIR 0x0f3c47ab
+#define TL_MAP 0x79c473a4
+#define TL_TRUE 0x3fedd339
+#define TL_PID 0xfa6f0a9a
+#define TL_RPC_INVOKE_REQ_EXTRA 0x0c36bbd8
+#define TL_RPC_REQ_RESULT_EXTRA 0xc5011709
+#define TL_REQ_ERROR 0xb527877d
+#define TL_REQ_RESULT_HEADER 0x8cc84ce1
+#define TL__ 0x840e0ecc
+#define TL_RPC_REQ_RESULT 0x63aeda4e
+#define TL_RPC_REQ_ERROR 0x7ae432f5
+#define TL_RPC_DEST_ACTOR 0x7568aabd
+#define TL_RPC_DEST_ACTOR_FLAGS 0xf0a5acf7
+#define TL_RPC_DEST_FLAGS 0xe352035e
+#define TL_RPC_INVOKE_REQ 0x2374df3d
+#define TL_ENGINE_NOP 0x166bb7c6
+#define TL_ENGINE_STAT 0xefb3c36b
+#define TL_TLS_SCHEMA_V2 0x3a2f9be2
+#define TL_TLS_TYPE 0x12eb4386
+#define TL_TLS_COMBINATOR 0x5c0a1ed5
+#define TL_TLS_COMBINATOR_LEFT_BUILTIN 0xcd211f63
+#define TL_TLS_COMBINATOR_LEFT 0x4c12c6d9
+#define TL_TLS_COMBINATOR_RIGHT 0x2c064372
+#define TL_TLS_ARG 0x29dfe61b
+#define TL_TLS_EXPR_TYPE 0xecc9da78
+#define TL_TLS_EXPR_NAT 0xdcb49bd8
+#define TL_TLS_NAT_CONST 0x8ce940b1
+#define TL_TLS_NAT_VAR 0x4e8a14f0
+#define TL_TLS_TYPE_VAR 0x0142ceae
+#define TL_TLS_ARRAY 0xd9fb20de
+#define TL_TLS_TYPE_EXPR 0xc1863d08
+#define TL_RPC_PROXY_TARGET 0x9ec5badb
+#define TL_RPC_PROXY_NET_TARGET 0xb28fa912
+#define TL_RPC_PROXY_GET_CLUSTERS 0x4022a51a
+#define TL_RPC_PROXY_GET_CLUSTER_SIZE 0xf6592ff8
+#define TL_RPC_PROXY_GET_CLUSTER_SERVERS 0x7d7ab96d
+#define TL_RPC_PROXY_GET_CLUSTER_STATS 0xbe6c4a50
+#define TL_RPC_PROXY_GET_BAD_TARGETS 0xedd67508
+#define TL_MEMCACHE_NOT_FOUND 0x32c42422
+#define TL_MEMCACHE_STRVALUE 0xa6bebb1a
+#define TL_MEMCACHE_LONGVALUE 0x09729c42
+#define TL_MEMCACHE_SET 0xeeeb54c4
+#define TL_MEMCACHE_ADD 0xa358f31c
+#define TL_MEMCACHE_REPLACE 0x2ecdfaa2
+#define TL_MEMCACHE_INCR 0x80e6c950
+#define TL_MEMCACHE_DECR 0x6467e0d9
+#define TL_MEMCACHE_DELETE 0xab505c0a
+#define TL_MEMCACHE_GET 0xd33b13ae
+#define TL_MEMCACHE_GET_WILDCARD 0x641722d6
+#define TL_SEQMAP_KEY 0x3d58d15d
+#define TL_SEQMAP_VALUE 0x47d2bdbe
+#define TL_SEQMAP_KEY_VALUE 0x8ffa2d5d
+#define TL_SEQMAP_SET 0x4bdcf06d
+#define TL_SEQMAP_ADD 0xc399192c
+#define TL_SEQMAP_REPLACE 0x5e025771
+#define TL_SEQMAP_DELETE 0x87bfdb5a
+#define TL_SEQMAP_GET 0x0ec1ea10
+#define TL_SEQMAP_GET_RANGE 0xea21b1c6
+#define TL_SEQMAP_GET_WILDCARD 0x2c92514f
+#define TL_SEQMAP_GET_RANGE_COUNT 0xa5d7dbfa
+#define TL_SEQMAP_GET_WILDCARD_COUNT 0x4c6dd002
+#define TL_LISTS_LIST_ID 0xfcf3f88c
+#define TL_LISTS_OBJECT_ID 0x9f447260
+#define TL_LISTS_WEIGHTED_OBJECT_ID 0xbe3f3c8c
+#define TL_LISTS_OBJECT_FULL 0x54a980e0
+#define TL_LISTS_DELETE_LIST 0x879ce2e3
+#define TL_LISTS_DELETE_OBJECT 0xf8289655
+#define TL_LISTS_DELETE_ENTRY 0xd04f767a
+#define TL_LISTS_SET_ENTRY 0x6c5ea359
+#define TL_LISTS_ADD_ENTRY 0x5e4e0595
+#define TL_LISTS_REPLACE_ENTRY 0x46e9f3d5
+#define TL_LISTS_SET_ENTRY_TEXT 0xe688bf77
+#define TL_LISTS_SET_FLAGS 0x00798bc4
+#define TL_LISTS_CHANGE_FLAGS 0x42e00d32
+#define TL_LISTS_INCR_FLAGS 0x6b8442c6
+#define TL_LISTS_DECR_FLAGS 0xb878b49a
+#define TL_LISTS_SET_VALUE 0x59fce4ae
+#define TL_LISTS_INCR_VALUE 0xa4075e15
+#define TL_LISTS_DECR_VALUE 0x3a9c8cf9
+#define TL_LISTS_INCR_VALUE_OR_CREATE 0x71fa7282
+#define TL_LISTS_DECR_VALUE_OR_CREATE 0x07930da9
+#define TL_LISTS_SET_LIST_FLAGS 0xf0aa9c2a
+#define TL_LISTS_CHANGE_LIST_FLAGS 0x6f6c5fda
+#define TL_LISTS_CHANGE_LIST_FLAGS_EX 0x0b492927
+#define TL_LISTS_DELETE_SUBLIST 0x28491039
+#define TL_LISTS_DELETE_SUBLIST_EX 0x5767e95f
+#define TL_LISTS_GET_ENTRY 0x78afe46c
+#define TL_LISTS_GET_ENTRY_FLAGS 0x7a731db7
+#define TL_LISTS_GET_ENTRY_DATE 0x24c6216e
+#define TL_LISTS_GET_ENTRY_VALUE 0xc559fdd6
+#define TL_LISTS_GET_ENTRY_GLOBAL_ID 0x20f09910
+#define TL_LISTS_GET_ENTRY_TEXT 0xaa53d269
+#define TL_LISTS_GET_ENTRY_POS 0xa417d47c
+#define TL_LISTS_GET_LIST 0x90b75292
+#define TL_LISTS_GET_LIST_LIMIT 0xf5f11398
+#define TL_LISTS_GET_LIST_FULL 0x19ecd4e1
+#define TL_LISTS_GET_LIST_FULL_LIMIT 0x1af623c1
+#define TL_LISTS_GET_LIST_COUNT 0xd55f9296
+#define TL_LISTS_GET_SUBLIST_COUNT 0x3b687155
+#define TL_LISTS_GET_SUBLISTS_COUNT 0x4685bee4
+#define TL_LISTS_INTERSECT 0xd79a3438
+#define TL_LISTS_INTERSECT_LIMIT 0x22f2a7e7
+#define TL_LISTS_INTERSECT_FULL 0xd29f0428
+#define TL_LISTS_INTERSECT_FULL_LIMIT 0xdee58818
+#define TL_LISTS_INTERSECT_WILD 0x2fcf378c
+#define TL_LISTS_INTERSECT_WILD_LIMIT 0x36706bba
+#define TL_LISTS_INTERSECT_WILD_FULL 0x41ea201c
+#define TL_LISTS_INTERSECT_WILD_FULL_LIMIT 0xc6ac88ce
+#define TL_LISTS_SUBTRACT 0x8e925d31
+#define TL_LISTS_SUBTRACT_LIMIT 0x8dda7311
+#define TL_LISTS_SUMLIST 0x2d7c883a
+#define TL_LISTS_SUMLIST_WILD 0xf1d75c0e
+#define TL_LISTS_SUMLIST_WEIGHTED 0xb36506cf
+#define TL_LISTS_SUMLIST_WEIGHTED_WILD 0x7c9a5f4c
+#define TL_LISTS_SORTED_LIST 0xe649273a
+#define TL_LISTS_SORTED_LIST_LIMIT 0xb46e9d8a
+#define TL_LISTS_SORTED_LIST_FULL 0xee32258f
+#define TL_LISTS_SORTED_LIST_FULL_LIMIT 0xf5206424
+#define TL_LISTS_DATEDISTR 0x0f11f0cb
+#define TL_SEARCH_OBJECT_ID 0xff5feada
+#define TL_SEARCH_RESTRICTIONS 0x7693b8f8
+#define TL_SEARCH_ONE_RESULT 0xd346757e
+#define TL_SEARCH_RESULT 0xe398a0ce
+#define TL_SEARCH_ONE_NORMALIZE 0x108a3701
+#define TL_SEARCH_NORMALIZE 0x5584a63f
+#define TL_SEARCH_SET_RATE 0x3454d539
+#define TL_SEARCH_INCR_RATE 0x7c20bb8c
+#define TL_SEARCH_DECR_RATE 0x87edd3f1
+#define TL_SEARCH_GET_RATE 0x42d47aa1
+#define TL_SEARCH_SET_HASH 0xafa7f14c
+#define TL_SEARCH_GET_HASH 0x3e5f7ad5
+#define TL_SEARCH_DELETE_ITEM 0xe8b1c0dd
+#define TL_SEARCH_SET_ITEM 0xc44fa121
+#define TL_SEARCH_ADD_TAGS 0x6ff0a683
+#define TL_SEARCH_DELETE_WITH_HASH 0x47b09d01
+#define TL_SEARCH_DELETE_WITH_HASHES 0x58c9c3a0
+#define TL_SEARCH_INCR_RATE_BY_HASH 0x15ab21c2
+#define TL_SEARCH_CHANGE_RATES 0x9e96f03b
+#define TL_SEARCH_SEARCH 0x67abe30a
+#define TL_STATSX_INT_KEY 0xacdf64fe
+#define TL_STATSX_STR_KEY 0x58c1f199
+#define TL_STATSX_MONTH 0xb7e7c48f
+#define TL_STATSX_COUNTER 0xd4ec3eb0
+#define TL_STATSX_INCR 0x96d430f4
+#define TL_STATSX_INCR_SUBCNT 0x2ea77ad6
+#define TL_STATSX_DECR 0xe64b44ed
+#define TL_STATSX_DECR_SUBCNT 0x958e0fde
+#define TL_STATSX_INCR_VERSION 0xd804a587
+#define TL_STATSX_INCR_SUBCNT_VERSION 0x43e58a49
+#define TL_STATSX_DECR_VERSION 0x63fc9247
+#define TL_STATSX_DECR_SUBCNT_VERSION 0xdffd57ee
+#define TL_STATSX_GET_VIEWS 0xd2613bb0
+#define TL_STATSX_GET_VIEWS_VERSION 0x8fe648f2
+#define TL_STATSX_GET_VISITORS 0x4d2aa62e
+#define TL_STATSX_GET_VISITORS_VERSION 0x3d570df2
+#define TL_STATSX_ENABLE_COUNTER 0x1c5fd60d
+#define TL_STATSX_DISABLE_COUNTER 0xba2c5d02
+#define TL_STATSX_SET_TIMEZONE 0xb4904481
+#define TL_STATSX_GET_COUNTER 0xf9c09e4a
+#define TL_STATSX_GET_COUNTER_VERSION 0x9e960646
+#define TL_STATSX_GET_COUNTER_MASK 0x7ed27ec0
+#define TL_STATSX_GET_COUNTER_MASK_VERSION 0xc0c2c735
+#define TL_STATSX_GET_VERSIONS 0xa5fdcb30
+#define TL_STATSX_GET_MONTHLY_VISITORS 0x5cf4dce3
+#define TL_STATSX_GET_MONTHLY_VIEWS 0x3b5fa5ea
+#define TL_STATSX_GET_COUNTERS_SUM 0x6eca5b0e
+#define TL_TEXT_MESSAGE 0x11613775
+#define TL_TEXT_MESSAGE_FULL_ID 0x8e98031c
+#define TL_TEXT_SUBLIST_TYPE 0x3bd33f3b
+#define TL_TEXT_EVENT_OLD 0x25f09fef
+#define TL_TEXT_EVENT_BASE 0x418394ff
+#define TL_TEXT_EVENT_EX 0xd7bd0ef7
+#define TL_TEXT_EVENT_LIST_OLD 0x211ccf03
+#define TL_TEXT_EVENT_LIST 0x14d8926e
+#define TL_TEXT_ONLINE_FRIEND 0xe0e59354
+#define TL_TEXT_RESULT_SIZE_LIST 0xd0c6d9c0
+#define TL_TEXT_GET_MESSAGE_SHORT 0xb2ce085b
+#define TL_TEXT_GET_MESSAGE 0x248171bc
+#define TL_TEXT_CONVERT_LEGACY_ID 0x0e9bd317
+#define TL_TEXT_CONVERT_RANDOM_ID 0xae37445a
+#define TL_TEXT_PEER_MSG_LIST 0xb176e192
+#define TL_TEXT_PEER_MSG_LIST_POS 0x6eea623e
+#define TL_TEXT_TOP_MSG_LIST 0x3951c842
+#define TL_TEXT_SUBLIST_SHORT 0xfac62f29
+#define TL_TEXT_SUBLIST 0x34802e81
+#define TL_TEXT_SUBLIST_POS 0x2666e082
+#define TL_TEXT_SUBLIST_TYPES 0xa1cefc9c
+#define TL_TEXT_PEERMSG_TYPE 0x7cbfc43c
+#define TL_TEXT_SEND_MESSAGE 0x1a8d47de
+#define TL_TEXT_DELETE_MESSAGE 0x99b39198
+#define TL_TEXT_DELETE_FIRST_MESSAGES 0x3d8bc243
+#define TL_TEXT_GET_MESSAGE_FLAGS 0x4d0aef0d
+#define TL_TEXT_SET_MESSAGE_FLAGS 0xe887ffb0
+#define TL_TEXT_INCR_MESSAGE_FLAGS 0x6ea30103
+#define TL_TEXT_DECR_MESSAGE_FLAGS 0x61ce5093
+#define TL_TEXT_GET_MESSAGEEXTRA 0xa2a2d031
+#define TL_TEXT_SET_MESSAGEEXTRA 0x4c564dfe
+#define TL_TEXT_INCR_MESSAGEEXTRA 0x33111fb8
+#define TL_TEXT_DECR_MESSAGEEXTRA 0xe9148763
+#define TL_TEXT_GET_MESSAGE_EXTRA 0xa5009fde
+#define TL_TEXT_SET_MESSAGE_EXTRA 0x37f30733
+#define TL_TEXT_INCR_MESSAGE_EXTRA 0x7d25cade
+#define TL_TEXT_DECR_MESSAGE_EXTRA 0xe13d1779
+#define TL_TEXT_DELETE_USERDATA 0x9a8566bb
+#define TL_TEXT_GET_USERDATA 0xa32e8142
+#define TL_TEXT_LOAD_USERDATA 0x1251b4d1
+#define TL_TEXT_REPLACE_MESSAGE_TEXT 0x84a7e012
+#define TL_TEXT_GET_EXTRA_MASK 0xce45b8b5
+#define TL_TEXT_SET_EXTRA_MASK 0x1035a059
+#define TL_TEXT_SEARCH 0xdc6a4fd0
+#define TL_TEXT_SEARCH_EX 0x6e78a36a
+#define TL_TEXT_GET_TIMESTAMP 0x4b4656b0
+#define TL_TEXT_GET_FORCE_TIMESTAMP 0x93e3e6a5
+#define TL_TEXT_HISTORY 0xeb0864fb
+#define TL_TEXT_HISTORY_ACTION 0x75c1f71e
+#define TL_TEXT_GET_P_TIMESTAMP 0xc825a0fa
+#define TL_TEXT_P_HISTORY 0xc960e9c0
+#define TL_TEXT_ONLINE 0x23a22073
+#define TL_TEXT_OFFLINE 0x87327f49
+#define TL_TEXT_ONLINE_FRIENDS 0x0fdfa2f0
+#define TL_TEXT_ONLINE_FRIENDS_ID 0x22b0c97f
+#define TL_TEXT_SET_SECRET 0xe6164a53
+#define TL_TEXT_GET_SECRET 0x0b3a1c69
+#define TL_TEXT_DELETE_SECRET 0xd645798e
+#define TL_CACHE_TOP_ACCESS_RECORD 0x1b6dffe7
+#define TL_CACHE_BOTTOM_DISK_RECORD 0x9406cd85
+#define TL_CACHE_YELLOW_TIME 0x705f8e0c
+#define TL_CACHE_LOCAL_COPY 0x0948dcb8
+#define TL_CACHE_SERVER_STAT 0x08623ed7
+#define TL_CACHE_ACCESS 0xd042a0cd
+#define TL_CACHE_SET_FILE_SIZE 0x574eadb2
+#define TL_CACHE_SET_YELLOW_TIME_REMAINING 0x0141c7c4
+#define TL_CACHE_SET_NEW_LOCAL_COPY 0x8f934d77
+#define TL_CACHE_DELETE_LOCAL_COPY 0xd743245a
+#define TL_CACHE_DISABLE_SERVER 0x4df8ca78
+#define TL_CACHE_ENABLE_SERVER 0xbb5ef67e
+#define TL_CACHE_DISABLE_DISK 0xd686a110
+#define TL_CACHE_ENABLE_DISK 0x78110379
+#define TL_CACHE_DELETE_SERVER 0x632411f2
+#define TL_CACHE_DELETE_DISK 0x7fc3c6ae
+#define TL_CACHE_CONVERT 0x31ba3b52
+#define TL_CACHE_GET_FILE_SIZE 0x94c7fc5b
+#define TL_CACHE_GET_LOCAL_COPIES 0x3d0445b8
+#define TL_CACHE_GET_YELLOW_TIME 0x6b40d593
+#define TL_CACHE_GET_TOP_ACCESS 0x2d0d1ba0
+#define TL_CACHE_GET_BOTTOM_ACCESS 0xd68770bb
+#define TL_CACHE_GET_BOTTOM_DISK 0xa2a42a38
+#define TL_CACHE_GET_TOP_DISK 0xbac36d9c
+#define TL_CACHE_GET_ACOUNTER 0x5be56334
+#define TL_CACHE_GET_SERVER_STATS 0xda9fa9ae
+#define TL_RANDOM_RANDOM 0x034a89f5
+#define TL_STORAGE_VOLUMES 0xf4a9f5db
+#define TL_STORAGE_FILE_LOCATION 0xb5c22ead
+#define TL_STORAGE_FILE_UNKNOWN 0xaa963b05
+#define TL_STORAGE_FILE_JPEG 0x007efe0e
+#define TL_STORAGE_FILE_GIF 0xcae1aadf
+#define TL_STORAGE_FILE_PNG 0x0a4f63c0
+#define TL_STORAGE_FILE_PDF 0xae1e508d
+#define TL_STORAGE_FILE_MP3 0x528a0677
+#define TL_STORAGE_FILE_MOV 0x4b09ebbc
+#define TL_STORAGE_FILE_PARTIAL 0x40bc6f52
+#define TL_STORAGE_FILE_MP4 0xb3cea0e4
+#define TL_STORAGE_FILE_WEBP 0x1081464c
+#define TL_STORAGE_FILE_CONTENT 0x75884317
+#define TL_STORAGE_FILE_FORWARDED_INFO 0xfba204b8
+#define TL_STORAGE_GLOBAL_PID 0x2efc5060
+#define TL_STORAGE_GET_VOLUMES 0x7b6aa11f
+#define TL_STORAGE_CHECK_FILE 0xde17d771
+#define TL_STORAGE_UPLOAD_FILE 0x73d34b61
+#define TL_STORAGE_UPLOAD_FILE_EXT 0xb84bf12d
+#define TL_STORAGE_GET_FILE 0x1b6c3c3c
+#define TL_STORAGE_GET_FILE_INDIRECT 0x0c027214
+#define TL_STORAGE_GET_PART 0x986953c6
+#define TL_STORAGE_GET_PART_INDIRECT 0xe296b571
+#define TL_WEIGHTS_UPDATE 0x75a265b7
+#define TL_WEIGHTS_SMALL_UPDATE 0x23f7e37d
+#define TL_WEIGHTS_SET_HALF_LIFE 0x19bd979c
+#define TL_WEIGHTS_INCR 0x14ad148a
+#define TL_WEIGHTS_AT 0xec4cd91b
+#define TL_WEIGHTS_GET_VECTOR 0x54c3a60c
+#define TL_WEIGHTS_SUBSCRIBE 0x174349d1
+#define TL_WEIGHTS_SEND_UPDATES 0xa5f3781f
+#define TL_WEIGHTS_SEND_SMALL_UPDATES 0x24912c4c
+#define TL_FRIENDS_FRIEND 0x1f7974dc
+#define TL_FRIENDS_DELETE_USER 0x9f3041af
+#define TL_FRIENDS_GET_FRIENDS_ID 0x968544ec
+#define TL_FRIENDS_GET_FRIENDS 0x40321db8
+#define TL_FRIENDS_GET_FRIENDS_CNT 0x4561e0ef
+#define TL_FRIENDS_GET_RECENT_FRIENDS 0x783e613d
+#define TL_FRIENDS_SET_CAT_LIST 0xaa8daf6f
+#define TL_FRIENDS_DELETE_CAT 0x84c67759
+#define TL_FRIENDS_GET_FRIEND 0x26410ec6
+#define TL_FRIENDS_SET_FRIEND 0x7c1bb8a6
+#define TL_FRIENDS_REPLACE_FRIEND 0x658c14d0
+#define TL_FRIENDS_DELETE_FRIEND 0x1091eab6
+#define TL_FRIENDS_INCR_FRIEND 0x487aabc7
+#define TL_FRIENDS_DECR_FRIEND 0xa0cc1f55
+#define TL_FRIENDS_GET_FRIEND_REQ 0x3046d048
+#define TL_FRIENDS_ADD_FRIEND_REQ 0xbe216d65
+#define TL_FRIENDS_SET_FRIEND_REQ 0x0bf3ea67
+#define TL_FRIENDS_REPLACE_FRIEND_REQ 0x37560b9e
+#define TL_FRIENDS_DELETE_FRIEND_REQ 0x7b3c144f
+#define TL_FRIENDS_DELETE_REQS 0x3fe0055a
+#define TL_FRIENDS_GET_REQS 0x5c6f4f2d
+#define TL_FRIENDS_SET_PRIVACY 0x9628a745
+#define TL_FRIENDS_REPLACE_PRIVACY 0x5275481c
+#define TL_FRIENDS_GET_PRIVACY 0x8f5c046b
+#define TL_FRIENDS_DELETE_PRIVACY 0x371cc41c
+#define TL_FRIENDS_CHECK_PRIVACY 0xa43a3cb0
+#define TL_FRIENDS_CHECK_PRIVACY_LIST 0xea338bda
+#define TL_FRIENDS_GET_COMMON_FRIENDS_NUM 0x8932a76f
+#define TL_FRIENDS_GET_COMMON_FRIENDS 0xf0a891bc
+#define TL_NEWS_TYPES_GROUP 0x59ae4550
+#define TL_NEWS_USER_IDS_GROUP 0x85547f1f
+#define TL_NEWS_DATES_GROUP 0x008a6316
+#define TL_NEWS_TAGS_GROUP 0x3a672b82
+#define TL_NEWS_USERS_GROUP 0x8d69950f
+#define TL_NEWS_GROUPS_GROUP 0x9e3ae44f
+#define TL_NEWS_OWNERS_GROUP 0xcc8f5c41
+#define TL_NEWS_PLACES_GROUP 0x5e2bfd5d
+#define TL_NEWS_ITEMS_GROUP 0x2d7d4598
+#define TL_NEWS_UPDATES_GROUP 0xf26e845b
+#define TL_NEWS_RAW_UPDATES_RECORD 0x5a661562
+#define TL_CNEWS_OBJECT_ID 0x3f1faca3
+#define TL_CNEWS_RAW_UPDATES_RECORD 0x31708383
+#define TL_NNEWS_GET_UPDATES_RECORD 0x2cd5ba9f
+#define TL_NNEWS_GROUP_RECORD 0xaac7330f
+#define TL_RNEWS_RATED_USER 0xc8a6836d
+#define TL_RNEWS_RAW_UPDATES_RECORD 0x6100b5b1
+#define TL_NEWS_UPDATE 0x86bcf69b
+#define TL_NEWS_DELETE_UPDATES 0x386132e5
+#define TL_NEWS_SET_PRIVACY_MASK 0xb8055c3a
+#define TL_NEWS_GET_PRIVACY_MASK 0xfe37f9f8
+#define TL_NEWS_GET_RAW_UPDATES 0x790875a8
+#define TL_NEWS_GET_GROUPED_UPDATES 0xc546265c
+#define TL_CNEWS_UPDATE 0x45b10aa1
+#define TL_CNEWS_DELETE_UPDATES 0x99a56afb
+#define TL_CNEWS_DELETE_UPDATE 0xf20bc405
+#define TL_CNEWS_UNDELETE_UPDATE 0x1f10af91
+#define TL_CNEWS_GET_RAW_UPDATES 0x5ba75aed
+#define TL_CNEWS_GET_GROUPED_UPDATES 0x713f1eb2
+#define TL_CNEWS_GET_RAW_USER_UPDATES 0xed6444cc
+#define TL_CNEWS_GET_GROUPED_USER_UPDATES 0x183a9c6a
+#define TL_CNEWS_ADD_BOOKMARK 0x0514c496
+#define TL_CNEWS_DEL_BOOKMARK 0x9d884c51
+#define TL_NNEWS_UPDATE 0x8b85c35e
+#define TL_NNEWS_DELETE_UPDATES 0x2581db7d
+#define TL_NNEWS_DELETE_UPDATE 0xf5499cf7
+#define TL_NNEWS_UNDELETE_UPDATE 0xb9f4ae8c
+#define TL_NNEWS_DELETE_USER_UPDATE 0xf765c7c9
+#define TL_NNEWS_UNDELETE_USER_UPDATE 0x9115e074
+#define TL_NNEWS_GET_UPDATES 0x67a9c9b7
+#define TL_NNEWS_GET_GROUPED_UPDATES 0x11c361e0
+#define TL_RNEWS_UPDATE 0x93edda1f
+#define TL_RNEWS_SET_RATE 0x4b2ca5f7
+#define TL_RNEWS_GET_RATE 0x157497e8
+#define TL_RNEWS_GET_RAW_UPDATES 0x3e40450e
+#define TL_RNEWS_GET_GROUPED_UPDATES 0x36f0d5bd
+#define TL_HINTS_OBJECT 0x5c87c5e5
+#define TL_HINTS_OBJECT_RATING 0x97a35b8c
+#define TL_HINTS_OBJECT_TEXT 0xee183f12
+#define TL_HINTS_OBJECT_FULL 0xae0e24f3
+#define TL_RATING_OBJECT 0x525f8e3d
+#define TL_RATING_OBJECT_RATING 0x5a8c2841
+#define TL_HINTS_NULLIFY_RATING 0x9bc0edb4
+#define TL_HINTS_SET_RATING_STATE 0x8ee96409
+#define TL_HINTS_SET_INFO 0xc9f21446
+#define TL_HINTS_SET_WINNER 0x83813fa5
+#define TL_HINTS_SET_RATING 0x43187901
+#define TL_HINTS_SET_TEXT 0x8d9b4188
+#define TL_HINTS_SET_TYPE 0xe6a5d8eb
+#define TL_HINTS_SET_TEXT_GLOBAL 0x31237625
+#define TL_HINTS_SET_TYPE_GLOBAL 0xfdbd3840
+#define TL_HINTS_GET_INFO 0x1023ff8c
+#define TL_HINTS_SORT 0x1a9c1bc3
+#define TL_HINTS_GET_RANDOM 0xf399845e
+#define TL_HINTS_GET_HINTS 0xfb8a60a7
+#define TL_HINTS_GET_HINTS_RATING 0xeef8097c
+#define TL_HINTS_GET_HINTS_TEXT 0x69d17e20
+#define TL_HINTS_GET_HINTS_FULL 0x819a89d4
+#define TL_HINTS_GET_HINTS_LATIN 0x95b7823d
+#define TL_HINTS_GET_HINTS_LATIN_RATING 0x1ee52ad9
+#define TL_HINTS_GET_HINTS_LATIN_TEXT 0xdd48bc78
+#define TL_HINTS_GET_HINTS_LATIN_FULL 0x35034b8c
+#define TL_HINTS_GET_OBJECT_TEXT 0x114735bf
+#define TL_HINTS_DELETE_OBJECT 0x8bd4578d
+#define TL_HINTS_DELETE_OBJECT_GLOBAL 0xe55500f5
+#define TL_HINTS_INCREMENT_RATING 0x74272673
+#define TL_RATING_NULLIFY_RATING 0xc4f5dd8d
+#define TL_RATING_SET_RATING_STATE 0x7bca6a4f
+#define TL_RATING_SET_INFO 0x6bbd38d6
+#define TL_RATING_SET_WINNER 0x1d2e3880
+#define TL_RATING_SET_TYPE 0xe5ad1bff
+#define TL_RATING_SET_RATING 0xb02df2b1
+#define TL_RATING_ADD_OBJECT 0xd9bda5a6
+#define TL_RATING_SET_TYPE_GLOBAL 0xd7b5aa32
+#define TL_RATING_GET_INFO 0x209bceb5
+#define TL_RATING_SORT 0xe1b9b76e
+#define TL_RATING_GET_RANDOM 0xc184dbf3
+#define TL_RATING_GET_HINTS 0xe1fa8cf4
+#define TL_RATING_GET_HINTS_RATING 0x8f4a6f04
+#define TL_RATING_GET_RANDOM_HINTS 0x992d3ffd
+#define TL_RATING_GET_RANDOM_HINTS_RATING 0x223cb8ea
+#define TL_RATING_DELETE_OBJECT 0x149e9026
+#define TL_RATING_DELETE_OBJECT_GLOBAL 0xc99f11a2
+#define TL_RATING_INCREMENT_RATING 0x8712adc3
+#define TL_ISEARCH_TYPE_INFO 0x5d3cc87e
+#define TL_ISEARCH_ADD_SEARCH_QUERY 0x8251ff98
+#define TL_ISEARCH_GET_HINTS 0x565cce21
+#define TL_ISEARCH_GET_TYPES 0x4d8d8dc7
+#define TL_ISEARCH_GET_SUGGESTION 0x38b97050
+#define TL_ISEARCH_GET_TOP 0x1357f3d7
+#define TL_ISEARCH_GET_BEST 0x962322b4
+#define TL_ISEARCH_ADD_BLACK_LIST 0x2cebc23c
+#define TL_ISEARCH_DELETE_BLACK_LIST 0xe3544c71
+#define TL_ISEARCH_GET_BLACK_LIST 0xd55ab633
+#define TL_ISEARCH_FORCE_UPDATE_BLACK_LIST 0x7acfb727
+#define TL_PHOTO_PHOTO_LOCATION 0xe75e5e39
+#define TL_PHOTO_AUDIO_LOCATION 0x5dd41bef
+#define TL_PHOTO_VIDEO_LOCATION 0x0dd3d270
+#define TL_PHOTO_PHOTO_LOCATION_STORAGE 0xa88403da
+#define TL_PHOTO_AUDIO_LOCATION_STORAGE 0x69bcb751
+#define TL_PHOTO_VIDEO_LOCATION_STORAGE 0x8ae385ff
+#define TL_PHOTO_PHOTO 0x2469893a
+#define TL_PHOTO_AUDIO 0x7ab683e6
+#define TL_PHOTO_VIDEO 0xcbb6b387
+#define TL_PHOTO_PHOTO_ALBUM 0x691a0984
+#define TL_PHOTO_AUDIO_ALBUM 0xc5a21f77
+#define TL_PHOTO_VIDEO_ALBUM 0x7bbe3606
+#define TL_PHOTO_CHANGE_PHOTO 0xaa81d661
+#define TL_PHOTO_CHANGE_PHOTO_ALBUM 0xb8c9222f
+#define TL_PHOTO_CHANGE_AUDIO 0x29bf54b6
+#define TL_PHOTO_CHANGE_AUDIO_ALBUM 0x5fc969b5
+#define TL_PHOTO_CHANGE_VIDEO 0xd26bd91a
+#define TL_PHOTO_CHANGE_VIDEO_ALBUM 0x93a2903d
+#define TL_PHOTO_INCREMENT_PHOTO_FIELD 0x82d012d3
+#define TL_PHOTO_INCREMENT_AUDIO_FIELD 0xb0280808
+#define TL_PHOTO_INCREMENT_VIDEO_FIELD 0x3b3728ae
+#define TL_PHOTO_INCREMENT_ALBUM_FIELD 0x208db029
+#define TL_PHOTO_SET_VOLUME_SERVER 0x536b17da
+#define TL_PHOTO_DELETE_LOCATION_STORAGE 0x9196aeae
+#define TL_PHOTO_DELETE_LOCATION 0x3174408a
+#define TL_PHOTO_DELETE_ORIGINAL_LOCATION_STORAGE 0xff49dcbc
+#define TL_PHOTO_DELETE_ORIGINAL_LOCATION 0x1cdbd0ba
+#define TL_PHOTO_CHANGE_LOCATION_SERVER 0xcad8b2ad
+#define TL_PHOTO_CHANGE_ORIGINAL_LOCATION_SERVER 0x852693fa
+#define TL_PHOTO_CHANGE_LOCATION_SERVER2 0xe184c240
+#define TL_PHOTO_CHANGE_ORIGINAL_LOCATION_SERVER2 0x14c4f836
+#define TL_PHOTO_SAVE_PHOTO_LOCATION 0xb91ce359
+#define TL_PHOTO_RESTORE_PHOTO_LOCATION 0x3ec57f87
+#define TL_PHOTO_ROTATE_PHOTO 0x0fc8045c
+#define TL_PHOTO_CHANGE_PHOTO_ORDER 0x1393c62a
+#define TL_PHOTO_CHANGE_AUDIO_ORDER 0xe7c5e421
+#define TL_PHOTO_CHANGE_VIDEO_ORDER 0x00b8b02e
+#define TL_PHOTO_CHANGE_ALBUM_ORDER 0x1779583a
+#define TL_PHOTO_NEW_PHOTO_FORCE 0x6e00fe86
+#define TL_PHOTO_NEW_AUDIO_FORCE 0xcc1c5fc2
+#define TL_PHOTO_NEW_VIDEO_FORCE 0xf0293f5b
+#define TL_PHOTO_NEW_ALBUM_FORCE 0xa67ab146
+#define TL_PHOTO_NEW_PHOTO 0x3ff3e78b
+#define TL_PHOTO_NEW_AUDIO 0xbf78d33d
+#define TL_PHOTO_NEW_VIDEO 0x4241e929
+#define TL_PHOTO_NEW_ALBUM 0x228aa7a8
+#define TL_PHOTO_GET_PHOTOS_OVERVIEW 0xf791fdde
+#define TL_PHOTO_GET_PHOTOS_OVERVIEW_COUNT 0x9d9e2228
+#define TL_PHOTO_GET_PHOTOS_COUNT 0xf16ea5bf
+#define TL_PHOTO_GET_AUDIOS_COUNT 0x6ec072e9
+#define TL_PHOTO_GET_VIDEOS_COUNT 0xadf3c251
+#define TL_PHOTO_GET_ALBUMS_COUNT 0xe9e2b54c
+#define TL_PHOTO_GET_PHOTOS 0xe1ff6ec3
+#define TL_PHOTO_GET_PHOTOS_WITH_COUNT 0x46730412
+#define TL_PHOTO_GET_AUDIOS 0xb0975096
+#define TL_PHOTO_GET_AUDIOS_WITH_COUNT 0xc0afaa9e
+#define TL_PHOTO_GET_VIDEOS 0xe3572ade
+#define TL_PHOTO_GET_VIDEOS_WITH_COUNT 0x2ba290ec
+#define TL_PHOTO_GET_PHOTO_ALBUMS 0x2a9e4291
+#define TL_PHOTO_GET_PHOTO_ALBUMS_WITH_COUNT 0x3cadfa78
+#define TL_PHOTO_GET_AUDIO_ALBUMS 0xfe8190c6
+#define TL_PHOTO_GET_AUDIO_ALBUMS_WITH_COUNT 0xbff9f8dc
+#define TL_PHOTO_GET_VIDEO_ALBUMS 0x7cfc78b7
+#define TL_PHOTO_GET_VIDEO_ALBUMS_WITH_COUNT 0x99a2ea71
+#define TL_PHOTO_GET_PHOTO 0xea4e08f8
+#define TL_PHOTO_GET_AUDIO 0x792a6d23
+#define TL_PHOTO_GET_VIDEO 0xdea33122
+#define TL_PHOTO_GET_PHOTO_ALBUM 0x60d7649f
+#define TL_PHOTO_GET_AUDIO_ALBUM 0xcc7ce3a3
+#define TL_PHOTO_GET_VIDEO_ALBUM 0xa7a878fb
+#define TL_PHOTO_RESTORE_PHOTO 0x1e8b3b25
+#define TL_PHOTO_RESTORE_AUDIO 0xa073ee3d
+#define TL_PHOTO_RESTORE_VIDEO 0x918fb5a7
+#define TL_PHOTO_DELETE_PHOTO 0x224bf91c
+#define TL_PHOTO_DELETE_AUDIO 0x9cb32c04
+#define TL_PHOTO_DELETE_VIDEO 0xad4f779e
+#define TL_PHOTO_DELETE_ALBUM 0xf460c6e2
+#define TL_TARG_AD_VIEWS_CNT 0xb09ca295
+#define TL_TARG_AD_USER_VIEWS_CNT 0xea3798e0
+#define TL_TARG_T_AD_INFO 0xc74d1e57
+#define TL_TARG_PRICES_RESULT 0xe669b97c
+#define TL_TARG_AUDIENCE_RESULT 0xc9201e99
+#define TL_TARG_SEARCH_RESULT 0x3f386e80
+#define TL_TARG_USER_AD 0x13225886
+#define TL_TARG_AD_ENABLE 0x9ac0c193
+#define TL_TARG_AD_ENABLE_PRICE 0xcbf3ba86
+#define TL_TARG_AD_DISABLE 0xe52206db
+#define TL_TARG_AD_SET_CTR 0x0d44b053
+#define TL_TARG_AD_SET_SUMP 0xd630f89d
+#define TL_TARG_AD_SET_CTR_SUMP 0x46254daa
+#define TL_TARG_AD_SET_AUD 0xcec66c9e
+#define TL_TARG_AD_LIMITED_VIEWS 0xbfd18882
+#define TL_TARG_AD_VIEWS_RATE_LIMIT 0xee9d3b97
+#define TL_TARG_AD_SITES 0xd6b80758
+#define TL_TARG_AD_SET_FACTOR 0x3bcfeda2
+#define TL_TARG_AD_SET_DOMAIN 0xc64fd844
+#define TL_TARG_AD_SET_CATEGORIES 0x14cd31e4
+#define TL_TARG_AD_SET_GROUP 0x0164a5e0
+#define TL_TARG_AD_CLICKS 0x648204a7
+#define TL_TARG_AD_CTR 0x9de0f969
+#define TL_TARG_AD_SUMP 0xefdeec9d
+#define TL_TARG_AD_CTR_SUMP 0x1aa74beb
+#define TL_TARG_AD_MONEY 0xee207998
+#define TL_TARG_AD_VIEWS 0x8e9cd9a6
+#define TL_TARG_AD_RECENT_VIEWS 0xf6ad7268
+#define TL_TARG_RECENT_VIEWS_STATS 0x389f9fa3
+#define TL_TARG_RECENT_AD_VIEWERS 0x35a41a92
+#define TL_TARG_AD_INFO 0xab943de6
+#define TL_TARG_AD_QUERY 0x4b192723
+#define TL_TARG_RECENT_USER_ADS 0xb6296aee
+#define TL_TARG_RECENT_USER_ADS_CNT 0x274d99df
+#define TL_TARG_USER_GROUPS 0x0afcc51b
+#define TL_TARG_USER_CLICK 0x5326e2da
+#define TL_TARG_USER_VIEW 0xe734b324
+#define TL_TARG_USER_FLAGS 0xbe379d4a
+#define TL_TARG_USER_CLICKED_AD 0xdb27a9f2
+#define TL_TARG_DELETE_GROUP 0xa5ddece2
+#define TL_TARG_TARGET 0x215b5187
+#define TL_TARG_PRICES 0x1d473774
+#define TL_TARG_AD_PRICING 0x8ae0abc4
+#define TL_TARG_TARG_AUDIENCE 0xfefd0536
+#define TL_TARG_AUDIENCE 0x4c4888d3
+#define TL_TARG_SEARCH 0x03948b5f
+#define TL_TARG_USER_ADS 0x25f53fb6
+#define TL_TARG_SET_SEX 0x0f821b03
+#define TL_TARG_SET_OPERATOR 0x1771d976
+#define TL_TARG_SET_BROWSER 0x851cec68
+#define TL_TARG_SET_REGION 0xe6251165
+#define TL_TARG_SET_HEIGHT 0x6de183ef
+#define TL_TARG_SET_SMOKING 0xa445af88
+#define TL_TARG_SET_ALCOHOL 0xd9e2f24d
+#define TL_TARG_SET_PPRIORITY 0x0ec088a8
+#define TL_TARG_SET_IIOTHERS 0xee6ca256
+#define TL_TARG_SET_HIDDEN 0x1b01f39b
+#define TL_TARG_SET_CVISITED 0xbd1ba9fb
+#define TL_TARG_SET_GCOUNTRY 0x18ff016b
+#define TL_TARG_SET_PRIVACY 0x49d6aae9
+#define TL_TARG_SET_POLITICAL 0x35b033fa
+#define TL_TARG_SET_MSTATUS 0x7688866e
+#define TL_TARG_SET_TIMEZONE 0xc1014066
+#define TL_TARG_SET_RATE 0xae04f63a
+#define TL_TARG_SET_CUTE 0x564387bf
+#define TL_TARG_SET_FLAGS 0x78c0cec7
+#define TL_TARG_SET_USER_SINGLE_GROUP_TYPE 0x94916edc
+#define TL_TARG_SET_USER_LANG 0x5f9ab891
+#define TL_TARG_SET_CUSTOM 0x89a81728
+#define TL_TARG_SET_RATES 0x575a8251
+#define TL_TARG_SET_USERNAME 0x17aeb25b
+#define TL_TARG_SET_USER_GROUP_TYPES 0xaf942b38
+#define TL_TARG_SET_COUNTRY_CITY 0x03cd05c7
+#define TL_TARG_SET_BIRTHDAY 0xa2ee9e7e
+#define TL_TARG_SET_RELIGION 0xeb0f5d1b
+#define TL_TARG_SET_HOMETOWN 0x2c570c46
+#define TL_TARG_SET_PROPOSAL 0xa8d7f255
+#define TL_TARG_SET_SCHOOL 0xc6001301
+#define TL_TARG_SET_EDUCATION 0xb430aeed
+#define TL_TARG_SET_COMPANY 0x90aae59f
+#define TL_TARG_SET_MILITARY 0x8f69d723
+#define TL_TARG_SET_ADDRESS 0x62bc1434
+#define TL_TARG_SET_INTEREST 0xad4482ae
+#define TL_TARG_SET_USER_GROUP 0x39d9bfeb
+#define TL_TARG_DELETE_USER 0xc0a9a739
+#define TL_TARG_DELETE_EDUCATION 0xc7607f07
+#define TL_TARG_DELETE_SCHOOLS 0xfa6f8096
+#define TL_TARG_DELETE_WORK 0x8ad851ac
+#define TL_TARG_DELETE_ADDRESSES 0x213304b0
+#define TL_TARG_DELETE_MILITARY 0x11395f98
+#define TL_TARG_DELETE_GROUPS 0xc9d368d4
+#define TL_TARG_DELETE_POSITIVE_GROUPS 0xabf666f9
+#define TL_TARG_DELETE_NEGATIVE_GROUPS 0x765b01b9
+#define TL_TARG_DELETE_LANGS 0xe20d852f
+#define TL_TARG_DELETE_PROPOSAL 0x8b02624a
+#define TL_TARG_DELETE_INTERESTS 0x4d086601
+#define TL_TARG_DELETE_USER_GROUP 0xf8e3b55d
+#define TL_TARG_DELETE_USER_LANG 0x02958e6d
+#define TL_TARG_DELETE_USER_GROUPS 0xc22fdbf7
+#define TL_TARG_SET_USER_GROUPS 0xaa8e719d
+#define TL_TARG_ADD_USER_GROUPS 0x1f5cf69f
+#define TL_TARG_USER_VISIT 0x638dcfce
+#define TL_NET_PID 0x46409ccf
+#define TL_NET_UDP_PACKET_UNENC_HEADER 0x00a8e945
+#define TL_NET_UDP_PACKET_ENC_HEADER 0x251a7bfd
+#define TL_UDP_RANGE 0x5efaad4a
+#define TL_UDP_RESEND_REQUEST 0x364c4dd9
+#define TL_UDP_RESEND_REQUEST_EXT 0x643736d9
+#define TL_UDP_NOP 0xab2be460
+#define TL_UDP_OBSOLETE_PID 0x6f4ac134
+#define TL_UDP_OBSOLETE_HASH 0x1adb0f4e
+#define TL_UDP_OBSOLETE_GENERATION 0xb340010b
+#define TL_UDP_DISABLE_ENCRYPTION 0x1a0e12d0
+#endif
@@ -28,6 +28,7 @@
 #define _FILE_OFFSET_BITS 64
 
 #include "pmemcached-data.h"
+#include "crc32.h"
 #include <assert.h>
 #include <unistd.h>
 #include <string.h>
@@ -53,8 +54,6 @@
 
 #define local_clock() (local_clock_counter++)
 
-extern int pack_mode;
-extern int pack_fd;
 extern int disable_cache;
 
 /*hashtable functions*/
@@ -1139,12 +1138,6 @@ int pmemcached_replay_logevent (struct lev_generic *E, int size) {
       return -2;
     }
     pmemcached_delete ( (struct lev_pmemcached_delete *)E);
-    if (pack_mode) {
-      int sn = s;
-      sn = (sn + 3) & -4;
-      write (pack_fd, E, sn);
-      //write (pack_fd, E, s);
-    }
     return s;
   case LEV_PMEMCACHED_GET:
     if (size < sizeof (struct lev_pmemcached_get)) {
@@ -1160,11 +1153,6 @@ int pmemcached_replay_logevent (struct lev_generic *E, int size) {
       return -2;
     }
     pmemcached_get ( (struct lev_pmemcached_get *)E);
-    if (pack_mode) {
-      int sn = s;
-      sn = (sn + 3) & -4;
-      write (pack_fd, E, sn);
-    }
     return s;
   case LEV_PMEMCACHED_STORE...LEV_PMEMCACHED_STORE+2:
     if (size < sizeof (struct lev_pmemcached_store)) {
@@ -1180,12 +1168,6 @@ int pmemcached_replay_logevent (struct lev_generic *E, int size) {
       return -2;
     }
     pmemcached_store ( (struct lev_pmemcached_store *)E);
-    if (pack_mode) {
-      int sn = s;
-      sn = (sn + 3) & -4;
-      write (pack_fd, E, sn);
-      //write (pack_fd, E, s);
-    }
     return s;
   case LEV_PMEMCACHED_STORE_FOREVER...LEV_PMEMCACHED_STORE_FOREVER+2:
     if (size < sizeof (struct lev_pmemcached_store_forever)) {
@@ -1200,12 +1182,6 @@ int pmemcached_replay_logevent (struct lev_generic *E, int size) {
       return -2;
     }    
     pmemcached_store_forever ((struct lev_pmemcached_store_forever*) E);
-    if (pack_mode) {
-      int sn = s;
-      sn = (sn + 3) & -4;
-      write (pack_fd, E, sn);
-      //write (pack_fd, E, s);
-    }
     return s;  
   case LEV_PMEMCACHED_INCR:
     if (size < sizeof (struct lev_pmemcached_incr)) {
@@ -1221,12 +1197,6 @@ int pmemcached_replay_logevent (struct lev_generic *E, int size) {
       return -2;
     }
     pmemcached_incr ( (struct lev_pmemcached_incr *)E);
-    if (pack_mode) {
-      int sn = s;
-      sn = (sn + 3) & -4;
-      write (pack_fd, E, sn);
-      //write (pack_fd, E, s);
-    }
     return s;
   case LEV_PMEMCACHED_INCR_TINY...LEV_PMEMCACHED_INCR_TINY+255:
     if (size < sizeof (struct lev_pmemcached_incr_tiny)) {
@@ -1242,12 +1212,6 @@ int pmemcached_replay_logevent (struct lev_generic *E, int size) {
       return -2;
     }
     pmemcached_incr_tiny ( (struct lev_pmemcached_incr_tiny *)E);
-    if (pack_mode) {
-      int sn = s;
-      sn = (sn + 3) & -4;
-      write (pack_fd, E, sn);
-      //write (pack_fd, E, s);
-    }
     return s;
   }
 
@@ -1260,6 +1224,159 @@ void pmemcached_register_replay_logevent () {
   replay_logevent = pmemcached_replay_logevent;
 }
 
+/*
+ *
+ * compact binlog: index + binlog are written as one binlog
+ * containing only the latest value of each alive key
+ *
+ */
+
+#define COMPACT_BUFF_SIZE (1 << 24)
+#define COMPACT_CRC32_INTERVAL 16384
+
+static int compact_fd, compact_ts, compact_bytes_after_crc32;
+static char *compact_buff, *compact_wptr, *compact_crc32_ptr;
+static long long compact_written;
+static unsigned compact_crc32_complement;
+
+static void compact_relax_crc32 (void) {
+  compact_crc32_complement = crc32_partial (compact_crc32_ptr, compact_wptr - compact_crc32_ptr, compact_crc32_complement);
+  compact_crc32_ptr = compact_wptr;
+}
+
+static void compact_flush (void) {
+  int s = compact_wptr - compact_buff;
+  compact_relax_crc32 ();
+  if (s > 0) {
+    int w = write (compact_fd, compact_buff, s);
+    if (w != s) {
+      fprintf (stderr, "error writing compact binlog: %d bytes written out of %d: %m\n", w, s);
+      exit (1);
+    }
+  }
+  compact_written += s;
+  compact_wptr = compact_crc32_ptr = compact_buff;
+}
+
+static void compact_write_crc32 (void);
+
+static void *compact_alloc_event (int type, int bytes) {
+  int adj_bytes = -bytes & 3;
+  bytes = (bytes + 3) & -4;
+  if (type != LEV_CRC32 && compact_bytes_after_crc32 >= COMPACT_CRC32_INTERVAL) {
+    compact_write_crc32 ();
+  }
+  assert (bytes <= COMPACT_BUFF_SIZE);
+  if (compact_wptr + bytes > compact_buff + COMPACT_BUFF_SIZE) {
+    compact_flush ();
+  }
+  struct lev_generic *E = (struct lev_generic *) compact_wptr;
+  E->type = type;
+  if (adj_bytes) {
+    memset (compact_wptr + bytes - adj_bytes, adj_bytes, adj_bytes);
+  }
+  compact_wptr += bytes;
+  compact_bytes_after_crc32 += bytes;
+  return E;
+}
+
+static void compact_write_crc32 (void) {
+  compact_relax_crc32 ();
+  long long pos = compact_written + (compact_wptr - compact_buff);
+  unsigned crc32 = ~compact_crc32_complement;
+  struct lev_crc32 *E = compact_alloc_event (LEV_CRC32, sizeof (struct lev_crc32));
+  E->timestamp = compact_ts;
+  E->pos = pos;
+  E->crc32 = crc32;
+  compact_bytes_after_crc32 = 0;
+}
+
+static void compact_store (const char *key, int key_len, int flags, int delay, const char *data, int data_len) {
+  if (!flags && delay == DELAY_INFINITY) {
+    struct lev_pmemcached_store_forever *E = compact_alloc_event (LEV_PMEMCACHED_STORE_FOREVER + pmct_set, offsetof (struct lev_pmemcached_store_forever, data) + 1 + key_len + data_len);
+    E->key_len = key_len;
+    E->data_len = data_len;
+    memcpy (E->data, key, key_len);
+    memcpy (E->data + key_len, data, data_len);
+    E->data[key_len + data_len] = 0;
+  } else {
+    struct lev_pmemcached_store *E = compact_alloc_event (LEV_PMEMCACHED_STORE + pmct_set, offsetof (struct lev_pmemcached_store, data) + 1 + key_len + data_len);
+    E->key_len = key_len;
+    E->flags = flags;
+    E->data_len = data_len;
+    E->delay = delay;
+    memcpy (E->data, key, key_len);
+    memcpy (E->data + key_len, data, data_len);
+    E->data[key_len + data_len] = 0;
+  }
+}
+
+long long pmemcached_write_compact_binlog (int fd) {
+  compact_fd = fd;
+  compact_ts = log_last_ts ? log_last_ts : time (NULL);
+  compact_written = 0;
+  compact_crc32_complement = -1;
+  compact_bytes_after_crc32 = 0;
+  compact_buff = compact_wptr = compact_crc32_ptr = malloc (COMPACT_BUFF_SIZE);
+  assert (compact_buff);
+
+  struct lev_start *S = compact_alloc_event (LEV_START, offsetof (struct lev_start, str));
+  S->schema_id = PMEMCACHED_SCHEMA_V1;
+  S->extra_bytes = 0;
+  S->split_mod = log_split_mod ? log_split_mod : 1;
+  S->split_min = log_split_mod ? log_split_min : 0;
+  S->split_max = log_split_mod ? log_split_max : 1;
+  struct lev_timestamp *T = compact_alloc_event (LEV_TIMESTAMP, sizeof (struct lev_timestamp));
+  T->timestamp = compact_ts;
+
+  /* hash entries override index entries with the same key, both sequences are sorted by key */
+  int hash_count = get_entry_cnt ();
+  hash_entry_t **p = malloc (sizeof (hash_entry_t *) * (hash_count + 1));
+  assert (p);
+  assert (dump_pointers (p, 0, hash_count) == hash_count);
+
+  double t = get_double_time_since_epoch ();
+  long long written = 0, expired = 0;
+  int i = 0, x = 0;
+  struct index_entry *I = index_get_num (x, 0);
+  while (i < hash_count || I->data_len >= 0) {
+    int c = (i == hash_count) ? 1 : (I->data_len < 0) ? -1 : mystrcmp (p[i]->key, p[i]->key_len, I->data, I->key_len);
+    if (c <= 0) {
+      hash_entry_t *H = p[i++];
+      if (H->data_len == -2) {
+        do_pmemcached_merge (H->key, H->key_len);
+      }
+      if (H->data_len >= 0) {
+        if (H->exp_time >= 0 && H->exp_time < t) {
+          expired++;
+        } else {
+          compact_store (H->key, H->key_len, H->flags, H->exp_time, H->data, H->data_len);
+          written++;
+        }
+      }
+    } else {
+      if (I->delay >= 0 && I->delay < t) {
+        expired++;
+      } else {
+        compact_store (I->data, I->key_len, I->flags, I->delay, I->data + I->key_len, I->data_len);
+        written++;
+      }
+    }
+    if (c >= 0) {
+      I = index_get_num (++x, 0);
+    }
+  }
+  free (p);
+
+  compact_write_crc32 ();
+  compact_flush ();
+  free (compact_buff);
+  compact_buff = compact_wptr = compact_crc32_ptr = 0;
+
+  vkprintf (1, "compact binlog: %lld keys written, %lld expired keys skipped, %lld bytes (log position %lld)\n", written, expired, compact_written, log_cur_pos ());
+  return written;
+}
+
 
 /*
  *
@@ -146,6 +146,7 @@ int do_pmemcached_get_all_next_keys (const char *key, int key_len, int prefix_le
 void free_by_time (int mx);
 int load_index (kfs_file_handle_t Index);
 int save_index (int writing_binlog);
+long long pmemcached_write_compact_binlog (int fd);
 void init_hash_table (void);
 void pmemcached_register_replay_logevent ();
 void wildcard_add_value (const char *key, int key_len, const char *data, int data_len);
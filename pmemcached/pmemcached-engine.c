@@ -1560,6 +1560,7 @@ int f_parse_option (int val) {
     max_memory = 1024 * 1024 * (long long) atoi (optarg);
     break;
   case 'P':
+  case 1000:
     pack_file = optarg;
     break;
   case 'M':
@@ -1602,7 +1603,8 @@ int main (int argc, char *argv[]) {
   parse_option ("index", no_argument, 0, 'i', "starts in index mode");
   parse_option ("disable-cache", no_argument, 0, 'D', "disables cache of elements in engine");
   parse_option ("max-memory", required_argument, 0, 'm', "max memory (in MiB)");
-  parse_option ("pack_file", required_argument, 0, 'P', "packs binlog+index in small binlog");
+  parse_option ("compact-binlog", required_argument, 0, 'P', "writes index+binlog as new binlog <file> containing only the latest values of alive keys and exits");
+  parse_option ("pack_file", required_argument, 0, 1000, "same as --compact-binlog");
   parse_option ("metafile-size", required_argument, 0, 'M', "Size of metafile (in KiB)");
   parse_option ("secure", no_argument, 0, 'S', "Allow unecrypted connections only from localhost");
   parse_option ("restricted", no_argument, 0, 'R', "Allow unecrypted connections only from localhost, disables wildcard, disables memcache (aside from stats query)");
@@ -1618,9 +1620,13 @@ int main (int argc, char *argv[]) {
 
   if (pack_file) {
     pack_fd = open (pack_file, O_TRUNC | O_WRONLY | O_EXCL | O_CREAT, 0600);
+    if (pack_fd < 0) {
+      fprintf (stderr, "cannot create compact binlog %s: %m\n", pack_file);
+      exit (1);
+    }
     pack_mode = 1;
     binlog_disabled = 1;
-    assert (pack_fd >= 0);
+    index_mode = 1;
   }
 
   if (strlen (argv[0]) >= 5 && memcmp ( argv[0] + strlen (argv[0]) - 5, "index" , 5) == 0) {
@@ -1726,46 +1732,6 @@ int main (int argc, char *argv[]) {
     close_snapshot (Snapshot, 1);
   }
 
-  if (pack_mode) {
-    int x = 0;
-    static char buf[2000000];
-    struct lev_start *a = (struct lev_start *)buf;
-    a->type = LEV_START;
-    a->schema_id = PMEMCACHED_SCHEMA_V1;
-    a->split_mod = 1;
-    a->split_min = 0;
-    a->split_max = 1;
-    write (pack_fd, a, sizeof (struct lev_start) - 4);
-    while (1) {
-      struct index_entry *entry = index_get_num (x ++, 0);
-      if (entry->data_len < 0) {
-        break;
-      }
-      struct lev_pmemcached_store *E = (struct lev_pmemcached_store *)buf;
-      E->type = LEV_PMEMCACHED_STORE + 1;
-      E->key_len = entry->key_len;
-      E->data_len = entry->data_len;
-      E->delay = entry->delay;
-      E->flags = entry->flags;
-      memcpy (E->data, entry->data, E->key_len + E->data_len);
-      int t;
-      for (t = 0; t <= 4; t++) {
-        E->data[E->key_len + E->data_len + t] = 0;
-      }
-      int l = 1 + offsetof (struct lev_pmemcached_store, data) + E->key_len + E->data_len;
-      int adj_bytes = -l & 3;
-      l = (l + 3) & -4;
-      if (adj_bytes) {
-        memset (((char *)E) + l - adj_bytes, adj_bytes, adj_bytes);
-      }
-
-      write (pack_fd, E, l);
-    }
-    x--;
-    vkprintf (1, "Written log events for %d index entries\n", x);
-  }
-
-
   //Binlog reading
   Binlog = open_binlog (engine_replica, jump_log_pos);
   if (!Binlog) {
@@ -1826,6 +1792,12 @@ int main (int argc, char *argv[]) {
   clear_write_log ();
   start_time = time (NULL);
 
+  if (pack_mode) {
+    pmemcached_write_compact_binlog (pack_fd);
+    assert (!fsync (pack_fd) && !close (pack_fd));
+    return 0;
+  }
+
   if (!index_mode) {
     tl_parse_function = pmemcached_parse_function;
     tl_aio_timeout = 0.5;
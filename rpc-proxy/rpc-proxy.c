@@ -409,6 +409,18 @@ enum tl_type __conn_get_type (struct rpc_cluster_bucket *B) {
   return tl_type_conn;
 }
 
+double __conn_get_load (struct rpc_cluster_bucket *B) {
+  if (!B->RT) {
+    if (B->T->custom_field != -1) {
+      rpc_target_insert_target_ext (B->T, B->T->custom_field);      
+      B->RT = rpc_target_lookup_target (B->T);
+    } else {
+      return 0;
+    }
+  }
+  return rpc_target_get_load (B->RT, 0);
+}
+
 struct rpc_cluster_bucket_methods __conn_methods = {
   .init_store = __conn_init_store,
   .get_host = __conn_get_host,
@@ -417,7 +429,8 @@ struct rpc_cluster_bucket_methods __conn_methods = {
   .get_conn = __conn_get_conn,
   .get_multi_conn = __conn_get_multi_conn,
   .get_state = __conn_get_state,
-  .get_type = __conn_get_type
+  .get_type = __conn_get_type,
+  .get_load = __conn_get_load
 };
 
 void __udp_init_store (struct rpc_cluster_bucket *B, void *c, long long qid) {
@@ -1522,6 +1535,7 @@ void default_on_alarm (struct rpc_query *q);
 void delete_rpc_query (struct rpc_query *q);
 int query_on_alarm (struct rpc_query *q);
 static void rpc_query_timeout (struct rpc_query *q) {
+  rpc_conn_query_timeout (q->qid);
   int t = query_on_alarm (q);
   if (t > 0) { return; }
 /*  if (q->type.on_alarm) {
@@ -1823,6 +1837,7 @@ int default_unsigned_firstlong_forward (void) {
 }
 
 
+/* power of two choices: of two random replicas the less loaded one gets the query */
 int default_random_forward_ext (void) {
   int n = lrand48 ();
   if (tl_fetch_error ()) {
@@ -1832,6 +1847,12 @@ int default_random_forward_ext (void) {
   assert (CC->tot_buckets);
   assert (n >= 0);
   n %= CC->tot_buckets;
+  if (CC->tot_buckets > 1 && CC->buckets[n].methods->get_load) {
+    int m = (n + 1 + lrand48 () % (CC->tot_buckets - 1)) % CC->tot_buckets;
+    if (CC->buckets[m].methods->get_load && CC->buckets[m].methods->get_load (&CC->buckets[m]) < CC->buckets[n].methods->get_load (&CC->buckets[n])) {
+      n = m;
+    }
+  }
   tl_fetch_mark_restore ();
   return query_forward (CC->buckets[n]);
 }
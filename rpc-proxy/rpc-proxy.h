@@ -113,6 +113,7 @@ struct rpc_cluster_bucket_methods {
   int (*get_multi_conn) (struct rpc_cluster_bucket *self, void **buf, int n);
   int (*get_state)(struct rpc_cluster_bucket *self);
   enum tl_type (*get_type)(struct rpc_cluster_bucket *self);
+  double (*get_load)(struct rpc_cluster_bucket *self);
 };
 
 struct rpc_cluster_bucket {
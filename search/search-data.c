@@ -37,6 +37,8 @@
 #include <unistd.h>
 #include <limits.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
 #include <sys/types.h>
 #include <aio.h>
 
@@ -67,6 +69,8 @@ int items_short_ids;
 int import_only_mode = 0;
 int tot_items, del_items, del_item_instances, mod_items, tot_freed_deleted_items, idx_items_with_hash;
 long long rebuild_hashmap_calls, assign_max_set_rate_calls, change_multiple_rates_set_rate_calls;
+long long block_max_tables, block_max_tables_bytes, block_max_skipped_blocks;
+long long parallel_queries, parallel_query_ranges;
 
 char last_search_query[LAST_SEARCH_QUERY_BUFF_SIZE];
 static hash_t universal_tag_hash;
@@ -146,7 +150,10 @@ static struct search_index_word *IndexWords;
 static struct search_index_hapax_legomena *IndexHapaxLegomena;
 static char *IndexData;
 int idx_items, idx_words, idx_hapax_legomena;
-long idx_bytes, idx_loaded_bytes;
+long idx_bytes;
+long long idx_loaded_bytes;
+/* bytes of encoded (not inlined) doc lists and title subsequence lists */
+long long idx_list_bytes[2];
 
 static long long item_texts_offset, words_offset, hapax_legomena_offset, freq_words_offset, word_index_offset, index_size;
 
@@ -206,6 +213,32 @@ int load_item (struct index_item *C) {
   return sz + 12;
 }
 
+/* lists are written one after another in word order (doc list, then title subsequence list),
+   so the size of an encoded list is the distance to the next encoded list */
+static void compute_idx_list_bytes (void) {
+  long long last = -1;
+  int i, mode, last_mode = 0;
+  idx_list_bytes[0] = idx_list_bytes[1] = 0;
+  for (i = 0; i < idx_words; i++) {
+    for (mode = 0; mode < 2; mode++) {
+      struct search_index_word *W = IndexWords + i;
+      int K = mode ? W->len_subseq : W->len, bytes = mode ? W->bytes_subseq : W->bytes;
+      if (K <= 2 || bytes <= 8) {
+        continue;
+      }
+      long long offs = mode ? W->file_offset_subseq : W->file_offset;
+      if (last >= 0) {
+        idx_list_bytes[last_mode] += offs - last;
+      }
+      last = offs;
+      last_mode = mode;
+    }
+  }
+  if (last >= 0) {
+    idx_list_bytes[last_mode] += IndexWords[idx_words].file_offset - last;
+  }
+}
+
 int load_index (kfs_file_handle_t Index) {
   int fd = Index->fd;
   int index_with_crc32 = -1;
@@ -216,7 +249,7 @@ int load_index (kfs_file_handle_t Index) {
 
   int sz = sizeof (struct search_index_header);
 
-  r = read (fd, &Header, sz);
+  r = kfs_read_file (Index, &Header, sz);
   if (r < 0) {
     kprintf ("error reading index file header: %m\n");
     return -3;
@@ -248,7 +281,7 @@ int load_index (kfs_file_handle_t Index) {
   const int sz_headers = sizeof (Header) + index_with_crc32 * sizeof (CRC32_Header);
   if (index_with_crc32) {
     sz = sizeof (CRC32_Header);
-    if (sz != read (fd, &CRC32_Header, sz)) {
+    if (sz != kfs_read_file (Index, &CRC32_Header, sz)) {
       kprintf ("error reading index (crc32_header). %m\n");
       return -5;
     }
@@ -275,7 +308,7 @@ int load_index (kfs_file_handle_t Index) {
   idx_loaded_bytes = sz_headers;
   /* we never freed this array, so we use zmalloc instead of zzmalloc */
   IndexItems = zmalloc0 (sizeof (struct index_item) * (Header.items + 1));
-  set_read_file (fd);
+  set_read_kfs_file (Index);
   int rbytes = 0;
   for (i = 0; i < Header.items; i++) {
     int t = load_item (IndexItems+i);
@@ -292,37 +325,25 @@ int load_index (kfs_file_handle_t Index) {
   idx_loaded_bytes += rbytes;
   vkprintf (1, "%lld bytes for %d items read from index\n", Header.index_items_size, Header.items);
 
-  assert (lseek (fd, words_offset, SEEK_SET) >= 0);
-
   s = (Header.words + 1) * 1LL * sizeof (struct search_index_word);
-  /* we never freed this array, so we use zmalloc instead of zzmalloc */
-  IndexWords = zmalloc (s);
-
-  r = read (fd, IndexWords, s);
-  if (r > 0) {
-    idx_loaded_bytes += r;
-  }
-  if (r < s) {
-    kprintf ("error reading words from index file: read %ld bytes instead of %ld at position %lld: %m\n", r, s, words_offset);
+  IndexWords = kfs_load_file_section (Index, words_offset, s, &idx_loaded_bytes);
+  if (!IndexWords) {
+    kprintf ("error reading words from index file: %ld bytes at position %lld\n", s, words_offset);
     return -2;
   } else {
-    vkprintf (1, "%ld bytes for %d words read from index\n", r, Header.words);
+    vkprintf (1, "%ld bytes for %d words read from index\n", s, Header.words);
   }
-  assert (!index_with_crc32 || CRC32_Header.crc32_words == compute_crc32 (IndexWords, s));
+  assert (!index_with_crc32 || CRC32_Header.crc32_words == compute_crc32_parallel (IndexWords, s));
 
   s = (Header.hapax_legomena + 1) * 1LL * sizeof (struct search_index_hapax_legomena);
-  IndexHapaxLegomena = zmalloc (s);
-  r = read (fd, IndexHapaxLegomena, s);
-  if (r > 0) {
-    idx_loaded_bytes += r;
-  }
-  if (r < s) {
-    kprintf ("error reading words from index file: read %ld bytes instead of %ld at position %lld: %m\n", r, s, hapax_legomena_offset);
+  IndexHapaxLegomena = kfs_load_file_section (Index, hapax_legomena_offset, s, &idx_loaded_bytes);
+  if (!IndexHapaxLegomena) {
+    kprintf ("error reading words from index file: %ld bytes at position %lld\n", s, hapax_legomena_offset);
     return -2;
   } else {
-    vkprintf (1, "%ld bytes for %d hapax_legomena read from index\n", r, Header.hapax_legomena);
+    vkprintf (1, "%ld bytes for %d hapax_legomena read from index\n", s, Header.hapax_legomena);
   }
-  assert (!index_with_crc32 || CRC32_Header.crc32_hapax_legomena == compute_crc32 (IndexHapaxLegomena, s));
+  assert (!index_with_crc32 || CRC32_Header.crc32_hapax_legomena == compute_crc32_parallel (IndexHapaxLegomena, s));
 
   idx_items = Header.items;
   idx_words = Header.words;
@@ -360,22 +381,19 @@ int load_index (kfs_file_handle_t Index) {
 
   idx_bytes = IndexWords[idx_words].file_offset - word_index_offset;
   //assert (idx_bytes <= MAX_INDEX_BYTES);
+  compute_idx_list_bytes ();
 
   s = idx_bytes;
-  /* we never freed this array, so we use zmalloc instead of zzmalloc */
-  IndexData = zmalloc (s);
   vkprintf (2, "cut golomb data cmd: head -c %lld %s | tail -c %lld >output\n",
           (long long) word_index_offset + s, Index->info->filename,  (long long) s);
-  assert (lseek (fd, word_index_offset, SEEK_SET) >= 0);
-  r = read (fd, IndexData, s);
-  idx_loaded_bytes += r;
-  if (r < s) {
-    kprintf ("error reading data from index file: read %ld bytes instead of %ld at position %lld: %m\n", r, s, word_index_offset);
+  IndexData = kfs_load_file_section (Index, word_index_offset, s, &idx_loaded_bytes);
+  if (!IndexData) {
+    kprintf ("error reading data from index file: %ld bytes at position %lld\n", s, word_index_offset);
     return -2;
   }
-  assert (!index_with_crc32 || CRC32_Header.crc32_data == compute_crc32 (IndexData, s));
+  assert (!index_with_crc32 || CRC32_Header.crc32_data == compute_crc32_parallel (IndexData, s));
 
-  vkprintf (1, "finished loading index: %d items, %d words, %ld index bytes, %ld preloaded bytes\n", idx_items, idx_words, idx_bytes, idx_loaded_bytes);
+  vkprintf (1, "finished loading index: %d items, %d words, %ld index bytes, %lld preloaded bytes, %lld mapped bytes\n", idx_items, idx_words, idx_bytes, idx_loaded_bytes, kfs_mapped_bytes);
 
   log_split_min = Header.log_split_min;
   log_split_max = Header.log_split_max;
@@ -396,6 +414,16 @@ int load_index (kfs_file_handle_t Index) {
   return 0;
 }
 
+/* returns first doc_id with item_id >= given item_id (idx_items if there is no such doc) */
+static int get_idx_doc_id_lowerbound (long long item_id) {
+  int a = -1, b = idx_items, c;
+  while (b - a > 1) {
+    c = ((a + b) >> 1);
+    if (IndexItems[c].item_id < item_id) { a = c; } else { b = c; }
+  }
+  return b;
+}
+
 static struct index_item *get_idx_item (long long item_id) {
   int a = -1, b = idx_items, c;
   while (b - a > 1) {
@@ -708,6 +736,31 @@ static int get_rate_item (item_t *I, int p) {
   return I->rates[get_bitno (I->mask,p)];
 }
 
+/* block rate bounds (see block-max top-k) are computed from index lists,
+   so later rate changes of index items are accumulated per doc_id bucket */
+#define RATE_CHANGES_BUCKET_BITS 12
+static int *idx_rate_changes_min[16], *idx_rate_changes_max[16];
+
+static void index_item_rate_changed (item_t *II, int p) {
+  int i;
+  if (!idx_rate_changes_min[p]) {
+    const int n = (idx_items >> RATE_CHANGES_BUCKET_BITS) + 1;
+    idx_rate_changes_min[p] = zmalloc (n * sizeof (int));
+    idx_rate_changes_max[p] = zmalloc (n * sizeof (int));
+    for (i = 0; i < n; i++) {
+      idx_rate_changes_min[p][i] = INT_MAX;
+      idx_rate_changes_max[p][i] = INT_MIN;
+    }
+  }
+  const int rate = get_rate_item_fast (II, p), b = ((struct index_item *) II - IndexItems) >> RATE_CHANGES_BUCKET_BITS;
+  if (idx_rate_changes_min[p][b] > rate) {
+    idx_rate_changes_min[p][b] = rate;
+  }
+  if (idx_rate_changes_max[p][b] < rate) {
+    idx_rate_changes_max[p][b] = rate;
+  }
+}
+
 static void delete_item_rates (item_t *I) {
   zzfree (I->rates, I->rates_len * 4);
   I->rates = 0;
@@ -904,6 +957,7 @@ static int set_rate_new (long long item_id, int p, int rate) {
 
   if (II) {
     set_rate_item (II, p, rate);
+    index_item_rate_changed (II, p);
     assert (!I);
     return 1;
   }
@@ -960,7 +1014,9 @@ static int incr_rate_new (long long item_id, int p, int rate_incr) {
   item_t *II = (item_t *) get_idx_item (item_id);
   if (II) {
     assert (!I);
-    return incr_rate_item (II, p, rate_incr);
+    incr_rate_item (II, p, rate_incr);
+    index_item_rate_changed (II, p);
+    return 1;
   }
   if (!I || (I->extra & FLAG_DELETED)) {
     return 0;
@@ -1280,8 +1336,11 @@ static char QT[MAX_WORDS];
  *  INDEX LIST DECODER
  *
  */
-struct list_decoder *allocated_list_decoders[2*MAX_WORDS];
-int Q_decoders = 0;
+__thread struct list_decoder *allocated_list_decoders[2*MAX_WORDS];
+__thread int Q_decoders = 0;
+/* zmalloc isn't thread safe, decoders are allocated under mutex while parallel query is running */
+static int list_decoders_lock;
+static pthread_mutex_t list_decoders_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 int get_word_frequency (hash_t word) {
   int a = -1, b = idx_words, c;
@@ -1298,9 +1357,8 @@ int get_word_frequency (hash_t word) {
   return IndexWords[a].len;
 }
 
-static void init_decoder (struct search_list_decoder *D, int N, int K, int bytes, const void *file_offset, int compression_method) {
+static struct list_decoder *zmalloc_index_list_decoder (int N, int K, int bytes, const void *file_offset, int compression_method) {
   unsigned char *ptr;
-  vkprintf (3, "init_decoder (N = %d, K = %d)\n", N, K);
   if (K <= 2) {
     ptr = (unsigned char *) file_offset;
     compression_method = le_raw_int32;
@@ -1324,12 +1382,67 @@ static void init_decoder (struct search_list_decoder *D, int N, int K, int bytes
     assert (offs >= 0 && offs < idx_bytes && offs + bytes <= idx_bytes);
     ptr = (unsigned char *)(IndexData + offs);
   }
+  return zmalloc_list_decoder_ext (N, K, ptr, compression_method, 0, Header.left_subtree_size_threshold);
+}
+
+static void init_decoder (struct search_list_decoder *D, int N, int K, int bytes, const void *file_offset, int compression_method) {
+  vkprintf (3, "init_decoder (N = %d, K = %d)\n", N, K);
   assert (Q_decoders < 2 * MAX_WORDS);
-  D->dec = allocated_list_decoders[Q_decoders++] = zmalloc_list_decoder_ext (N, K, ptr, compression_method, 0, Header.left_subtree_size_threshold);
+  if (list_decoders_lock) {
+    pthread_mutex_lock (&list_decoders_mutex);
+  }
+  D->dec = allocated_list_decoders[Q_decoders++] = zmalloc_index_list_decoder (N, K, bytes, file_offset, compression_method);
+  if (list_decoders_lock) {
+    pthread_mutex_unlock (&list_decoders_mutex);
+  }
   D->remaining = K;
   D->len = K;
 }
 
+static int list_has_skips (struct list_decoder *dec) {
+  return dec->tp == le_interpolative_ext || dec->tp == le_block_packed || dec->tp == le_golomb_skip || dec->tp == le_degenerate;
+}
+
+/* unified lower bound jump over every list coding:
+   returns first not decoded yet doc_id >= doc_id_lowerbound or -1 if list is exhausted,
+   uses skip data stored in list (see list_has_skips), otherwise decodes list sequentially */
+static int search_list_forward_decode_idx (struct search_list_decoder *D, int doc_id_lowerbound) {
+  struct list_decoder *dec = D->dec;
+  int x;
+  switch (dec->tp) {
+  case le_interpolative_ext:
+    x = list_interpolative_ext_forward_decode_idx (dec, doc_id_lowerbound);
+    break;
+  case le_block_packed:
+    x = list_block_packed_forward_decode_idx (dec, doc_id_lowerbound);
+    break;
+  case le_golomb_skip:
+    x = list_golomb_skip_forward_decode_idx (dec, doc_id_lowerbound);
+    break;
+  case le_degenerate:
+    if (dec->k < doc_id_lowerbound) {
+      dec->k = doc_id_lowerbound < dec->K ? doc_id_lowerbound : dec->K;
+    }
+    x = dec->decode_int (dec);
+    break;
+  default:
+    while (D->remaining > 0) {
+      D->remaining--;
+      x = dec->decode_int (dec);
+      if (x >= doc_id_lowerbound) {
+        return x;
+      }
+    }
+    return -1;
+  }
+  if (x == 0x7fffffff) {
+    D->remaining = 0;
+    return -1;
+  }
+  D->remaining = D->len - dec->k;
+  return x;
+}
+
 /* return priority for given doc_id */
 static int adv_ilist_subseq_slow (ilist_decoder_t *D, int idx) {
   struct search_list_decoder *dec_subseq = &D->dec_subseq;
@@ -1345,11 +1458,16 @@ static int adv_ilist_subseq_slow (ilist_decoder_t *D, int idx) {
 }
 
 static int adv_ilist_subseq_fast (ilist_decoder_t *D, int idx) {
-  D->last_subseq = list_interpolative_ext_forward_decode_idx (D->dec_subseq.dec, idx);
+  if (D->last_subseq < idx) {
+    D->last_subseq = search_list_forward_decode_idx (&D->dec_subseq, idx);
+    if (D->last_subseq < 0) {
+      D->last_subseq = 0x7fffffff;
+    }
+  }
   return (D->last_subseq == idx) ? 1 : 0;
 }
 static void init_adv_ilist_subseq (ilist_decoder_t *D) {
-  D->adv_ilist_subseq = (D->dec_subseq.dec->tp == le_interpolative_ext) ? adv_ilist_subseq_fast : adv_ilist_subseq_slow;
+  D->adv_ilist_subseq = list_has_skips (D->dec_subseq.dec) ? adv_ilist_subseq_fast : adv_ilist_subseq_slow;
 }
 
 int init_ilist_decoder (ilist_decoder_t *D, hash_t word) {
@@ -1408,7 +1526,13 @@ int init_ilist_decoder (ilist_decoder_t *D, hash_t word) {
 
 static void free_all_list_decoders (void) {
   int i;
+  if (list_decoders_lock) {
+    pthread_mutex_lock (&list_decoders_mutex);
+  }
   for (i = 0; i < Q_decoders; i++) { zfree_list_decoder (allocated_list_decoders[i]); }
+  if (list_decoders_lock) {
+    pthread_mutex_unlock (&list_decoders_mutex);
+  }
   Q_decoders = 0;
 }
 
@@ -1492,19 +1616,23 @@ int cmp_query_range (const void *a, const void *b) {
 
 #define MAX_OPTIONAL_TAGS 16
 
-int Q_order, Q_limit, Q_words, Q_extmode, Q_nodes, Q_hash_group_mode, Q_hash_rating, Q_type, order, Q_min_priority, Q_relevance;
+int Q_order, Q_limit, Q_extmode, Q_nodes, Q_hash_group_mode, Q_hash_rating, Q_type, order, Q_relevance;
+__thread int Q_words, Q_min_priority;
 double Q_K_Opt_Tag, Q_Relevance_Power;
 int Q_optional_tags;
 static hash_t QW[MAX_WORDS];
 static int QOTW[MAX_WORDS]; /* optional tag weight */
-static query_node_t QV[MAX_QUERY_NODES+1], *Q_root;
-
-int R_cnt, R_tot, R_tot_undef_hash, R_tot_groups;
-item_t *R[MAX_RES+1];
-int RV[MAX_RES+1];
+static query_node_t QV[MAX_QUERY_NODES+1];
+static __thread query_node_t *Q_root;
+
+/* iterators and result heap are per thread, see parallel query execution */
+__thread int R_cnt, R_tot;
+int R_tot_undef_hash, R_tot_groups;
+__thread item_t *R[MAX_RES+1];
+__thread int RV[MAX_RES+1];
 int RS[MAX_RES+1]; /* value or index in hash table in group by hash mode */
 
-iheap_en_t IHE[MAX_WORDS];
+__thread iheap_en_t IHE[MAX_WORDS];
 iheap_en_t IHT[MAX_OPTIONAL_TAGS];
 static double optional_tags_mult_coeff;
 
@@ -2004,6 +2132,43 @@ static void hashset_init (int n) {
   }
 }
 
+/* keeps Q_limit items with least r in max-heap R[1..R_cnt] */
+static void res_heap_insert (item_t *I, int r) {
+  int i, j;
+  if (R_cnt == Q_limit) {
+    if (RV[1] <= r) {
+      return;
+    }
+    i = 1;
+    while (1) {
+      j = i*2;
+      if (j > R_cnt) { break; }
+      if (j < R_cnt) {
+        if (RV[j+1] > RV[j]) {
+          j++;
+        }
+      }
+      if (RV[j] <= r) { break; }
+      R[i] = R[j];
+      RV[i] = RV[j];
+      i = j;
+    }
+    R[i] = I;
+    RV[i] = r;
+  } else {
+    i = ++R_cnt;
+    while (i > 1) {
+      j = (i >> 1);
+      if (RV[j] >= r) { break; }
+      R[i] = R[j];
+      RV[i] = RV[j];
+      i = j;
+    }
+    R[i] = I;
+    RV[i] = r;
+  }
+}
+
 /*
   returns 1 in case continue search
   returns 0 in case stop search (for example too many items found case)
@@ -2011,7 +2176,7 @@ static void hashset_init (int n) {
 
 static int store_res (item_t *I, int priority) {
   vkprintf (3, "store_res!!, n_ranges = %d\n", n_ranges);
-  int i, j = 0, r;
+  int i, r;
   for (i = 0; i < n_ranges; i++) {
     int r0 = get_rate_item (I, Q_range[i].idx);
     vkprintf (3, "ranges: r0 = %d, Q_range[i].minr = %d, Q_range[i].maxr = %d\n", r0, Q_range[i].minr, Q_range[i].maxr);
@@ -2070,38 +2235,7 @@ static int store_res (item_t *I, int priority) {
 
   assert (order != 0);
 
-  if (R_cnt == Q_limit) {
-    if (RV[1] <= r) {
-      return 1;
-    }
-    i = 1;
-    while (1) {
-      j = i*2;
-      if (j > R_cnt) { break; }
-      if (j < R_cnt) {
-        if (RV[j+1] > RV[j]) {
-          j++;
-        }
-      }
-      if (RV[j] <= r) { break; }
-      R[i] = R[j];
-      RV[i] = RV[j];
-      i = j;
-    }
-    R[i] = I;
-    RV[i] = r;
-  } else {
-    i = ++R_cnt;
-    while (i > 1) {
-      j = (i >> 1);
-      if (RV[j] >= r) { break; }
-      R[i] = R[j];
-      RV[i] = RV[j];
-      i = j;
-    }
-    R[i] = I;
-    RV[i] = r;
-  }
+  res_heap_insert (I, r);
   return 1;
 }
 
@@ -3135,20 +3269,16 @@ static int list_interpolative_ext_forward_decode_item (struct list_decoder *dec,
   return -1;
 }
 
-static void ihe_skip_advance1_fast (iheap_en_t *A, long long item_id) {
-  if (A->cur1->item_id >= item_id) {
-    return;
-  }
+/* finishes index list skip: D->doc_id is the first decoded doc_id (-1 at the end of list), skips deleted items */
+static void ihe_load1_after_skip (iheap_en_t *A) {
   struct search_list_decoder *dec = &A->Decoder.dec;
   ilist_decoder_t *D = &A->Decoder;
-  D->doc_id = list_interpolative_ext_forward_decode_item (dec->dec, item_id);
   if (D->doc_id < 0) {
     dec->remaining = 0;
     A->cur1 = 0;
     //A->cur_y1 = 0;
     return;
   }
-  dec->remaining = dec->len - dec->dec->k;
   for (;;) {
     struct index_item *II = IndexItems + D->doc_id;
     if (!(II->extra & FLAG_DELETED)) {
@@ -3168,6 +3298,161 @@ static void ihe_skip_advance1_fast (iheap_en_t *A, long long item_id) {
   }
 }
 
+static void ihe_skip_advance1_fast (iheap_en_t *A, long long item_id) {
+  if (A->cur1->item_id >= item_id) {
+    return;
+  }
+  struct search_list_decoder *dec = &A->Decoder.dec;
+  ilist_decoder_t *D = &A->Decoder;
+  if (dec->dec->tp == le_interpolative_ext) {
+    D->doc_id = list_interpolative_ext_forward_decode_item (dec->dec, item_id);
+    if (D->doc_id >= 0) {
+      dec->remaining = dec->len - dec->dec->k;
+    }
+  } else {
+    D->doc_id = search_list_forward_decode_idx (dec, get_idx_doc_id_lowerbound (item_id));
+  }
+  ihe_load1_after_skip (A);
+}
+
+/******************** block-max top-k ********************/
+/* For "best N by rating" queries (search#r<limit>W(...), evaluate_rating == get_rating)
+   index lists are split into blocks of LIST_BLOCK_SIZE entries (codec blocks/skip table steps),
+   for every block its last doc_id and bounds of the sorting rate are kept in memory.
+   Tables are built once per (word, rate) on the first such query, rate changes after index load are
+   accounted by idx_rate_changes_min/max, so bounds are never underestimated.
+   When the result heap is full, blocks that can't improve it are skipped without decoding,
+   the number of found items is only a lower bound in this mode. */
+
+#define BLOCK_MAX_MIN_LIST_LEN (4 * LIST_BLOCK_SIZE)
+#define BLOCK_MAX_HASH_SIZE 4096
+#define MAX_BLOCK_MAX_TABLES_BYTES (64 << 20)
+
+struct word_block_rates {
+  struct word_block_rates *hnext;
+  int word_no;
+  int p;
+  int blocks;
+  int data[0]; /* last doc_id, min rate, max rate for every block */
+};
+
+static struct word_block_rates *BlockRates[BLOCK_MAX_HASH_SIZE];
+int Q_topk;
+static __thread int Q_block_max;
+
+static void free_block_max_tables (void) {
+  int i;
+  for (i = 0; i < BLOCK_MAX_HASH_SIZE; i++) {
+    struct word_block_rates *T, *W;
+    for (T = BlockRates[i]; T; T = W) {
+      W = T->hnext;
+      zfree (T, sizeof (struct word_block_rates) + 12 * T->blocks);
+    }
+    BlockRates[i] = 0;
+  }
+  block_max_tables = block_max_tables_bytes = 0;
+}
+
+static struct word_block_rates *get_word_block_rates (struct search_index_word *W, int p) {
+  if (W->len < BLOCK_MAX_MIN_LIST_LEN) {
+    return 0;
+  }
+  const int word_no = W - IndexWords, h = (word_no * 16 + p) & (BLOCK_MAX_HASH_SIZE - 1);
+  struct word_block_rates *T;
+  for (T = BlockRates[h]; T; T = T->hnext) {
+    if (T->word_no == word_no && T->p == p) {
+      return T;
+    }
+  }
+  const int blocks = (W->len + LIST_BLOCK_SIZE - 1) / LIST_BLOCK_SIZE, sz = sizeof (struct word_block_rates) + 12 * blocks;
+  if (block_max_tables_bytes + sz > MAX_BLOCK_MAX_TABLES_BYTES) {
+    free_block_max_tables ();
+  }
+  T = zmalloc (sz);
+  T->word_no = word_no;
+  T->p = p;
+  T->blocks = blocks;
+  struct list_decoder *dec = zmalloc_index_list_decoder (idx_items, W->len, W->bytes, &W->file_offset, Header.word_list_compression_methods[0]);
+  int i;
+  for (i = 0; i < W->len; i++) {
+    const int doc_id = dec->decode_int (dec);
+    assert (doc_id >= 0 && doc_id < idx_items);
+    const int rate = get_rate_item_fast ((item_t *) (IndexItems + doc_id), p);
+    int *B = T->data + 3 * (i / LIST_BLOCK_SIZE);
+    if (!(i % LIST_BLOCK_SIZE)) {
+      B[1] = B[2] = rate;
+    } else if (B[1] > rate) {
+      B[1] = rate;
+    } else if (B[2] < rate) {
+      B[2] = rate;
+    }
+    B[0] = doc_id;
+  }
+  zfree_list_decoder (dec);
+  T->hnext = BlockRates[h];
+  BlockRates[h] = T;
+  block_max_tables++;
+  block_max_tables_bytes += sz;
+  return T;
+}
+
+static void ihe_load_block_rates (iheap_en_t *A, int b) {
+  const int *B = A->block_rates->data + 3 * b, p = A->block_rates->p;
+  A->block_no = b;
+  A->block_min_rate = B[1];
+  A->block_max_rate = B[2];
+  if (idx_rate_changes_min[p]) {
+    int i = b ? (B[-3] + 1) >> RATE_CHANGES_BUCKET_BITS : 0;
+    for (; i <= (B[0] >> RATE_CHANGES_BUCKET_BITS); i++) {
+      if (A->block_min_rate > idx_rate_changes_min[p][i]) {
+        A->block_min_rate = idx_rate_changes_min[p][i];
+      }
+      if (A->block_max_rate < idx_rate_changes_max[p][i]) {
+        A->block_max_rate = idx_rate_changes_max[p][i];
+      }
+    }
+  }
+}
+
+/* returns doc_id following current index block of A if no item of this block can enter full result heap,
+   otherwise returns -1 */
+static int ihe_block_max_skip_target (iheap_en_t *A) {
+  if (!A->block_rates || A->cur != A->cur1 || R_cnt < Q_limit) {
+    return -1;
+  }
+  const int b = (A->Decoder.dec.len - 1 - A->Decoder.dec.remaining) / LIST_BLOCK_SIZE;
+  if (A->block_no != b) {
+    ihe_load_block_rates (A, b);
+  }
+  /* same comparison as in store_res: item enters heap only if its r < RV[1] */
+  if (order == 2 ? -1LL - A->block_max_rate < RV[1] : A->block_min_rate < RV[1]) {
+    return -1;
+  }
+  return A->block_rates->data[3 * b] + 1;
+}
+
+/* skips index list of A (but not tree items) to the first doc_id >= doc_id_lowerbound */
+static int ihe_block_max_skip (iheap_en_t *A, int doc_id_lowerbound) {
+  block_max_skipped_blocks++;
+  A->Decoder.doc_id = search_list_forward_decode_idx (&A->Decoder.dec, doc_id_lowerbound);
+  ihe_load1_after_skip (A);
+  return ihe_load (A);
+}
+
+static void block_max_init (void) {
+  int i;
+  Q_block_max = Q_topk && Q_limit > 0 && evaluate_rating == get_rating && !Q_hash_group_mode;
+  if (!Q_block_max) {
+    return;
+  }
+  for (i = 0; i < Q_words; i++) {
+    IHE[i].block_no = -1;
+    if (IHE[i].Decoder.sword && IHE[i].cur1) {
+      IHE[i].block_rates = get_word_block_rates (IHE[i].Decoder.sword, Q_type);
+    }
+  }
+}
+
 inline static int ihe_skip_advance (iheap_en_t *A, long long item_id) {
   if (A->cur0) {
     ihe_skip_advance0 (A, item_id);
@@ -3224,7 +3509,7 @@ static int ihe_init (iheap_en_t *A, hash_t word, int tag, int optional_tag_weigh
 
   A->ihe_skip_advance1 = &ihe_skip_advance1_slow;
   if (init_ilist_decoder (&A->Decoder, word)) {
-    if (A->Decoder.dec.dec->tp == le_interpolative_ext) {
+    if (list_has_skips (A->Decoder.dec.dec)) {
       A->ihe_skip_advance1 = &ihe_skip_advance1_fast;
     }
     if (adv_ilist (&A->Decoder) >= 0) {
@@ -3306,7 +3591,9 @@ static void iheap_pop (void) {
 }
 
 static int t_depth = -1;
-static int reoptimize_flag;
+static __thread int reoptimize_flag;
+/* item_id range scanned by current thread: [Q_item_id_from, Q_item_id_to) */
+static __thread long long Q_item_id_from = MIN_ITEM_ID + 1, Q_item_id_to = MAX_ITEM_ID;
 
 struct query_nodes_list query_nodes_list_buffer[MAX_QUERY_NODES];
 query_node_t query_nodes_kill_dup_buffer[MAX_QUERY_NODES];
@@ -3594,30 +3881,15 @@ static void dump_query_tree (query_node_t *X) {
 }
 
 
-int perform_ext_query (void) {
+static void ext_query_iterate (void) {
   long long item_id;
 
-  if (verbosity > 1) {
-    fprintf (stderr, "performing extended query: root=%p\n", Q_root);
-    dump_query_tree (Q_root);
-    fprintf (stderr, "\n");
-  }
-
-  assert (Q_root && !Q_words);
-  query_optimize_kill_dups ();
-
-  if (verbosity > 1) {
-    fprintf (stderr, "after killing duplicate words: root=%p\n", Q_root);
-    dump_query_tree (Q_root);
-    fprintf (stderr, "\n");
-  }
-
   reoptimize_flag = 0;
   if (prepare_query_iterators (Q_root) < 0) {
-    return 0;
+    return;
   }
 
-  item_id = MIN_ITEM_ID;
+  item_id = Q_item_id_from - 1;
 
   do {
     if (reoptimize_flag) {
@@ -3635,10 +3907,33 @@ int perform_ext_query (void) {
     }
 
     item_id = advance_iterators (Q_root, item_id + 1);
-    if (item_id == MAX_ITEM_ID) {
+    if (item_id >= Q_item_id_to) {
       break;
     }
   } while (store_res (Q_root->cur, Q_root->priority > 10 ? 10 : Q_root->priority));
+}
+
+static int perform_parallel_query (void);
+
+int perform_ext_query (void) {
+  if (verbosity > 1) {
+    fprintf (stderr, "performing extended query: root=%p\n", Q_root);
+    dump_query_tree (Q_root);
+    fprintf (stderr, "\n");
+  }
+
+  assert (Q_root && !Q_words);
+  query_optimize_kill_dups ();
+
+  if (verbosity > 1) {
+    fprintf (stderr, "after killing duplicate words: root=%p\n", Q_root);
+    dump_query_tree (Q_root);
+    fprintf (stderr, "\n");
+  }
+
+  if (!perform_parallel_query ()) {
+    ext_query_iterate ();
+  }
 
   postprocess_res();
 
@@ -3667,7 +3962,7 @@ static int cmp_iheap_entries (const void *a, const void *b) {
 }
 
 static void intersect_lists (void) {
-  int i, j;
+  int i, j, t = -1;
   qsort (IHE, Q_words, sizeof (IHE[0]), cmp_iheap_entries);
   /* firstly goes shorter lists,
      if intersection of first K list is empty,
@@ -3677,7 +3972,11 @@ static void intersect_lists (void) {
   if (Q_min_priority) {
     while (1) {
       item_t *I = IHE[0].cur;
-      if (!I) { break; }
+      if (!I || I->item_id >= Q_item_id_to) { break; }
+      if (Q_block_max && (t = ihe_block_max_skip_target (IHE)) >= 0) {
+        ihe_block_max_skip (IHE, t);
+        continue;
+      }
       if (!(IHE[0].cur_y & 1)) {
         if (!ihe_advance (IHE)) { return; }
         continue;
@@ -3700,11 +3999,16 @@ static void intersect_lists (void) {
   } else {
     while (1) {
       item_t *I = IHE[0].cur;
-      if (!I) { break; }
+      if (!I || I->item_id >= Q_item_id_to) { break; }
+      if (Q_block_max && (t = ihe_block_max_skip_target (IHE)) >= 0) {
+        ihe_block_max_skip (IHE, t);
+        continue;
+      }
       j = IHE[0].cur_y & 1;
       for (i = 1; i < Q_words; i++) {
         if (!ihe_skip_advance (&IHE[i], I->item_id)) { return; }
         if (IHE[i].cur != I) break;
+        if (Q_block_max && (t = ihe_block_max_skip_target (&IHE[i])) >= 0) break;
         j += IHE[i].cur_y & 1;
       }
       if (i == Q_words) {
@@ -3714,6 +4018,9 @@ static void intersect_lists (void) {
         }
         if (!store_res (I, j)) { return; }
         if (!ihe_advance (IHE)) { return; }
+      } else if (IHE[i].cur == I) {
+        /* I lies in the block of i-th list which can't enter the result */
+        ihe_block_max_skip (IHE, t);
       } else {
         if (!ihe_skip_advance (&IHE[0], IHE[i].cur->item_id)) { return; }
       }
@@ -3823,6 +4130,13 @@ static void fast_intersection_query (void) {
       return;
     }
   }
+  if (Q_item_id_from > MIN_ITEM_ID + 1) {
+    for (i = 0; i < Q_words; i++) {
+      if (!ihe_skip_advance (IHE+i, Q_item_id_from)) {
+        return;
+      }
+    }
+  }
   if (Q_min_priority) {
     Q_min_priority = Q_words;
     if (Q_min_priority > MAX_PRIORITY) {
@@ -3830,17 +4144,28 @@ static void fast_intersection_query (void) {
     }
   }
 
+  block_max_init ();
+
   if (Q_words == 1) {
     iheap_en_t *H = IHE;
+    int t;
     if (Q_min_priority) {
-      while (H->cur) {
+      while (H->cur && H->item_id < Q_item_id_to) {
+        if (Q_block_max && (t = ihe_block_max_skip_target (H)) >= 0) {
+          ihe_block_max_skip (H, t);
+          continue;
+        }
         if (H->cur_y & 1) {
           if (!store_res (H->cur, 1)) { break; }
         }
         ihe_advance (H);
       }
     } else {
-      while (H->cur) {
+      while (H->cur && H->item_id < Q_item_id_to) {
+        if (Q_block_max && (t = ihe_block_max_skip_target (H)) >= 0) {
+          ihe_block_max_skip (H, t);
+          continue;
+        }
         if (!store_res (H->cur, H->cur_y & 1)) { break; }
         ihe_advance (H);
       }
@@ -3850,6 +4175,217 @@ static void fast_intersection_query (void) {
   }
 }
 
+/******************** parallel query execution ********************/
+/* Heavy queries are evaluated by several threads: item_id space is split into ranges
+   with equal number of index items, every range is scanned by the usual iterators
+   into thread local result heap, then heaps are merged into the heap of the calling thread.
+   Calling (event loop) thread scans the first range itself and waits for the others,
+   so tree, items and index can't be modified while worker threads read them.
+   Cheap queries (less than parallel_query_min_postings postings for every range),
+   sorting by id or with stateful rating (random, relevance, optional tags),
+   grouping by hash and top-k mode are always evaluated by the calling thread. */
+
+#define MAX_SEARCH_THREADS 64
+
+int search_threads;
+int parallel_query_min_postings = 1 << 16;
+
+struct query_range_job {
+  long long item_id_from, item_id_to;
+  int words, min_priority;
+  query_node_t *root;
+  int nodes;
+  query_node_t node[2 * MAX_QUERY_NODES + 1];
+  /* results are left in thread local heap of the worker thread */
+  item_t **R;
+  int *RV;
+  int R_cnt, R_tot;
+  int queued;
+};
+
+static struct query_range_job RangeJob[MAX_SEARCH_THREADS];
+static pthread_t SearchThread[MAX_SEARCH_THREADS];
+static pthread_mutex_t search_threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t search_threads_cond = PTHREAD_COND_INITIALIZER, search_threads_done_cond = PTHREAD_COND_INITIALIZER;
+static int search_threads_started, range_jobs_pending;
+
+static query_node_t *copy_query_tree (struct query_range_job *J, query_node_t *X) {
+  if (!X) {
+    return 0;
+  }
+  assert (J->nodes < 2 * MAX_QUERY_NODES + 1);
+  query_node_t *Y = &J->node[J->nodes++];
+  *Y = *X;
+  Y->iter = 0;
+  Y->cur = 0;
+  Y->left = copy_query_tree (J, X->left);
+  Y->right = copy_query_tree (J, X->right);
+  return Y;
+}
+
+static void perform_query_range (struct query_range_job *J) {
+  Q_item_id_from = J->item_id_from;
+  Q_item_id_to = J->item_id_to;
+  Q_words = J->words;
+  Q_min_priority = J->min_priority;
+  R_cnt = R_tot = 0;
+  if (J->root) {
+    Q_root = J->root;
+    ext_query_iterate ();
+  } else {
+    fast_intersection_query ();
+  }
+  free_all_list_decoders ();
+  J->R = R;
+  J->RV = RV;
+  J->R_cnt = R_cnt;
+  J->R_tot = R_tot;
+}
+
+static void *search_thread (void *arg) {
+  struct query_range_job *J = arg;
+  sigset_t signals;
+  sigfillset (&signals);
+  pthread_sigmask (SIG_BLOCK, &signals, 0);
+  while (1) {
+    pthread_mutex_lock (&search_threads_mutex);
+    while (!J->queued) {
+      pthread_cond_wait (&search_threads_cond, &search_threads_mutex);
+    }
+    pthread_mutex_unlock (&search_threads_mutex);
+
+    perform_query_range (J);
+
+    pthread_mutex_lock (&search_threads_mutex);
+    J->queued = 0;
+    if (!--range_jobs_pending) {
+      pthread_cond_signal (&search_threads_done_cond);
+    }
+    pthread_mutex_unlock (&search_threads_mutex);
+  }
+  return 0;
+}
+
+/* estimated number of index list entries to be decoded */
+static long long query_cost (query_node_t *X) {
+  long long a, b;
+  if (!X) {
+    return 0;
+  }
+  switch (X->op) {
+    case qn_word:
+      return get_word_frequency (X->word);
+    case qn_true:
+      return idx_items;
+    case qn_and:
+      a = query_cost (X->left);
+      b = query_cost (X->right);
+      return a < b ? a : b;
+    case qn_or:
+      return query_cost (X->left) + query_cost (X->right);
+    case qn_minus:
+      return query_cost (X->left);
+    default:
+      return 0;
+  }
+}
+
+/* returns number of ranges for parallel execution, query is evaluated by the calling thread if it is less than 2 */
+static int parallel_query_admit (void) {
+  int i;
+  if (search_threads < 2 || idx_items < search_threads || Q_topk || Q_hash_group_mode) {
+    return 0;
+  }
+  if (Q_limit > 0) {
+    if (Q_type == MAX_RATES && !(Q_order & (FLAG_ENTRY_SORT_SEARCH | FLAG_PRIORITY_SORT_SEARCH))) {
+      return 0;
+    }
+    if (evaluate_rating == random_rating || (evaluate_rating == evaluate_relevance_search_rating && (Q_optional_tags || Q_relevance))) {
+      return 0;
+    }
+  }
+  long long cost = idx_items;
+  if (Q_root) {
+    cost = query_cost (Q_root);
+  } else {
+    for (i = 0; i < Q_words; i++) {
+      int f = get_word_frequency (QW[i]);
+      if (cost > f) {
+        cost = f;
+      }
+    }
+  }
+  cost /= parallel_query_min_postings;
+  return cost < search_threads ? cost : search_threads;
+}
+
+static int perform_parallel_query (void) {
+  int i, j, k = parallel_query_admit ();
+  if (k < 2) {
+    return 0;
+  }
+  while (search_threads_started < k - 1) {
+    if (pthread_create (&SearchThread[search_threads_started], 0, search_thread, &RangeJob[search_threads_started + 1])) {
+      vkprintf (1, "perform_parallel_query: pthread_create failed. %m\n");
+      break;
+    }
+    search_threads_started++;
+  }
+  if (k > search_threads_started + 1) {
+    k = search_threads_started + 1;
+    if (k < 2) {
+      return 0;
+    }
+  }
+  parallel_queries++;
+  parallel_query_ranges += k;
+
+  for (i = 1; i < k; i++) {
+    struct query_range_job *J = &RangeJob[i];
+    J->item_id_from = IndexItems[(long long) idx_items * i / k].item_id;
+    J->item_id_to = (i < k - 1) ? IndexItems[(long long) idx_items * (i + 1) / k].item_id : MAX_ITEM_ID;
+    J->words = Q_words;
+    J->min_priority = Q_min_priority;
+    J->nodes = 0;
+    J->root = copy_query_tree (J, Q_root);
+  }
+
+  list_decoders_lock = 1;
+  pthread_mutex_lock (&search_threads_mutex);
+  range_jobs_pending = k - 1;
+  for (i = 1; i < k; i++) {
+    RangeJob[i].queued = 1;
+  }
+  pthread_cond_broadcast (&search_threads_cond);
+  pthread_mutex_unlock (&search_threads_mutex);
+
+  Q_item_id_to = RangeJob[1].item_id_from;
+  if (Q_root) {
+    ext_query_iterate ();
+  } else {
+    fast_intersection_query ();
+  }
+  Q_item_id_to = MAX_ITEM_ID;
+
+  pthread_mutex_lock (&search_threads_mutex);
+  while (range_jobs_pending) {
+    pthread_cond_wait (&search_threads_done_cond, &search_threads_mutex);
+  }
+  pthread_mutex_unlock (&search_threads_mutex);
+  list_decoders_lock = 0;
+
+  for (i = 1; i < k; i++) {
+    struct query_range_job *J = &RangeJob[i];
+    R_tot += J->R_tot;
+    if (Q_limit > 0) {
+      for (j = 1; j <= J->R_cnt; j++) {
+        res_heap_insert (J->R[j], J->RV[j]);
+      }
+    }
+  }
+  return 1;
+}
+
 int perform_query (void) {
   int i;
   clear_res ();
@@ -3873,7 +4409,7 @@ int perform_query (void) {
   vkprintf (3, "Q_order = %x\n", Q_order);
   if (Q_order & FLAG_PRIORITY_SORT_SEARCH) {
     priority_sort_query ();
-  } else {
+  } else if (!perform_parallel_query ()) {
     fast_intersection_query ();
   }
 
@@ -61,7 +61,9 @@ extern long long jump_log_pos;
 extern int jump_log_ts;
 extern unsigned jump_log_crc32;
 extern int idx_items, idx_words, idx_hapax_legomena;
-extern long idx_bytes, idx_loaded_bytes;
+extern long idx_bytes;
+extern long long idx_loaded_bytes;
+extern long long idx_list_bytes[2];
 extern int import_only_mode;
 
 int load_index (kfs_file_handle_t Index);
@@ -73,6 +75,10 @@ extern int MAX_MISMATCHED_WORDS;
 extern int alloc_tree_nodes, free_tree_nodes;
 extern int tot_items, del_items, mod_items, tot_freed_deleted_items, idx_items_with_hash;
 extern long long rebuild_hashmap_calls, assign_max_set_rate_calls, change_multiple_rates_set_rate_calls;
+extern long long block_max_tables, block_max_tables_bytes, block_max_skipped_blocks;
+extern long long parallel_queries, parallel_query_ranges;
+/* parallel query execution: number of threads (including event loop thread) and min postings per range */
+extern int search_threads, parallel_query_min_postings;
 
 typedef struct tree tree_t;
 
@@ -131,6 +137,8 @@ typedef struct intersect_heap_entry {
   int tag_word;
   int optional_tag_weight;
   ilist_decoder_t Decoder;
+  struct word_block_rates *block_rates; /* block-max top-k: rate bounds of index list blocks */
+  int block_no, block_min_rate, block_max_rate;
 } iheap_en_t;
 
 #define	SHORT_ID(__x)	((int) ((__x) >> 32))
@@ -139,9 +147,12 @@ typedef struct intersect_heap_entry {
 #define FLAG_DELETED 1
 #define	ITEM_DELETED(__x)	((__x)->extra & FLAG_DELETED)
 
-extern int Q_order, Q_limit, Q_extmode, Q_words, Q_hash_group_mode, Q_min_priority, R_cnt, R_tot, R_tot_undef_hash;
-extern item_t *R[MAX_RES+1];
-extern int RV[MAX_RES+1];
+extern int Q_order, Q_limit, Q_extmode, Q_hash_group_mode, R_tot_undef_hash;
+extern __thread int Q_words, Q_min_priority, R_cnt, R_tot;
+/* top-k mode: skip index blocks which can't enter result (R_tot becomes a lower bound) */
+extern int Q_topk;
+extern __thread item_t *R[MAX_RES+1];
+extern __thread int RV[MAX_RES+1];
 extern int R_HASH_NEXT[MAX_RES];
 char *parse_query (char *text, int do_parse_ranges);
 char *parse_relevance_search_query (char *text, int *Q_raw, int *error, int do_parse_ranges);
@@ -263,6 +263,7 @@ int do_search_query (struct connection *c, const char *key, int len, int dog_len
   Q_extmode = 0;
   Q_hash_group_mode = 0;
   Q_min_priority = 0;
+  Q_topk = 0;
   q_end = 0;
 
   if (*ptr == '#') {
@@ -302,6 +303,10 @@ int do_search_query (struct connection *c, const char *key, int len, int dog_len
         Q_extmode = 1;
         ptr++;
         break;
+      case 'W':
+        Q_topk = 1;
+        ptr++;
+        break;
       case '?':
       	Q_order = 17;
       	ptr++;
@@ -1100,11 +1105,19 @@ int search_prepare_stats (struct connection *c) {
     idx_items_with_hash, idx_bytes);
 
   int k;
+  const int header_methods = sizeof (Header.compression_bytes) / sizeof (Header.compression_bytes[0]) / 2;
   long long golomb_cb = Header.compression_bytes[0] + Header.compression_bytes[1];
-  for (k = 0; k < 4; k++) {
-    long long t1 = Header.compression_bytes[2*k+0],
-              t2 = Header.compression_bytes[2*k+1],
-              t = t1 + t2;
+  for (k = 0; k <= le_golomb_skip; k++) {
+    long long t1, t2, t;
+    if (k < header_methods) {
+      t1 = Header.compression_bytes[2*k+0];
+      t2 = Header.compression_bytes[2*k+1];
+    } else {
+      /* index header has no room for newer methods, report sizes of lists stored in the index */
+      t1 = Header.word_list_compression_methods[0] == k ? idx_list_bytes[0] : 0;
+      t2 = Header.word_list_compression_methods[1] == k ? idx_list_bytes[1] : 0;
+    }
+    t = t1 + t2;
     if (t > 0) {
       if (golomb_cb > 0) {
         sb_printf (&sb, "%s\t%lld(%.6lf%%)=%lld(%.6lf%%)+%lld(%.6lf%%)\n",
@@ -1161,6 +1174,11 @@ int search_prepare_stats (struct connection *c) {
   SB_PRINT_I64(delete_hash_query_items);
   SB_PRINT_I64(assign_max_set_rate_calls);
   SB_PRINT_I64(change_multiple_rates_set_rate_calls);
+  SB_PRINT_I64(block_max_tables);
+  SB_PRINT_I64(block_max_tables_bytes);
+  SB_PRINT_I64(block_max_skipped_blocks);
+  SB_PRINT_I64(parallel_queries);
+  SB_PRINT_I64(parallel_query_ranges);
   SB_PRINT_TIME(worst_delete_items_with_hash_time);
   SB_PRINT_TIME(worst_hashlist_assign_max_time);
   SB_PRINT_TIME(worst_change_many_rates_time);
@@ -1170,6 +1188,7 @@ int search_prepare_stats (struct connection *c) {
   SB_PRINT_I32(hashtags_enabled);
   SB_PRINT_I32(wordfreqs_enabled);
   SB_PRINT_I32(import_only_mode);
+  SB_PRINT_I32(search_threads);
   SB_PRINT_I32(stemmer_version);
   SB_PRINT_I32(word_split_version);
   SB_PRINT_I32(word_split_utf8);
@@ -1457,6 +1476,7 @@ TL_DO_FUN(search)
   Q_extmode = 0;
   Q_hash_group_mode = 0;
   Q_min_priority = 0;
+  Q_topk = 0;
 
   Q_min_priority = 0;
   Q_relevance = 0;
@@ -2016,6 +2036,18 @@ int f_parse_option (int val) {
   case 't':
     hashtags_enabled = 1;
     break;
+  case 1000:
+    search_threads = atoi (optarg);
+    if (search_threads > 64) {
+      search_threads = 64;
+    }
+    break;
+  case 1001:
+    x = atoi (optarg);
+    if (x >= 1) {
+      parallel_query_min_postings = x;
+    }
+    break;
   default:
     return -1;
   }
@@ -2044,6 +2076,8 @@ int main (int argc, char *argv[]) {
   parse_option ("utf8", no_argument, 0, 'U', "enable utf8 word split");
   parse_option ("wordfreq", no_argument, 0, 'W', "store word frequiences in item");
   parse_option ("hashtags", no_argument, 0, 't', "enable hashtags");
+  parse_option ("search-threads", required_argument, 0, 1000, "evaluate heavy queries by <n> threads splitting item_id space into ranges (default %d)", search_threads);
+  parse_option ("parallel-query-min-postings", required_argument, 0, 1001, "min estimated number of index postings per range for parallel query (default %d)", parallel_query_min_postings);
 
   
   parse_engine_options_long (argc, argv, f_parse_option);
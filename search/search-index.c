@@ -130,6 +130,9 @@ int open_file (int x, char *fname, int creat) {
 #endif
 
 #define FLAG_DELETED 1
+/* item text (or rate 13) was changed after index load, item is re-tokenized in index merge mode (-M),
+   never written into index */
+#define FLAG_REINDEX 2
 
 int log_split_min, log_split_max, log_split_mod;
 
@@ -293,6 +296,9 @@ static int set_rate_item (struct item *I, int n, int rate) {
     I->rates_len++;
   }
   I->rates [get_bitno (I->mask, n)] = rate;
+  if (n == 13) {
+    I->extra |= FLAG_REINDEX;
+  }
   return 1;
 }
 
@@ -306,6 +312,9 @@ static int incr_rate_item (struct item *I, int n, int rate) {
     I->rates_len++;
   }
   I->rates [get_bitno (I->mask, n)] += rate;
+  if (n == 13) {
+    I->extra |= FLAG_REINDEX;
+  }
   return 1;
 }
 
@@ -360,6 +369,7 @@ static int add_item_tags (const char *text, int len, long long item_id) {
   deleted_text_bytes += I->len;
   I->len = new_len;
   I->str = s;
+  I->extra |= FLAG_REINDEX;
   return 1;
 }
 
@@ -378,6 +388,9 @@ static int reset_all_rates (struct lev_search_reset_all_rates *E) {
       if (I->rates[p]) {
         I->rates[p] = 0;
         r++;
+        if (n == 13) {
+          I->extra |= FLAG_REINDEX;
+        }
       }
     }
   }
@@ -435,6 +448,7 @@ static int change_item (const char *text, int len, long long item_id, int rate,
   I->len = len;
   assert (strlen (text) <= len);
   strcpy (I->str, text);
+  I->extra |= FLAG_REINDEX;
 
   return 1;
 }
@@ -735,6 +749,124 @@ long long jump_log_pos = 0;
 int jump_log_ts = 0;
 unsigned jump_log_crc32 = 0;
 
+#ifndef SEARCHX
+/*
+ *  INDEX MERGE (-M)
+ *
+ *  Word lists of the previous index are kept in memory,
+ *  pairs of items which text wasn't changed since that index are taken from these lists
+ *  (with renumbered doc_id) instead of re-tokenizing all item texts.
+ */
+
+int index_merge;
+static struct search_index_header OldHeader;
+static struct search_index_word *OldWords;
+static struct search_index_hapax_legomena *OldHapaxLegomena;
+static unsigned char *OldIndexData;
+static long long old_word_index_offset, old_idx_bytes;
+static long long *OldItemIds;
+/* new doc_id of old doc_id or -1 if item was changed or deleted */
+static int *OldDocRemap;
+static int reused_items;
+/* old index is allocated from the top of dyn heap, so it is counted in -H limit;
+   dyn_last is moved below it until index merge is done, so dyn_clear_high () keeps it */
+static char *old_index_dyn_top, *old_index_dyn_last;
+
+static void *load_old_index_section (int fd, long long offset, long long size, unsigned crc32) {
+  void *a = dyn_top_alloc (size > 0 ? size : 1, 8);
+  if (a == NULL) {
+    kprintf ("index merge: not enough dynamic data buffer for %lld bytes of old index\n", size);
+    return NULL;
+  }
+  long long r = 0;
+  while (r < size) {
+    long t = pread (fd, (char *) a + r, size - r, offset + r);
+    if (t <= 0) {
+      kprintf ("index merge: error reading old index at position %lld: %m\n", offset + r);
+      return NULL;
+    }
+    r += t;
+  }
+  if (size > 0 && compute_crc32 (a, size) != crc32) {
+    kprintf ("index merge: crc32 mismatch in old index section at position %lld\n", offset);
+    return NULL;
+  }
+  return a;
+}
+
+static void free_old_index (void) {
+  if (old_index_dyn_last) {
+    /* nothing is allocated from the top of dyn heap while old index is kept */
+    assert (dyn_top == dyn_last);
+    dyn_top = dyn_last = old_index_dyn_last;
+    old_index_dyn_last = NULL;
+  } else {
+    dyn_top = old_index_dyn_top;
+  }
+  OldWords = NULL;
+  OldHapaxLegomena = NULL;
+  OldIndexData = NULL;
+  OldItemIds = NULL;
+  OldDocRemap = NULL;
+}
+
+/* returns 0 if old word lists can't be reused, full index rebuild is done in this case */
+static int load_old_word_lists (int fd, struct item **IndexItems, int sz_headers) {
+  if (Header.magic != SEARCH_INDEX_WITH_CRC32_MAGIC) {
+    kprintf ("index merge: old index doesn't defended by CRC32.\n");
+    return 0;
+  }
+  if (!check_header (&Header) || Header.left_subtree_size_threshold <= 0) {
+    kprintf ("index merge: old index was built with other settings.\n");
+    return 0;
+  }
+  OldHeader = Header;
+  int i;
+  old_index_dyn_top = dyn_top;
+  long long words_offset = sz_headers + Header.index_items_size + Header.item_texts_size;
+  long long s = (Header.words + 1) * (long long) sizeof (struct search_index_word);
+  OldWords = load_old_index_section (fd, words_offset, s, CRC32_Header.crc32_words);
+  if (OldWords == NULL) {
+    free_old_index ();
+    return 0;
+  }
+  long long hapax_legomena_offset = words_offset + s;
+  s = (Header.hapax_legomena + 1) * (long long) sizeof (struct search_index_hapax_legomena);
+  OldHapaxLegomena = load_old_index_section (fd, hapax_legomena_offset, s, CRC32_Header.crc32_hapax_legomena);
+  if (OldHapaxLegomena == NULL) {
+    free_old_index ();
+    return 0;
+  }
+  old_word_index_offset = hapax_legomena_offset + s + (Header.frequent_words + 1) * (long long) sizeof (struct search_index_word);
+  old_idx_bytes = Header.words ? OldWords[Header.words].file_offset - old_word_index_offset : 0;
+  if (old_idx_bytes < 0) {
+    kprintf ("index merge: bad old index data offset\n");
+    free_old_index ();
+    return 0;
+  }
+  /* word instances array is allocated while old index is kept */
+  if (old_idx_bytes + 12LL * (Header.items + 1) + (long long) max_pairs * sizeof (pair_t) > dyn_free_bytes ()) {
+    kprintf ("index merge: old index word lists (%lld bytes) don't fit into dynamic data buffer together with %d pairs, increase -H.\n", old_idx_bytes, max_pairs);
+    free_old_index ();
+    return 0;
+  }
+  OldIndexData = load_old_index_section (fd, old_word_index_offset, old_idx_bytes, CRC32_Header.crc32_data);
+  if (OldIndexData == NULL) {
+    free_old_index ();
+    return 0;
+  }
+  OldItemIds = ztmalloc (sizeof (OldItemIds[0]) * (Header.items + 1));
+  OldDocRemap = ztmalloc (sizeof (OldDocRemap[0]) * (Header.items + 1));
+  for (i = 0; i < Header.items; i++) {
+    OldItemIds[i] = IndexItems[i]->item_id;
+  }
+  old_index_dyn_last = dyn_last;
+  dyn_last = dyn_top;
+  vkprintf (1, "index merge: %d words, %d hapax legomena, %lld bytes of word lists loaded from old index (%ld bytes of dynamic data buffer)\n", Header.words, Header.hapax_legomena, old_idx_bytes, (long) (old_index_dyn_top - dyn_top));
+  return 1;
+}
+#endif
+
 int load_index (kfs_file_handle_t Index) {
   int fd = Index->fd;
   //long long fsize = Index->info->file_size;
@@ -840,6 +972,12 @@ int load_index (kfs_file_handle_t Index) {
     assert (~idx_crc32_complement == CRC32_Header.crc32_text);
   }
 
+#ifndef SEARCHX
+  if (index_merge && !load_old_word_lists (fd, IndexItems, sizeof (Header) + index_with_crc32 * sizeof (CRC32_Header))) {
+    kprintf ("index merge is impossible, all item texts will be re-tokenized.\n");
+  }
+#endif
+
   zzfree (IndexItems, sizeof (IndexItems[0]) * idx_items);
   vkprintf (1, "finished loading index: %d items\n", idx_items);
 
@@ -912,12 +1050,37 @@ void write_text (void) {
   int len, i;
   Header.index_items_size = 0;
   idx_crc32_complement = -1;
+#ifndef SEARCHX
+  int o = 0;
+  if (OldDocRemap) {
+    for (i = 0; i < OldHeader.items; i++) {
+      OldDocRemap[i] = -1;
+    }
+  }
+#endif
   for (i = 0; i < tot_items; i++) {
     I = Items[i];
+#ifndef SEARCHX
+    int reused = 0;
+    if (OldDocRemap) {
+      /* both old and new items are sorted by item_id */
+      while (o < OldHeader.items && OldItemIds[o] < I->item_id) {
+        o++;
+      }
+      reused = (o < OldHeader.items && OldItemIds[o] == I->item_id && !(I->extra & FLAG_REINDEX));
+      if (reused) {
+        OldDocRemap[o] = i;
+        reused_items++;
+      }
+    }
+    if (wordfreqs_enabled && !reused) {
+#else
     if (wordfreqs_enabled) {
+#endif
       int Qw = extract_words (I->str, I->len, universal, Q, MAX_WORDS, 0, 0); /* tag_owner doesn't matter */
       set_rate_item (I, 13, evaluate_uniq_words_count (Q, Qw));
     }
+    I->extra &= ~FLAG_REINDEX;
     int old_rates_len = kill_zero_rates (I);
     writeout (&I->item_id, 8);
     writeout (&I->mask, 2);
@@ -948,6 +1111,86 @@ void write_text (void) {
   vkprintf (1, "%d item descriptions, %lld bytes of item text written\n", tot_items, Header.item_texts_size);
 }
 
+#ifndef SEARCHX
+static struct list_decoder *zmalloc_old_list_decoder (int N, int K, int bytes, const void *file_offset, int compression_method) {
+  const unsigned char *ptr;
+  if (K <= 2) {
+    ptr = file_offset;
+    compression_method = le_raw_int32;
+  } else if (bytes <= 8) {
+    ptr = file_offset;
+  } else {
+    long long offs;
+    memcpy (&offs, file_offset, 8);
+    offs -= old_word_index_offset;
+    assert (offs >= 0 && offs + bytes <= old_idx_bytes);
+    ptr = OldIndexData + offs;
+  }
+  return zmalloc_list_decoder_ext (N, K, ptr, compression_method, 0, OldHeader.left_subtree_size_threshold);
+}
+
+/* new pairs are stored in the tail of P, merged pairs are written from the head */
+static int merge_pos;
+
+static void merge_old_pair (hash_t word, int old_doc_id, int title) {
+  assert (old_doc_id >= 0 && old_doc_id < OldHeader.items);
+  int doc_id = OldDocRemap[old_doc_id];
+  if (doc_id < 0) {
+    return;
+  }
+  while (merge_pos < max_pairs && (P[merge_pos].word < word || (P[merge_pos].word == word && P[merge_pos].doc_id < doc_id))) {
+    P[PC++] = P[merge_pos++];
+  }
+  if (PC >= merge_pos) {
+    fprintf (stderr, "\nThere are too many pairs (max_pairs = %d).\n"
+                     "Try increase max_pairs using -P command line switch.\n", max_pairs);
+    exit (1);
+  }
+  pair_t *P1 = &P[PC++];
+  P1->word = word;
+  P1->doc_id = doc_id;
+  P1->freqs = title ? 0x10000 : 1;
+}
+
+static void merge_old_word_lists (void) {
+  int i = 0, j = 0, k, new_pairs = PC;
+  merge_pos = max_pairs - new_pairs;
+  memmove (P + merge_pos, P, sizeof (pair_t) * new_pairs);
+  PC = 0;
+  /* words and hapax legomena are both sorted by word hash */
+  while (i < OldHeader.words || j < OldHeader.hapax_legomena) {
+    if (j >= OldHeader.hapax_legomena || (i < OldHeader.words && OldWords[i].word < OldHapaxLegomena[j].word)) {
+      struct search_index_word *w = OldWords + (i++);
+      struct list_decoder *dec = zmalloc_old_list_decoder (OldHeader.items, w->len, w->bytes, &w->file_offset, OldHeader.word_list_compression_methods[0]);
+      struct list_decoder *dec_subseq = NULL;
+      int titles = w->len_subseq, next_title = -1;
+      if (titles > 0) {
+        dec_subseq = zmalloc_old_list_decoder (w->len, titles, w->bytes_subseq, &w->file_offset_subseq, OldHeader.word_list_compression_methods[1]);
+        next_title = dec_subseq->decode_int (dec_subseq);
+      }
+      for (k = 0; k < w->len; k++) {
+        int title = (k == next_title);
+        if (title) {
+          next_title = --titles > 0 ? dec_subseq->decode_int (dec_subseq) : -1;
+        }
+        merge_old_pair (w->word, dec->decode_int (dec), title);
+      }
+      if (dec_subseq) {
+        zfree_list_decoder (dec_subseq);
+      }
+      zfree_list_decoder (dec);
+    } else {
+      unsigned u = OldHapaxLegomena[j].doc_id_and_priority;
+      merge_old_pair (OldHapaxLegomena[j++].word, u & 0x7fffffff, u >> 31);
+    }
+  }
+  while (merge_pos < max_pairs) {
+    P[PC++] = P[merge_pos++];
+  }
+  vkprintf (1, "index merge: %d of %d items reused, %d word instances taken from old index, %d new word instances\n", reused_items, tot_items, PC - new_pairs, new_pairs);
+}
+#endif
+
 void build_pairs_from_text (void) {
   int i;
   struct search_item_text *IT;
@@ -989,6 +1232,9 @@ void build_pairs_from_text (void) {
   sz *= sizeof (pair_t);
   P = zmalloc (sz);
 
+#ifndef SEARCHX
+  int o = 0;
+#endif
   for (i = 0; i < tot_items; i++) {
     IT = readin (12);
     assert (IT);
@@ -1000,6 +1246,15 @@ void build_pairs_from_text (void) {
 #ifdef SEARCHX
     searchx_make_pairs (IT->text, IT->len, i, item_freqs + (3 * i), IT->item_id);
 #else
+    if (OldDocRemap) {
+      while (o < OldHeader.items && OldItemIds[o] < IT->item_id) {
+        o++;
+      }
+      if (o < OldHeader.items && OldDocRemap[o] == i) {
+        /* pairs of this item are taken from old word lists */
+        continue;
+      }
+    }
     search_make_pairs (IT->text, IT->len, i, IT->item_id);
 #endif
   }
@@ -1015,6 +1270,13 @@ void build_pairs_from_text (void) {
   qsort_p (0, PC-1);
 
   vkprintf (1, "sorting %d word instances (%.6lf seconds).\n", PC, t + get_utime (CLOCK_MONOTONIC));
+#ifndef SEARCHX
+  if (OldDocRemap) {
+    merge_old_word_lists ();
+    vkprintf (1, "merging with old index word lists (%.6lf seconds).\n", t + get_utime (CLOCK_MONOTONIC));
+    free_old_index ();
+  }
+#endif
   vkprintf (1, "%d items, %d word instances\n", tot_items, PC);
 }
 
@@ -1394,7 +1656,11 @@ static int search_encode_lists (const int methods[2], int quiet) {
   assert (hl == Header.hapax_legomena);
   memset (HL+hl, 0, sizeof (struct search_index_hapax_legomena));
   for (k=0;k<2;k++) {
-    Header.compression_bytes[2*methods[k]+k] = encoded_bytes[k];
+    /* header has slots only for methods up to le_interpolative_ext,
+       sizes of newer methods are printed by search_optimal_encode_lists and computed by engine from the word lists */
+    if (2*methods[k]+k < sizeof (Header.compression_bytes) / sizeof (Header.compression_bytes[0])) {
+      Header.compression_bytes[2*methods[k]+k] = encoded_bytes[k];
+    }
   }
   return i;
 }
@@ -1407,6 +1673,10 @@ void search_estimate_compression_method (int c[2]) {
     c[0] = c[1] = le_interpolative_ext;
     return;
   }
+  if (compression_speed == 2) {
+    c[0] = c[1] = le_block_packed;
+    return;
+  }
   if (!compression_speed) {
     return;
   }
@@ -1459,13 +1729,19 @@ void search_estimate_compression_method (int c[2]) {
 }
 
 static void search_optimal_encode_lists (void) {
-  int compression_methods[2];
+  int compression_methods[2], i;
   search_estimate_compression_method (compression_methods);
+  for (i = 0; i < 2; i++) {
+    /* skip tables allow intersection to jump over long Golomb lists */
+    if (compression_methods[i] == le_golomb) {
+      compression_methods[i] = le_golomb_skip;
+    }
+  }
   lists_encoded = 0;
   memcpy (Header.word_list_compression_methods, compression_methods, 8);
 
   lseek (fd[0], word_index_offset, SEEK_SET);
-  int i = search_encode_lists (compression_methods, 0);
+  i = search_encode_lists (compression_methods, 0);
   CRC32_Header.crc32_data = ~idx_crc32_complement;
   memset (W+i, 0, sizeof (struct search_index_word));
   W[i].file_offset = cur_offs;
@@ -1473,6 +1749,20 @@ static void search_optimal_encode_lists (void) {
   if (verbosity > 0) {
     kprintf ("wrote %lld codes bytes in %d lists\n",
       cur_offs - word_index_offset, lists_encoded);
+    const long long golomb_cb = get_compression_bytes (le_golomb);
+    if (golomb_cb > 0) {
+      kprintf ("%s+%s coding: %lld(%.6lf%%) = %lld(%.6lf%%)+%lld(%.6lf%%) bytes.\n",
+        list_get_compression_method_description (compression_methods[0]),
+        list_get_compression_method_description (compression_methods[1]),
+        encoded_bytes[0] + encoded_bytes[1], percent (encoded_bytes[0] + encoded_bytes[1], golomb_cb),
+        encoded_bytes[0], percent (encoded_bytes[0], Header.compression_bytes[0]),
+        encoded_bytes[1], percent (encoded_bytes[1], Header.compression_bytes[1]));
+    } else {
+      kprintf ("%s+%s coding: %lld = %lld+%lld bytes.\n",
+        list_get_compression_method_description (compression_methods[0]),
+        list_get_compression_method_description (compression_methods[1]),
+        encoded_bytes[0] + encoded_bytes[1], encoded_bytes[0], encoded_bytes[1]);
+    }
     if (compression_speed < 0) {
       kprintf ("wrote %lld(%.6lf%%) interpolative redundant bits.\n", redundant_bits, percent (redundant_bits, interpolative_ext_bits));
     }
@@ -1548,13 +1838,17 @@ void usage (void) {
     "\t-O\tenable tag owner mode\n"
 #ifndef SEARCHX
     "\t-Q\toutput hash stats\n"
-    "\t-0\tuse only Golomb coding (faster decompression)\n"
+    "\t-0\tuse only Golomb coding (faster decompression), Golomb lists are stored with skip tables\n"
     "\t-1\tuse Interpolative coding (slower decompression)\n"
     "\t\t\tif it consumes less than %.6lf%% memory used by Golomb coding\n"
     "\t-2\tuse Interpolative coding if it consumes less memory than Golomb coding\n"
+    "\t-4\tuse Block packed coding (fastest decompression, allows skipping blocks of 128 items)\n"
     "\t-x<left subtree size threshold>\tuse Redundant Interpolative coding.\n"
     "\t by default -x%d compression is used.\n"
     "\t-I<filename>\toutput to the given text file all item_ids and exit without saving index\n"
+    "\t-M\tmerge mode: reuse word lists of unchanged items from the previous index\n"
+    "\t\tinstead of re-tokenizing all item texts (falls back to full rebuild if settings differ\n"
+    "\t\tor old word lists don't fit into heap together with max_pairs)\n"
 #endif
 	  , progname
 #ifndef SEARCHX
@@ -1626,7 +1920,7 @@ void save_index (void) {
 
 static const char *options = "AB:H:I:OP:SWa:dfhl:tu:vU"
 #ifndef SEARCHX
-  "Q0123x:"
+  "MQ01234x:"
 #endif
 ;
 
@@ -1678,9 +1972,17 @@ int main (int argc, char *argv[]) {
       compression_speed = 1;
       interpolative_percent = 1000.0;
       break;
+    case '4':
+      compression_speed = 2;
+      break;
     case 'Q':
       hash_stats++;
       break;
+#ifndef SEARCHX
+    case 'M':
+      index_merge = 1;
+      break;
+#endif
     case 'v':
       verbosity++;
       break;
@@ -55,7 +55,8 @@ extern long long jump_log_pos;
 extern int jump_log_ts;
 extern unsigned jump_log_crc32;
 extern int idx_items, idx_words, idx_hapax_legomena;
-extern long idx_bytes, idx_loaded_bytes;
+extern long idx_bytes;
+extern long long idx_loaded_bytes;
 
 int load_index (kfs_file_handle_t Index);
 
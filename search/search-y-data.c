@@ -82,7 +82,8 @@ static int *IndexPositions;
 static struct searchy_index_word *IndexWords;
 static char *IndexData;
 int idx_items, idx_words;
-long long idx_bytes, idx_loaded_bytes;
+long long idx_bytes;
+long long idx_loaded_bytes;
 
 static long long item_texts_offset, words_offset, hapax_legomena_offset, freq_words_offset, word_index_offset, index_size;
 
@@ -109,7 +110,7 @@ int load_index (kfs_file_handle_t Index) {
 
   int sz = sizeof (struct search_index_header);
 
-  r = read (fd, &Header, sz);
+  r = kfs_read_file (Index, &Header, sz);
   if (r < 0) {
     kprintf ("error reading index file header: %m\n");
     return -3;
@@ -136,7 +137,7 @@ int load_index (kfs_file_handle_t Index) {
 
   const int sz_headers = sizeof (Header) + sizeof (CRC32_Header);
   sz = sizeof (CRC32_Header);
-  if (sz != read (fd, &CRC32_Header, sz)) {
+  if (sz != kfs_read_file (Index, &CRC32_Header, sz)) {
     kprintf ("error reading index (crc32_header). %m\n");
     return -5;
   }
@@ -162,7 +163,7 @@ int load_index (kfs_file_handle_t Index) {
   idx_loaded_bytes = sz_headers;
   /* we never freed this array, so we use zmalloc instead of zzmalloc */
   IndexItems = zmalloc0 (sizeof (struct index_item) * (Header.items + 1));
-  set_read_file (fd);
+  set_read_kfs_file (Index);
   int rbytes = 0;
   for (i = 0; i < Header.items; i++) {
     int t = load_item (IndexItems+i);
@@ -179,23 +180,15 @@ int load_index (kfs_file_handle_t Index) {
   idx_loaded_bytes += rbytes;
   vkprintf (1, "%lld bytes for %d items read from index\n", Header.index_items_size, Header.items);
 
-  assert (lseek (fd, words_offset, SEEK_SET) >= 0);
-
   s = (Header.words + 1) * 1LL * sizeof (struct searchy_index_word);
-  /* we never freed this array, so we use zmalloc instead of zzmalloc */
-  IndexWords = zmalloc (s);
-
-  r = read (fd, IndexWords, s);
-  if (r > 0) {
-    idx_loaded_bytes += r;
-  }
-  if (r < s) {
-    kprintf ("error reading words from index file: read %ld bytes instead of %ld at position %lld: %m\n", r, s, words_offset);
+  IndexWords = kfs_load_file_section (Index, words_offset, s, &idx_loaded_bytes);
+  if (!IndexWords) {
+    kprintf ("error reading words from index file: %ld bytes at position %lld\n", s, words_offset);
     return -2;
   } else {
-    vkprintf (1, "%ld bytes for %d words read from index\n", r, Header.words);
+    vkprintf (1, "%ld bytes for %d words read from index\n", s, Header.words);
   }
-  assert (CRC32_Header.crc32_words == compute_crc32 (IndexWords, s));
+  assert (CRC32_Header.crc32_words == compute_crc32_parallel (IndexWords, s));
 
   idx_items = Header.items;
   idx_words = Header.words;
@@ -230,28 +223,22 @@ int load_index (kfs_file_handle_t Index) {
   assert (idx_bytes >= 0 && idx_bytes <= MAX_INDEX_BYTES);
 
   s = idx_bytes;
-  /* we never freed this array, so we use zmalloc instead of zzmalloc */
-  IndexData = zmalloc (s);
-  assert (lseek (fd, word_index_offset, SEEK_SET) >= 0);
-  r = read (fd, IndexData, s);
-  idx_loaded_bytes += r;
-  if (r < s) {
-    kprintf ("error reading data from index file: read %ld bytes instead of %ld at position %lld: %m\n", r, s, word_index_offset);
+  IndexData = kfs_load_file_section (Index, word_index_offset, s, &idx_loaded_bytes);
+  if (!IndexData) {
+    kprintf ("error reading data from index file: %ld bytes at position %lld\n", s, word_index_offset);
     return -2;
   }
 
-  assert (CRC32_Header.crc32_data == compute_crc32 (IndexData, s));
+  assert (CRC32_Header.crc32_data == compute_crc32_parallel (IndexData, s));
 
   s = 4 * idx_items + 4;
-  IndexPositions = zmalloc (s);
-  r = read (fd, IndexPositions, s);
-  idx_loaded_bytes += r;
-  if (r < s) {
-    kprintf ("error reading index positions from index file: read %ld bytes instead of %ld at position %lld: %m\n", r, s, word_index_offset);
+  IndexPositions = kfs_load_file_section (Index, word_index_offset + idx_bytes, s, &idx_loaded_bytes);
+  if (!IndexPositions) {
+    kprintf ("error reading index positions from index file: %ld bytes at position %lld\n", s, word_index_offset);
     return -2;
   }
-  assert (IndexPositions[idx_items] == compute_crc32 (IndexPositions, s - 4));
-  vkprintf (1, "finished loading index: %d items, %d words, %lld index bytes, %lld preloaded bytes\n", idx_items, idx_words, idx_bytes, idx_loaded_bytes);
+  assert (IndexPositions[idx_items] == compute_crc32_parallel (IndexPositions, s - 4));
+  vkprintf (1, "finished loading index: %d items, %d words, %lld index bytes, %lld preloaded bytes, %lld mapped bytes\n", idx_items, idx_words, idx_bytes, idx_loaded_bytes, kfs_mapped_bytes);
 
   //check_lists_decoding ();
 
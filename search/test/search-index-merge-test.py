@@ -0,0 +1,135 @@
+#!/usr/bin/env python
+# Compares indexes built by search-index in merge mode (-M) with full rebuilds.
+# Several generations of updates (new, changed, deleted and re-rated items) are written
+# into binlog through search-engine, after each generation both indexes are built from
+# the same index + binlog tail and must be byte-identical except created_at and crc32 of header.
+#
+# usage: search-index-merge-test.py [-b <bin dir>] [-r <rounds>]
+
+import os, sys, logging, subprocess, shutil, random, time, getopt, socket, struct
+
+LEV_START = 0x044c644b
+SEARCH_SCHEMA_V1 = 0xbeef0101
+# offsetof (struct search_index_header, created_at), sizeof (struct search_index_header)
+CREATED_AT_OFFSET = 4
+HEADER_SIZE = 184
+PORT = 11326
+
+def _rmdir (dir):
+  if os.path.lexists (dir) and os.path.isdir (dir):
+    shutil.rmtree (dir)
+
+def _emptydir (dir):
+  _rmdir (dir)
+  os.makedirs (dir, 0o700)
+
+def init ():
+  global BIN, TMP_DIR
+  fmt = '%(asctime)s %(levelname)s %(message)s'
+  logging.basicConfig (level=logging.DEBUG, format=fmt)
+  if BIN is None:
+    suffix = '32' if os.getenv ('m') == '32' else ''
+    BIN = os.path.join (os.path.expanduser ('~'), 'engine/src/objs' + suffix + '/bin')
+  TMP_DIR = os.path.join (os.path.expanduser ('~'), 'tmp', '.search-index-merge')
+  _emptydir (TMP_DIR)
+
+def run (cmd, cwd, log):
+  logging.info ('run (%s) in %s' % (' '.join (cmd), cwd))
+  f = open (os.path.join (cwd, log), 'w')
+  subprocess.check_call (cmd, cwd=cwd, stdout=f, stderr=f)
+  f.close ()
+
+def last_index (dir):
+  return os.path.join (dir, sorted (x for x in os.listdir (dir) if x.startswith ('s.') and not x.endswith ('.bin'))[-1])
+
+def build_index (dir, flags, merge):
+  cmd = [os.path.join (BIN, 'search-index'), '-u', 'root', '-H', '512m', '-P', '2000000'] + flags
+  if merge:
+    cmd += ['-v', '-M']
+  run (cmd + ['s'], dir, 'index.log')
+
+def recv_line (s, buf):
+  while b'\r\n' not in buf[0]:
+    r = s.recv (4096)
+    assert r, 'connection closed by search-engine'
+    buf[0] += r
+  p = buf[0].index (b'\r\n')
+  line, buf[0] = buf[0][:p], buf[0][p + 2:]
+  return line
+
+def random_text ():
+  title = ['zipf%d' % int (random.paretovariate (0.7)) for _ in range (random.randint (1, 4))]
+  body = ['zipf%d' % int (random.paretovariate (0.7)) for _ in range (random.randint (0, 6))]
+  if random.random () < 0.9: body.append ('freq')
+  if random.random () < 0.5: title.append ('half')
+  if random.random () < 0.1: title.append ('uniq%d' % random.randint (0, 10 ** 9))
+  return (' '.join (title) + '\t' + ' '.join (body)).encode ()
+
+def write_generation (dir, gen):
+  p = subprocess.Popen ([os.path.join (BIN, 'search-engine'), '-u', 'root', '-c', '1000', '-p', str (PORT), 's'], cwd=dir,
+                        stdout=open (os.path.join (dir, 'engine.log'), 'w'), stderr=subprocess.STDOUT)
+  s = None
+  for _ in range (100):
+    try:
+      s = socket.create_connection (('127.0.0.1', PORT))
+      break
+    except socket.error:
+      time.sleep (0.1)
+  assert s, 'search-engine does not accept connections'
+  buf = [b'']
+  def cmd (c, expected):
+    s.sendall (c)
+    r = recv_line (s, buf)
+    assert r in expected, '%r returned %r' % (c, r)
+  random.seed (gen)
+  base = 1000 * (gen + 1)
+  for i in list (range (base, base + 500)) + random.sample (range (1, base), min (base - 1, 300)):
+    t = random_text ()
+    cmd (b'set item%d#%d,%d 0 0 %d\r\n%s\r\n' % (i, (i * 7) % 100, i % 7, len (t), t), [b'STORED'])
+  if gen > 0:
+    for i in random.sample (range (1, base), 100):
+      cmd (b'delete item%d\r\n' % i, [b'DELETED', b'NOT_FOUND'])
+    for i in random.sample (range (1, base), 100):
+      cmd (b'set rate%d 0 0 3\r\n%d\r\n' % (i, random.randint (100, 999)), [b'STORED', b'NOT_STORED'])
+  s.close ()
+  p.terminate ()
+  p.wait ()
+
+def compare_indexes (a, b):
+  x = bytearray (open (a, 'rb').read ())
+  y = bytearray (open (b, 'rb').read ())
+  for z in (x, y):
+    z[CREATED_AT_OFFSET:CREATED_AT_OFFSET + 4] = b'\0' * 4
+    z[HEADER_SIZE:HEADER_SIZE + 4] = b'\0' * 4
+  assert x == y, '%s and %s differ' % (a, b)
+
+def test_merge (flags):
+  dir = os.path.join (TMP_DIR, 'merge' + ''.join (flags))
+  full = dir + '.full'
+  _emptydir (dir)
+  open (os.path.join (dir, 's.000000.bin'), 'wb').write (struct.pack ('<6i', LEV_START, SEARCH_SCHEMA_V1 - (1 << 32), 0, 1, 0, 1))
+  write_generation (dir, 0)
+  build_index (dir, flags, False)
+  for gen in range (1, ROUNDS + 1):
+    write_generation (dir, gen)
+    _emptydir (full)
+    shutil.copy (os.path.join (dir, 's.000000.bin'), full)
+    shutil.copy (last_index (dir), full)
+    build_index (dir, flags, True)
+    build_index (full, flags, False)
+    log = open (os.path.join (dir, 'index.log')).read ()
+    assert 'items reused' in log, 'index merge was not done:\n' + log
+    compare_indexes (last_index (dir), last_index (full))
+    logging.info ('flags %s, generation %d: %s is identical to full rebuild' % (' '.join (flags), gen, last_index (dir)))
+
+optlist, args = getopt.getopt (sys.argv[1:], 'b:r:')
+BIN = None
+ROUNDS = 3
+
+for o, a in optlist:
+  if o == '-b': BIN = a
+  elif o == '-r': ROUNDS = int (a)
+
+init ()
+for flags in ([], ['-W'], ['-0'], ['-2'], ['-4']):
+  test_merge (flags)
@@ -218,6 +218,7 @@ void *zzrealloc_ushort_mask (void *src, int mask_old, int mask_new, int size_of_
 
 char Buff[BUFFSIZE], *rptr = Buff, *wptr = Buff;
 int rfd, wfd;
+static kfs_file_handle_t rkfs;
 unsigned idx_crc32_complement;
 
 void flushout (void) {
@@ -265,7 +266,7 @@ void *readin (size_t len) {
   memcpy (Buff, rptr, wptr - rptr);
   wptr -= rptr - Buff;
   rptr = Buff;
-  int r = read (rfd, wptr, Buff + BUFFSIZE - wptr);
+  int r = rkfs ? kfs_read_file (rkfs, wptr, Buff + BUFFSIZE - wptr) : read (rfd, wptr, Buff + BUFFSIZE - wptr);
   if (r < 0) {
     fprintf (stderr, "error reading file: %m\n");
   } else {
@@ -296,6 +297,13 @@ void set_read_file (int read_fd) {
   flushout ();
   clearin ();
   rfd = read_fd;
+  rkfs = 0;
+}
+
+/* reads through kfs, so encrypted snapshots are decrypted */
+void set_read_kfs_file (kfs_file_handle_t F) {
+  set_read_file (F->fd);
+  rkfs = F;
 }
 
 void set_write_file (int write_fd) {
@@ -35,6 +35,7 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include "search-index-layout.h"
+#include "kfs.h"
 
 #define likely(x) __builtin_expect((x),1)
 #define unlikely(x) __builtin_expect((x),0)
@@ -66,6 +67,7 @@ void *readin (size_t len);
 void readadv (size_t len);
 void bread (void *b, size_t len);
 void set_read_file (int read_fd);
+void set_read_kfs_file (kfs_file_handle_t F);
 void set_write_file (int write_fd);
 
 /* returns prime number which greater than 1.5n and not greater than 1.1 * 1.5 * n */
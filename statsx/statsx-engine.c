@@ -1128,6 +1128,16 @@ void start_server (void) {
   int prev_time;
   int old_sigusr1_cnt = 0, old_sighup_cnt = 0;
 
+  if (reactors > 1) {
+    if (!binlog_disabled) {
+      kprintf ("fatal: multiple reactors are supported only in replica mode (-r)\n");
+      exit (1);
+    }
+    if (start_reactors (reactors) > 0 && Binlog && kfs_reopen_file (Binlog) < 0) {
+      exit (1);
+    }
+  }
+
   init_epoll();
   init_netbuffers();
   if (udp_enabled) {
@@ -1141,7 +1151,7 @@ void start_server (void) {
   prev_time = 0;
 
   if (!sfd) {
-    sfd = server_socket (port, settings_addr, backlog, 0);
+    sfd = server_socket (port, settings_addr, backlog, reactors > 1 ? SM_REUSEPORT : 0);
   }
 
   if (sfd < 0) {
@@ -1332,6 +1342,13 @@ int f_parse_option (int val) {
   case 1000:
     binlog_cyclic_mode = 1;
     break;
+  case 1001:
+    reactors = atoi (optarg);
+    if (reactors < 1 || reactors > MAX_REACTORS) {
+      kprintf ("Illegal --reactors option: %s\n", optarg);
+      exit (1);
+    }
+    break;
   default:
     return -1;
   }
@@ -1367,6 +1384,7 @@ int main (int argc, char *argv[]) {
   parse_option ("counter-growth", required_argument, 0, 'P', "counter hash table growth in percents (default %lf)", max_counters_growth_percent);
   parse_option ("default-timezone", required_argument, 0, 'S', "default timezone (hours offset from GMT)");
   parse_option ("cyclic-binlog", required_argument, 0, 1000, "use binlog in cyclic mode");
+  parse_option ("reactors", required_argument, 0, 1001, "number of event-loop processes sharing the port (replica mode only, default 1)");
   
   parse_engine_options_long (argc, argv, f_parse_option);
   if (argc != optind + 1 && argc != optind + 2) {
@@ -610,6 +610,19 @@ void *load_index_part (void *data, long long offset, long long size, int max_siz
   return data;
 }
 
+/* same as load_index_part (0, ...), but the part is mapped from snapshot when possible, so it must never be modified */
+static void *load_index_part_immutable (kfs_file_handle_t Index, long long offset, long long size) {
+  assert (size >= 0 && offset >= 0 && offset + size <= idx_bytes);
+  char *data = kfs_load_file_section (Index, offset, size + 4, &idx_loaded_bytes);
+  assert (data);
+  unsigned data_crc32 = compute_crc32 (data, size);
+  if (data_crc32 != *(unsigned *) (data + size)) {
+    fprintf (stderr, "error reading %lld bytes from index file at position %lld: crc32 mismatch: expected %08x, actual %08x\n", size, offset, *(unsigned *) (data + size), data_crc32);
+    assert (0);
+  }
+  return data;
+}
+
 void idx_read_user (void) {
   assert (idx_load_next (sizeof (struct targ_index_user_v1)) >= sizeof (struct targ_index_user_v1));
   struct targ_index_user_v1 *T = (struct targ_index_user_v1 *) idx_rptr;
@@ -1128,7 +1141,8 @@ int load_index (kfs_file_handle_t Index) {
   idx_ads = Header.ads;
   idx_max_uid = Header.max_uid;
 
-  idx_worddir = load_index_part (0, Header.word_directory_offset, (idx_words + 1) * sizeof (struct targ_index_word_directory_entry), 1 << 30);
+  assert ((idx_words + 1) * sizeof (struct targ_index_word_directory_entry) <= (1 << 30));
+  idx_worddir = load_index_part_immutable (Index, Header.word_directory_offset, (idx_words + 1) * sizeof (struct targ_index_word_directory_entry));
 
   int plast = -4;
   for (i = 0; i < idx_words; i++) {
@@ -1157,7 +1171,8 @@ int load_index (kfs_file_handle_t Index) {
   assert (idx_cur_read_pos () == Header.word_data_offset);
 
   idx_word_data_bytes = idx_worddir[idx_words].data_offset;
-  idx_word_data = load_index_part (0, Header.word_data_offset, idx_word_data_bytes, 1 << 30);
+  assert (idx_word_data_bytes <= (1 << 30));
+  idx_word_data = load_index_part_immutable (Index, Header.word_data_offset, idx_word_data_bytes);
 
   if (!targeting_disabled) {
     idx_fresh_ad_dir = load_index_part ((void *) -1, Header.fresh_ads_directory_offset, (idx_fresh_ads + 1) * sizeof (struct targ_index_ads_directory_entry), 1 << 28);
@@ -233,6 +233,7 @@ int tree_nodes, online_tree_nodes, incore_messages;
 int msg_search_nodes, edit_text_nodes;
 long msg_search_nodes_bytes, edit_text_bytes;
 int idx_fd, idx_users, idx_loaded_bytes, idx_last_global_id;
+static kfs_file_handle_t idx_file;
 int idx_search_enabled, idx_crc_enabled, idx_persistent_history_enabled, idx_sublists_offset;
 long long idx_fsize;
 
@@ -275,7 +276,7 @@ void *load_index_part (void *data, long long offset, long long size, int max_siz
     return 0;
   }
   if (idx_crc_enabled) {
-    unsigned data_crc32 = compute_crc32 (data, size - 4);
+    unsigned data_crc32 = compute_crc32_parallel (data, size - 4);
     if (data_crc32 != index_part_crc32) {
       fprintf (stderr, "error reading %lld bytes from index file at position %lld: crc32 mismatch: expected %08x, actual %08x\n", size, offset, index_part_crc32, data_crc32);
       assert (data_crc32 == index_part_crc32);
@@ -283,6 +284,25 @@ void *load_index_part (void *data, long long offset, long long size, int max_siz
     }
   }
   idx_loaded_bytes += r;
+  kfs_account_read (idx_file, r);
+  return data;
+}
+
+/* same as load_index_part (0, ...), but the part is mapped from snapshot when possible, so it must never be modified */
+static void *load_index_part_immutable (long long offset, long long size, int max_size) {
+  long long loaded_bytes = 0;
+  assert (size >= 0 && size <= max_size);
+  assert (offset >= 0 && offset + size <= idx_fsize);
+  char *data = kfs_load_file_section (idx_file, offset, size + idx_crc_enabled * 4, &loaded_bytes);
+  assert (data);
+  if (idx_crc_enabled) {
+    unsigned data_crc32 = compute_crc32_parallel (data, size);
+    if (data_crc32 != *(unsigned *) (data + size)) {
+      fprintf (stderr, "error reading %lld bytes from index file at position %lld: crc32 mismatch: expected %08x, actual %08x\n", size, offset, *(unsigned *) (data + size), data_crc32);
+      assert (0);
+    }
+  }
+  idx_loaded_bytes += loaded_bytes;
   return data;
 }
 
@@ -323,7 +343,7 @@ struct word_dictionary *load_dictionary (struct word_dictionary *D, long long of
   int N, i, j, k;
   struct file_word_dictionary *tmp;
   long long x;
-  D->raw_data = load_index_part (0, offset, size, MAX_FILE_DICTIONARY_BYTES);
+  D->raw_data = load_index_part_immutable (offset, size, MAX_FILE_DICTIONARY_BYTES);
   assert (D->raw_data);
   D->raw_data_len = size;
   assert (size >= 4);
@@ -559,6 +579,7 @@ int load_index (kfs_file_handle_t Index) {
 
   idx_fsize = fsize;
   idx_fd = fd;
+  idx_file = Index;
   idx_loaded_bytes = 0;
   idx_users = Header.tot_users;
 
@@ -579,7 +600,7 @@ int load_index (kfs_file_handle_t Index) {
   load_dictionary (&WordDict, Header.word_dictionary_offset, Header.notword_dictionary_offset - Header.word_dictionary_offset - idx_crc_enabled * 4);
   load_dictionary (&NotWordDict, Header.notword_dictionary_offset, Header.user_list_offset - Header.notword_dictionary_offset - idx_crc_enabled * 4);
 
-  user_list_metafile = load_index_part (0, Header.user_list_offset, Header.tot_users * userlist_entry_size + 16, MAX_USERLIST_BYTES);
+  user_list_metafile = load_index_part_immutable (Header.user_list_offset, Header.tot_users * userlist_entry_size + 16, MAX_USERLIST_BYTES);
   FileUsers = zmalloc (sizeof (void *) * (Header.tot_users + 1));
 
   for (i = 0; i <= Header.tot_users; i++) {
@@ -601,6 +622,9 @@ int load_index (kfs_file_handle_t Index) {
   }
   assert (FileUsers[i]->user_data_offset <= Header.extra_data_offset);
 
+  /* dictionaries are loaded, from now on only metafiles of requested users are read */
+  kfs_set_access_pattern (Index, KFS_ACCESS_RANDOM);
+
   if (verbosity > 0) {
     fprintf (stderr, "finished loading index: %lld index bytes, %d preloaded bytes\n", idx_fsize, idx_loaded_bytes);
   }
@@ -998,6 +1022,10 @@ core_mf_t *load_user_metafile (long long user_id) {
     assert (M->aio);
     //WaitAio = M->aio;
     WaitAioArrAdd (M->aio);
+    /* search data of the user follows user data; readahead is off for random access, so ask for it explicitly */
+    if (idx_search_enabled && !U->search_mf) {
+      kfs_prefetch_range (idx_file, D->user_data_offset + D->user_data_size + idx_crc_enabled * 4, ((struct file_user_list_entry_search *) D)->user_search_size + idx_crc_enabled * 4);
+    }
   }
 
   assert (!M->next);
@@ -1014,6 +1042,7 @@ int onload_search_metafile (struct connection *c, int read_bytes) {
   if (verbosity > 0) {
     fprintf (stderr, "onload_search_metafile(%p,%d)\n", c, read_bytes);
   }
+  kfs_account_read (idx_file, read_bytes);
   assert (idx_search_enabled);
 
   struct aio_connection *a = (struct aio_connection *)c;
@@ -1091,6 +1120,7 @@ int onload_history_metafile (struct connection *c, int read_bytes) {
   if (verbosity > 0) {
     fprintf (stderr, "onload_history_metafile(%p,%d)\n", c, read_bytes);
   }
+  kfs_account_read (idx_file, read_bytes);
   assert (idx_persistent_history_enabled);
 
   struct aio_connection *a = (struct aio_connection *)c;
@@ -1173,6 +1203,7 @@ int onload_user_metafile (struct connection *c, int read_bytes) {
   if (verbosity > 0) {
     fprintf (stderr, "onload_user_metafile(%p,%d)\n", c, read_bytes);
   }
+  kfs_account_read (idx_file, read_bytes);
   struct aio_connection *a = (struct aio_connection *)c;
   core_mf_t *M = (core_mf_t *) a->extra;
   user_t *U = M->user;
@@ -0,0 +1,316 @@
+/*
+ This file is distributed as is. Do whatever you want with this source.
+*/
+
+#define	_FILE_OFFSET_BITS	64
+
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "net-events.h"
+#include "net-buffers.h"
+#include "server-functions.h"
+#include "net-connections.h"
+#include "net-memcache-server.h"
+
+/*
+ *	replays a memcache text protocol stream (captured request side of a connection,
+ *	or a generated sample) through mcs_parse_execute() with every delimiter scanner
+ */
+
+#define	MAX_SAMPLE_SIZE	(1 << 30)
+
+int verbosity;
+
+static char *data;
+static int data_len;
+static int chunk_size = 16384, rounds = 10, keys_per_get = 20, key_len = 24;
+static long long queries, keys, key_bytes;
+
+static struct connection BC;
+
+static int bench_execute (struct connection *c, int op) {
+  int res = mcs_execute (c, op);
+  if (res <= 0) {
+    queries++;
+  }
+  advance_skip_read_ptr (&c->Out, c->Out.total_bytes);
+  free_unused_buffers (&c->Out);
+  return res;
+}
+
+static int bench_store (struct connection *c, int op, const char *key, int key_len, int flags, int delay, int size) {
+  return -2;
+}
+
+static int bench_get (struct connection *c, const char *key, int key_len) {
+  keys++;
+  key_bytes += key_len;
+  return 0;
+}
+
+static int bench_get_start (struct connection *c) {
+  return 0;
+}
+
+static int bench_get_end (struct connection *c, int key_count) {
+  return 0;
+}
+
+static int bench_incr (struct connection *c, int op, const char *key, int key_len, long long arg) {
+  return 0;
+}
+
+static int bench_delete (struct connection *c, const char *key, int key_len) {
+  return 0;
+}
+
+static int bench_stats (struct connection *c) {
+  return 0;
+}
+
+struct memcache_server_functions bench_memcache_server = {
+  .execute = bench_execute,
+  .mc_store = bench_store,
+  .mc_get_start = bench_get_start,
+  .mc_get = bench_get,
+  .mc_get_end = bench_get_end,
+  .mc_incr = bench_incr,
+  .mc_delete = bench_delete,
+  .mc_version = bench_stats,
+  .mc_stats = bench_stats
+};
+
+static void init_bench_connection (struct connection *c) {
+  memset (c, 0, sizeof (*c));
+  c->fd = -1;
+  c->type = &ct_memcache_server;
+  c->extra = &bench_memcache_server;
+  c->basic_type = ct_inbound;
+  c->status = conn_expect_query;
+  init_builtin_buffer (&c->In, c->in_buff, BUFF_SIZE);
+  init_builtin_buffer (&c->Out, c->out_buff, BUFF_SIZE);
+  MCS_DATA(c)->crypto_flags = 1;
+}
+
+/* same parse loop as server_reader(), fed from memory in chunk_size pieces */
+static void replay (struct connection *c, const char *ptr, int len) {
+  while (len > 0 && !c->error) {
+    int r = len < chunk_size ? len : chunk_size;
+    assert (write_out (&c->In, ptr, r) == r);
+    ptr += r;
+    len -= r;
+
+    int s = c->skip_bytes;
+    if (s < 0) {
+      int r1 = c->In.total_bytes;
+      if (r1 > -s) {
+        r1 = -s;
+      }
+      advance_skip_read_ptr (&c->In, r1);
+      c->skip_bytes = s += r1;
+      if (s) {
+        continue;
+      }
+    } else if (s > 0) {
+      if (c->In.total_bytes < s) {
+        continue;
+      }
+      c->skip_bytes = 0;
+    }
+
+    while (!c->skip_bytes && (c->status == conn_expect_query || c->status == conn_reading_query)) {
+      if (!c->In.total_bytes) {
+        break;
+      }
+      if (c->status == conn_expect_query) {
+        nbit_set (&c->Q, &c->In);
+        c->parse_state = 0;
+        c->status++;
+      } else if (!nbit_ready_bytes (&c->Q)) {
+        break;
+      }
+      int res = c->type->parse_execute (c);
+      if (!res) {
+        nbit_clear (&c->Q);
+        if (c->status == conn_reading_query) {
+          c->status--;
+        }
+      } else if (res != NEED_MORE_BYTES) {
+        if (res < 0) {
+          assert (!c->In.total_bytes);
+          res -= c->In.total_bytes;
+        } else {
+          res += c->In.total_bytes;
+        }
+        c->skip_bytes = res;
+        break;
+      }
+    }
+    free_unused_buffers (&c->In);
+  }
+  free_all_buffers (&c->In);
+  free_all_buffers (&c->Out);
+}
+
+static void generate_sample (int size) {
+  static const char value[] = "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz";
+  data = malloc (size + keys_per_get * (key_len + 1) + 4096);
+  assert (data);
+  int i = 0, j, k;
+  while (i < size) {
+    k = lrand48 () % 10;
+    if (k < 7) {
+      i += sprintf (data + i, "get");
+      for (j = 0; j < keys_per_get; j++) {
+        i += sprintf (data + i, " user%0*ld", key_len - 4 > 0 ? key_len - 4 : 1, lrand48 ());
+      }
+      i += sprintf (data + i, "\r\n");
+    } else if (k < 9) {
+      int l = lrand48 () % (sizeof (value) - 1);
+      i += sprintf (data + i, "set user%0*ld 0 0 %d\r\n%.*s\r\n", key_len - 4 > 0 ? key_len - 4 : 1, lrand48 (), l, l, value);
+    } else {
+      i += sprintf (data + i, "delete user%0*ld\r\n", key_len - 4 > 0 ? key_len - 4 : 1, lrand48 ());
+    }
+  }
+  data_len = i;
+}
+
+static void load_sample (const char *filename) {
+  struct stat st;
+  int fd = open (filename, O_RDONLY);
+  if (fd < 0 || fstat (fd, &st) < 0) {
+    fprintf (stderr, "cannot open %s: %m\n", filename);
+    exit (1);
+  }
+  if (st.st_size <= 0 || st.st_size > MAX_SAMPLE_SIZE) {
+    fprintf (stderr, "bad sample size %lld in %s\n", (long long) st.st_size, filename);
+    exit (1);
+  }
+  data_len = st.st_size;
+  data = malloc (data_len);
+  assert (data);
+  if (read (fd, data, data_len) != data_len) {
+    fprintf (stderr, "error reading %s: %m\n", filename);
+    exit (1);
+  }
+  close (fd);
+}
+
+static double get_time (void) {
+  struct timespec T;
+  assert (clock_gettime (CLOCK_MONOTONIC, &T) >= 0);
+  return T.tv_sec + (double) T.tv_nsec * 1e-9;
+}
+
+static void run_level (int level) {
+  int i, real_level = mc_scan_init (level);
+  if (real_level != level) {
+    printf ("%-8s not supported by this cpu\n", level == 2 ? "avx2" : "sse2");
+    return;
+  }
+  init_bench_connection (&BC);
+  replay (&BC, data, data_len);
+  queries = keys = key_bytes = 0;
+  double t = get_time ();
+  for (i = 0; i < rounds; i++) {
+    init_bench_connection (&BC);
+    replay (&BC, data, data_len);
+    assert (!BC.error);
+  }
+  t = get_time () - t;
+  printf ("%-8s %10.1f MB/s %12.0f queries/s  (%lld queries, %lld get keys of %lld bytes, %.3f s)\n", level == 2 ? "avx2" : level == 1 ? "sse2" : "scalar",
+          (double) data_len * rounds / t / (1 << 20), queries / t, queries, keys, key_bytes, t);
+}
+
+void usage (void) {
+  printf ("usage: mc-parse-bench [-v] [-r<rounds>] [-c<chunk-size>] [-l<level>] [-n<sample-size>] [-k<keys-per-get>] [-K<key-len>] [<capture-file>]\n"
+    "\tReplays memcache text protocol requests through the memcache server parser and reports its throughput.\n"
+    "\t<capture-file>\tclient-to-server byte stream of a memcache connection (e.g. extracted with tcpflow)\n"
+    "\t[-r<rounds>]\tnumber of passes over the sample (default %d)\n"
+    "\t[-c<chunk-size>]\tbytes appended to the input buffer at once, like one recv() (default %d)\n"
+    "\t[-l<level>]\ttest only one delimiter scanner: 0 = scalar, 1 = sse2, 2 = avx2\n"
+    "\t[-n<sample-size>]\tsize in bytes of generated sample if no capture file is given (default 64Mi)\n"
+    "\t[-k<keys-per-get>]\tkeys in generated get queries (default %d)\n"
+    "\t[-K<key-len>]\tlength of generated keys (default %d)\n",
+    rounds, chunk_size, keys_per_get, key_len);
+  exit (2);
+}
+
+int main (int argc, char *argv[]) {
+  int i, level = -1;
+  long long sample_size = 64 << 20;
+  while ((i = getopt (argc, argv, "c:hk:K:l:n:r:v")) != -1) {
+    switch (i) {
+    case 'c':
+      chunk_size = atoi (optarg);
+      if (chunk_size < 1 || chunk_size > (1 << 20)) {
+        usage ();
+      }
+      break;
+    case 'k':
+      keys_per_get = atoi (optarg);
+      if (keys_per_get < 1 || keys_per_get > 1000) {
+        usage ();
+      }
+      break;
+    case 'K':
+      key_len = atoi (optarg);
+      if (key_len < 5 || key_len > 250) {
+        usage ();
+      }
+      break;
+    case 'l':
+      level = atoi (optarg);
+      if (level < 0 || level > 2) {
+        usage ();
+      }
+      break;
+    case 'n':
+      sample_size = atoll (optarg);
+      if (sample_size < 1024 || sample_size > MAX_SAMPLE_SIZE) {
+        usage ();
+      }
+      break;
+    case 'r':
+      rounds = atoi (optarg);
+      if (rounds < 1) {
+        usage ();
+      }
+      break;
+    case 'v':
+      verbosity++;
+      break;
+    default:
+      usage ();
+    }
+  }
+  if (argc > optind + 1) {
+    usage ();
+  }
+
+  init_netbuffers ();
+
+  if (argc == optind + 1) {
+    load_sample (argv[optind]);
+  } else {
+    generate_sample (sample_size);
+  }
+  printf ("sample: %d bytes, %d rounds, chunk %d bytes\n", data_len, rounds, chunk_size);
+
+  if (level >= 0) {
+    run_level (level);
+  } else {
+    for (i = 0; i <= 2; i++) {
+      run_level (i);
+    }
+  }
+  return 0;
+}
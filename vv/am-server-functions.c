@@ -40,8 +40,10 @@
 #include "vv-tl-parse.h"
 
 static volatile int sighup_cnt = 0, sigusr1_cnt = 0, sigrtmax_cnt = 0;
-static int child_pid = 0, last_cron_time = 0;
+static int child_pid = 0, delta_index_writing = 0, last_cron_time = 0, next_delta_index_time = 0;
+static long long last_delta_index_pos = -1;
 int udp_enabled;
+int delta_index_interval;
 
 
 static void reopen_logs (void) {
@@ -85,7 +87,9 @@ static server_functions_t sf = {
   .sighup = default_sighup,
   .sigusr1 = default_sigusr1,
   .cron = default_cron,
-  .save_index = NULL
+  .save_index = NULL,
+  .save_delta_index = NULL,
+  .index_forked = NULL
 };
 
 
@@ -116,6 +120,12 @@ static void fork_write_index (void) {
     vkprintf (1, "%s: save_index isn't defined.\n", __func__);
     return;  
   }
+  if (delta_index_writing) {
+    /* new deltas are based on full index, so it is forked after delta index is written */
+    vkprintf (1, "%s: delta index is being written, postponing\n", __func__);
+    __sync_fetch_and_add (&sigrtmax_cnt, 1);
+    return;
+  }
   if (child_pid) {
     vkprintf (1, "%s: process with pid %d already generates index, skipping\n", __func__, child_pid);
     return;
@@ -131,9 +141,31 @@ static void fork_write_index (void) {
   } else {
     vkprintf (1, "created child process pid = %d\n", res);
     child_pid = res;
+    if (sf.index_forked) {
+      sf.index_forked ();
+    }
   }
 }
 
+/* delta index is written by chunks, one chunk per event loop iteration */
+static void write_delta_index_chunk (void) {
+  delta_index_writing = sf.save_delta_index (!binlog_disabled);
+}
+
+static void write_delta_index (void) {
+  if (sf.save_delta_index == NULL || delta_index_writing || child_pid) {
+    /* delta is based on full index, which is being written by child */
+    return;
+  }
+  next_delta_index_time = now + delta_index_interval;
+  if (log_cur_pos () == last_delta_index_pos) {
+    return;
+  }
+  flush_binlog_ts ();
+  last_delta_index_pos = log_cur_pos ();
+  write_delta_index_chunk ();
+}
+
 
 static void sigint_immediate_handler (const int sig) {
   static const char message[] = "SIGINT handled immediately.\n";
@@ -196,7 +228,12 @@ int process_signals (void) {
     if (__sync_fetch_and_and (&sigrtmax_cnt, 0)) {
       fork_write_index ();
     }
+    if (delta_index_interval > 0 && now >= next_delta_index_time) {
+      write_delta_index ();
+    }
     sf.cron ();
+  } else if (delta_index_writing) {
+    write_delta_index_chunk ();
   }
   if (epoll_pre_event) {
     epoll_pre_event ();
@@ -266,7 +303,14 @@ void server_init (engine_t *E, server_functions_t *F, conn_type_t *listen_connec
     if (F->cron) {
       sf.cron = F->cron;
     }
+    if (F->save_delta_index) {
+      sf.save_delta_index = F->save_delta_index;
+    }
+    if (F->index_forked) {
+      sf.index_forked = F->index_forked;
+    }
   }
+  next_delta_index_time = now + delta_index_interval;
   
   init_epoll ();
   init_netbuffers ();
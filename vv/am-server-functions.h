@@ -28,6 +28,11 @@ typedef struct {
   void (*sigusr1) (void);
   int  (*save_index) (int);
   void (*sighup) (void);
+  /* writes snapshot of objects changed since last full index in the engine process (without fork),
+     called on every event loop iteration while it returns 1, one call writes one chunk */
+  int  (*save_delta_index) (int);
+  /* called in the parent after fork for full index, new deltas should be based on it */
+  void (*index_forked) (void);
 } server_functions_t;
 
 typedef struct {
@@ -39,3 +44,5 @@ void engine_init (engine_t *E, const char *const pwd_filename, int index_mode);
 void server_init (engine_t *E, server_functions_t *F, conn_type_t *listen_connection_type, void *listen_connection_extra);
 void server_exit (engine_t *E);
 int process_signals (void);
+
+extern int delta_index_interval;
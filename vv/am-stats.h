@@ -23,6 +23,7 @@
 
 #include <unistd.h>
 #include "net-connections.h"
+#include "kfs.h"
 
 #define AM_GET_MEMORY_USAGE_SELF 1
 #define AM_GET_MEMORY_USAGE_OVERALL 2
@@ -44,7 +45,16 @@
   "binlog_read_timestamp\t%d\n" \
   "binlog_last_timestamp\t%d\n" \
   "max_binlog_size\t%lld\n" \
-  "binlog_write_disabled\t%d\n", \
+  "binlog_write_disabled\t%d\n" \
+  "binlog_prefetch\t%d\n" \
+  "binlog_prefetch_bytes\t%lld\n" \
+  "binlog_prefetch_reads\t%lld\n" \
+  "binlog_prefetch_crc32_hits\t%lld\n" \
+  "kfs_read_bytes_normal\t%lld\n" \
+  "kfs_read_bytes_sequential\t%lld\n" \
+  "kfs_read_bytes_random\t%lld\n" \
+  "kfs_dropped_bytes\t%lld\n" \
+  "kfs_prefetched_bytes\t%lld\n", \
   log_readto_pos, \
   log_readto_pos - jump_log_pos, \
   binlog_load_time, \
@@ -55,13 +65,23 @@
   log_read_until, \
   log_last_ts, \
   max_binlog_size, \
-	binlog_disabled) \
+	binlog_disabled, \
+  binlog_prefetch, \
+  binlog_prefetch_bytes, \
+  binlog_prefetch_reads, \
+  binlog_prefetch_crc32_hits, \
+  kfs_read_bytes[KFS_ACCESS_NORMAL], \
+  kfs_read_bytes[KFS_ACCESS_SEQUENTIAL], \
+  kfs_read_bytes[KFS_ACCESS_RANDOM], \
+  kfs_dropped_bytes, \
+  kfs_prefetched_bytes) \
 
 #define SB_INDEX sb_printf (&sb, \
   "index_path\t%s\n" \
   "index_size\t%lld\n" \
-  "index_load_time\t%.6fs\n", \
-  engine_snapshot_name, engine_snapshot_size, index_load_time)
+  "index_load_time\t%.6fs\n" \
+  "index_mapped_bytes\t%lld\n", \
+  engine_snapshot_name, engine_snapshot_size, index_load_time, kfs_mapped_bytes)
 
 static inline double safe_div (double x, double y) { return y > 0 ? x/y : 0; }
 
@@ -1724,6 +1724,13 @@ int tl_store_end_ext (int op) {
   }
 
   TL_OUT_METHODS->store_flush ();
+  if (!TL_ERROR && (op == RPC_INVOKE_REQ || op == RPC_INVOKE_KPHP_REQ)) {
+    if (TL_OUT_TYPE == tl_type_conn) {
+      rpc_conn_query_sent (TL_OUT_CONN, TL_OUT_QID);
+    } else if (TL_OUT_TYPE == tl_type_tcp_raw_msg && TL_OUT_EXTRA) {
+      rpc_conn_query_sent (TL_OUT_EXTRA, TL_OUT_QID);
+    }
+  }
   vkprintf (2, "tl_store_end: written %d bytes, qid = %lld, PID = " PID_PRINT_STR "\n", TL_OUT_POS, TL_OUT_QID, PID_TO_PRINT (TL_OUT_PID));
   TL_OUT = 0;
   TL_OUT_TYPE = tl_type_none;
@@ -186,6 +186,8 @@ typedef struct {
 static weights_cyclic_buffer_en_t CB[WEIGHTS_CYCLIC_BUFFER_SIZE];
 static weights_cyclic_buffer_en_t CC[WEIGHTS_CB_CACHE_SIZE];
 static unsigned int c_wptr = 0;
+static long long cb_added, delta_cb_base; /* number of entries added to the cyclic buffer since start and till last full index */
+static void delta_index_cb_overwrite (void);
 
 static int cyclic_buffer_cache_store (int vector_id, int coord_id, int timestamp) {
   unsigned int h = (vector_id * 63617 + coord_id) * 63617 + timestamp;
@@ -204,6 +206,8 @@ static void cyclic_buffer_add (int vector_id, int coord_id, int timestamp) {
   if (!cyclic_buffer_cache_store (vector_id, coord_id, timestamp)) {
     return;
   }
+  cb_added++;
+  delta_index_cb_overwrite ();
   if (CB[c_wptr].refcnt) {
     weights_subscription_t *S;
     for (S = subscriptions.next; S != &subscriptions; S = S->next) {
@@ -534,6 +538,9 @@ static void add_use_back (weights_vector_t *V) {
 }
 
 /******************** vector hash table ********************/
+/* vectors changed since last full index, V->delta_idx - 1 is position of V in this array */
+static weights_vector_t **Dirty;
+static int dirty_vectors, dirty_size;
 int vector_hash_prime;
 static weights_vector_t **H;
 int tot_vectors, tot_counters_arrays;
@@ -579,6 +586,21 @@ weights_vector_t *get_vector_f (int vector_id, int force) {
   return NULL;
 }
 
+static void mark_dirty (weights_vector_t *V) {
+  if (V->delta_idx) {
+    return;
+  }
+  if (dirty_vectors == dirty_size) {
+    dirty_size = dirty_size ? 2 * dirty_size : 65536;
+    Dirty = realloc (Dirty, sizeof (Dirty[0]) * dirty_size);
+    assert (Dirty);
+  }
+  Dirty[dirty_vectors++] = V;
+  V->delta_idx = dirty_vectors;
+}
+
+static void delta_index_vector_change (weights_vector_t *V);
+
 static void weights_vector_relax (weights_vector_t *V) {
   const int dt = log_last_ts - V->relaxation_time;
   if (dt < 0) {
@@ -629,6 +651,8 @@ int weights_incr (struct lev_weights_incr *E) {
   vkprintf (3, "%s: vector_id: %d, coord_id: %d, value: %d\n", __func__, E->vector_id, coord_id, E->value);
   cyclic_buffer_add (E->vector_id, coord_id, log_last_ts);
   weights_vector_t *V = get_vector_f (E->vector_id, 1);
+  delta_index_vector_change (V);
+  mark_dirty (V);
   const int k = coord_id >> 5;
   int i, mask = V->counters_mask;
   weights_counters_t *C = &V->head, *prev = NULL;
@@ -800,6 +824,9 @@ void weights_subscriptions_work (void) {
 /******************** snapshot  ********************/
 //#define WEIGHTS_INDEX_MAGIC_V1 0x64e14913
 #define WEIGHTS_INDEX_MAGIC_V2 0x64e14914
+/* delta snapshot: only vectors changed since snapshot at base_log_pos and recent part of cyclic buffer */
+#define WEIGHTS_DELTA_INDEX_MAGIC 0x64e1d314
+#define WEIGHTS_MAX_DELTA_CHAIN 16
 #pragma	pack(push,4)
 typedef struct {
 /* strange numbers */
@@ -817,20 +844,30 @@ typedef struct {
   int c_wptr, cb_entries;
   int tot_vectors;
   unsigned int body_crc32c[8];
+  long long base_log_pos;
 } weights_index_header_t;
 #pragma	pack(pop)
 
 long long jump_log_pos;
 int jump_log_ts;
 unsigned jump_log_crc32;
+long long delta_base_log_pos, delta_index_log_pos;
+int delta_index_vectors;
+static long long last_index_log_pos;
 //static int newidx_fd, idx_fd, index_exists;
 static kfs_snapshot_write_stream_t SWS;
 
 #define	BUFFSIZE 0x1000000
 
-static char *Buff = NULL, *rptr = NULL, *wptr = NULL;
+static char *Buff = NULL, *rptr = NULL, *wptr = NULL, *cptr = NULL;
 static unsigned int idx_crc32c_complement;
 
+/* consumed input [cptr, rptr) is checksummed by whole buffers, which allows to check it in several threads */
+static void relax_crc32c (void) {
+  idx_crc32c_complement = crc32c_partial_parallel (cptr, rptr - cptr, idx_crc32c_complement);
+  cptr = rptr;
+}
+
 static void flushout (void) {
   int s;
   if (rptr < wptr) {
@@ -845,14 +882,14 @@ static void clearin (void) {
     Buff = malloc (BUFFSIZE);
     assert (Buff);
   }
-  rptr = wptr = Buff + BUFFSIZE;
+  rptr = wptr = cptr = Buff + BUFFSIZE;
   idx_crc32c_complement = -1;
 }
 
 static void freein (void) {
   if (Buff) {
     free (Buff);
-    Buff = rptr = wptr = NULL;
+    Buff = rptr = wptr = cptr = NULL;
   }
 }
 
@@ -884,9 +921,10 @@ static void *readin (size_t len) {
   if (wptr < Buff + BUFFSIZE) {
     return 0;
   }
+  relax_crc32c ();
   memcpy (Buff, rptr, wptr - rptr);
   wptr -= rptr - Buff;
-  rptr = Buff;
+  rptr = cptr = Buff;
   wptr += kfs_read_file (Snapshot, wptr, Buff + BUFFSIZE - wptr);
   if (rptr + len <= wptr) {
     return rptr;
@@ -897,7 +935,6 @@ static void *readin (size_t len) {
 
 static void readadv (size_t len) {
   assert (len >= 0 && len <= wptr - rptr);
-  idx_crc32c_complement = crc32c_partial (rptr, len, idx_crc32c_complement);
   rptr += len;
 }
 
@@ -908,20 +945,41 @@ void bread (void *b, size_t len) {
   readadv (len);
 }
 
-int save_index (int writing_binlog) {
-  int header_buff[1024];
-  assert (sizeof (weights_index_header_t) <= sizeof (header_buff) - 4);
-  weights_index_header_t *header = (weights_index_header_t *) header_buff;
-  memset (header, 0, sizeof (header_buff));
-  int i;
+/* counters arrays with zero values (except the first one) aren't stored */
+#define WEIGHTS_MAX_VECTOR_BYTES (12 + 8 * (sizeof (((weights_counters_t *) 0)->values) + sizeof (((weights_counters_t *) 0)->t)))
 
-  if (!kfs_sws_open (&SWS, engine_snapshot_replica, log_cur_pos (), jump_log_pos)) {
-    return 0;
+static int serialize_vector (weights_vector_t *V, char *out) {
+  int i, k = 0, mask = V->counters_mask, m = 0;
+  weights_counters_t *D[16], *C = &V->head;
+  while (mask) {
+    i = ffs (mask) - 1;
+    mask ^= 1 << i;
+    assert (C);
+    if (!k || !weights_counters_is_zero (C)) {
+      m |= 1 << i;
+      D[k++] = C;
+    }
+    C = C->next;
   }
+  int *p = (int *) out;
+  p[0] = V->vector_id;
+  p[1] = V->relaxation_time;
+  p[2] = m;
+  char *q = out + 12;
+  for (i = 0; i < k; i++) {
+    memcpy (q, D[i]->values, sizeof (D[i]->values));
+    q += sizeof (D[i]->values);
+    memcpy (q, D[i]->t, sizeof (D[i]->t));
+    q += sizeof (D[i]->t);
+  }
+  assert (q - out <= WEIGHTS_MAX_VECTOR_BYTES);
+  return q - out;
+}
 
+static void init_index_header (weights_index_header_t *header, long long log_pos, int writing_binlog) {
   header->magic = 0;
   header->created_at = time (NULL);
-  header->log_pos1 = log_cur_pos ();
+  header->log_pos1 = log_pos;
   header->log_timestamp = log_last_ts;
   if (writing_binlog) {
     relax_write_log_crc32 ();
@@ -933,6 +991,22 @@ int save_index (int writing_binlog) {
   header->log_split_min = log_split_min;
   header->log_split_max = log_split_max;
   header->log_split_mod = log_split_mod;
+}
+
+int save_index (int writing_binlog) {
+  int header_buff[1024];
+  assert (sizeof (weights_index_header_t) <= sizeof (header_buff) - 4);
+  weights_index_header_t *header = (weights_index_header_t *) header_buff;
+  memset (header, 0, sizeof (header_buff));
+  int i;
+
+  const long long log_pos = log_cur_pos ();
+  /* snapshots written by this process earlier must be taken into account while choosing new snapshot name */
+  update_replica (engine_snapshot_replica, 0);
+  if (!kfs_sws_open (&SWS, engine_snapshot_replica, log_pos, last_index_log_pos > jump_log_pos ? last_index_log_pos : jump_log_pos)) {
+    return 0;
+  }
+  init_index_header (header, log_pos, writing_binlog);
 
   assert (lseek (SWS.newidx_fd, sizeof (header_buff), SEEK_SET) == sizeof (header_buff));
   /* half life array */
@@ -949,43 +1023,25 @@ int save_index (int writing_binlog) {
   header->c_wptr = c_wptr;
   header->cb_entries = CB[c_wptr].vector_id ? WEIGHTS_CYCLIC_BUFFER_SIZE : c_wptr;
   for (i = 0; i < header->cb_entries; i++) {
-    writeout (&CB[i].vector_id, 4);
-    writeout (&CB[i].coord_id, 4);
-    writeout (&CB[i].timestamp, 4);
+    weights_cyclic_buffer_en_t *E = &CB[i];
+    writeout (&E->vector_id, 4);
+    writeout (&E->coord_id, 4);
+    writeout (&E->timestamp, 4);
   }
   flushout ();
   header->body_crc32c[1] = ~idx_crc32c_complement;
   /* vectors data */
   clearin ();
-  header->tot_vectors = tot_vectors;
   int t = 0;
   weights_vector_t *V;
+  char b[WEIGHTS_MAX_VECTOR_BYTES];
   for (V = vectors.next; V != &vectors; V = V->next) {
     assert (V->vector_id);
-    writeout (&V->vector_id, 4);
-    writeout (&V->relaxation_time, 4);
-    int mask = V->counters_mask, m = 0;
-    weights_counters_t *D[16], *C = &V->head;
-    int k = 0;
-    while (mask) {
-      i = ffs (mask) - 1;
-      mask ^= 1 << i;
-      assert (C);
-      if (!k || !weights_counters_is_zero (C)) {
-        m |= 1 << i;
-        D[k++] = C;
-      }
-      C = C->next;
-    }
-    writeout (&m, 4);
-    for (i = 0; i < k; i++) {
-      C = D[i];
-      writeout (C->values, sizeof (C->values));
-      writeout (C->t, sizeof (C->t));
-    }
+    writeout (b, serialize_vector (V, b));
     t++;
   }
   assert (t == tot_vectors);
+  header->tot_vectors = t;
   flushout ();
   header->body_crc32c[2] = ~idx_crc32c_complement;
 
@@ -995,32 +1051,262 @@ int save_index (int writing_binlog) {
   assert (lseek (SWS.newidx_fd, 0, SEEK_SET) == 0);
   kfs_sws_write (&SWS, header_buff, sizeof (header_buff));
   kfs_sws_close (&SWS);
+  last_index_log_pos = log_pos;
   return 0;
 }
 
-int load_index (void) {
-  int i;
+/*
+ *  DELTA SNAPSHOT
+ *
+ *  Delta snapshot is written in the engine process in chunks from the event loop.
+ *  Offsets of all its sections are known at start, so the cyclic buffer and vectors sections
+ *  are written through separate buffers. Vector which isn't written yet is written before its change,
+ *  cyclic buffer entry which isn't written yet is written before it's overwritten,
+ *  so delta snapshot contains state at its log position.
+ */
+
+#define DELTA_STREAM_BUFFSIZE 0x100000
+/* bytes written by one save_delta_index () call */
+#define DELTA_CHUNK_SIZE 0x100000
+
+typedef struct {
+  long long off;
+  unsigned int crc32c_complement;
+  int len;
+  char buf[DELTA_STREAM_BUFFSIZE];
+} delta_stream_t;
+
+static struct {
+  int writing;
+  double start_time;
   int header_buff[1024];
-  assert (sizeof (weights_index_header_t) <= sizeof (header_buff) - 4);
-  weights_index_header_t *header = (weights_index_header_t *) header_buff;
-  if (Snapshot == NULL) {
-    jump_log_ts = 0;
-    jump_log_pos = 0;
-    jump_log_crc32 = 0;
+  unsigned int cb_first; /* entries [cb_written, header->cb_entries) after cb_first aren't written */
+  int cb_written;
+  int vectors_written; /* Dirty[vectors_written .. header->tot_vectors) aren't written */
+  delta_stream_t *cb, *vectors;
+} DW;
+
+static void delta_stream_init (delta_stream_t *S, long long off) {
+  S->off = off;
+  S->crc32c_complement = -1;
+  S->len = 0;
+}
+
+static void delta_stream_flush (delta_stream_t *S) {
+  if (S->len) {
+    assert (lseek (SWS.newidx_fd, S->off, SEEK_SET) == S->off);
+    kfs_sws_write (&SWS, S->buf, S->len);
+    S->off += S->len;
+    S->len = 0;
+  }
+}
+
+static int delta_stream_write (delta_stream_t *S, const void *D, int len) {
+  assert (len <= DELTA_STREAM_BUFFSIZE);
+  S->crc32c_complement = crc32c_partial (D, len, S->crc32c_complement);
+  if (S->len + len > DELTA_STREAM_BUFFSIZE) {
+    delta_stream_flush (S);
+  }
+  memcpy (S->buf + S->len, D, len);
+  S->len += len;
+  return len;
+}
+
+static void delta_write_cb_entries (int n) {
+  while (n-- > 0) {
+    weights_cyclic_buffer_en_t *E = &CB[(DW.cb_first + DW.cb_written++) % WEIGHTS_CYCLIC_BUFFER_SIZE];
+    int p[3] = { E->vector_id, E->coord_id, E->timestamp };
+    delta_stream_write (DW.cb, p, 12);
+  }
+}
+
+static int delta_write_vector (weights_vector_t *V) {
+  char b[WEIGHTS_MAX_VECTOR_BYTES];
+  return delta_stream_write (DW.vectors, b, serialize_vector (V, b));
+}
+
+static void delta_index_cb_overwrite (void) {
+  if (!DW.writing) {
+    return;
+  }
+  weights_index_header_t *header = (weights_index_header_t *) DW.header_buff;
+  const int d = (c_wptr + WEIGHTS_CYCLIC_BUFFER_SIZE - DW.cb_first) % WEIGHTS_CYCLIC_BUFFER_SIZE;
+  if (d >= DW.cb_written && d < header->cb_entries) {
+    delta_write_cb_entries (d + 1 - DW.cb_written);
+  }
+}
+
+static void delta_index_vector_change (weights_vector_t *V) {
+  if (!DW.writing) {
+    return;
+  }
+  weights_index_header_t *header = (weights_index_header_t *) DW.header_buff;
+  const int i = V->delta_idx - 1;
+  if (i >= DW.vectors_written && i < header->tot_vectors) {
+    /* move V into written part of Dirty */
+    weights_vector_t *W = Dirty[DW.vectors_written];
+    Dirty[i] = W;
+    W->delta_idx = i + 1;
+    Dirty[DW.vectors_written++] = V;
+    V->delta_idx = DW.vectors_written;
+    delta_write_vector (V);
+  }
+}
+
+static int delta_index_start (int writing_binlog) {
+  weights_index_header_t *header = (weights_index_header_t *) DW.header_buff;
+  assert (sizeof (weights_index_header_t) <= sizeof (DW.header_buff) - 4);
+  memset (DW.header_buff, 0, sizeof (DW.header_buff));
+  int i;
+
+  const long long log_pos = log_cur_pos ();
+  if (log_pos == last_index_log_pos) {
+    return 0;
+  }
+  update_replica (engine_snapshot_replica, 0);
+  if (!kfs_sws_open (&SWS, engine_snapshot_replica, log_pos, last_index_log_pos > jump_log_pos ? last_index_log_pos : jump_log_pos)) {
+    return 0;
+  }
+  init_index_header (header, log_pos, writing_binlog);
+  header->base_log_pos = delta_base_log_pos;
+  /* cyclic buffer entries added since base snapshot in chronological order */
+  header->c_wptr = c_wptr;
+  header->cb_entries = CB[c_wptr].vector_id ? WEIGHTS_CYCLIC_BUFFER_SIZE : c_wptr;
+  if (header->cb_entries > cb_added - delta_cb_base) {
+    header->cb_entries = cb_added - delta_cb_base;
+  }
+  header->tot_vectors = dirty_vectors;
+  DW.cb_first = (c_wptr + WEIGHTS_CYCLIC_BUFFER_SIZE - header->cb_entries) % WEIGHTS_CYCLIC_BUFFER_SIZE;
+  DW.cb_written = 0;
+  DW.vectors_written = 0;
+  DW.cb = malloc (sizeof (delta_stream_t));
+  DW.vectors = malloc (sizeof (delta_stream_t));
+  assert (DW.cb && DW.vectors);
+
+  /* half life array is written through cyclic buffer section stream, it precedes that section */
+  delta_stream_init (DW.cb, sizeof (DW.header_buff));
+  for (i = 0; i < WEIGHTS_MAX_COORDS; i++) {
+    assert (TAT[i]);
+    delta_stream_write (DW.cb, &TAT[i]->T, 4);
+  }
+  header->body_crc32c[0] = ~DW.cb->crc32c_complement;
+  DW.cb->crc32c_complement = -1;
+  delta_stream_init (DW.vectors, sizeof (DW.header_buff) + 4 * WEIGHTS_MAX_COORDS + 12LL * header->cb_entries);
+  DW.writing = 1;
+  DW.start_time = get_utime_monotonic ();
+  vkprintf (1, "%s: writing delta snapshot %s (%d vectors, %d cyclic buffer entries)\n", __func__, SWS.newidxname, header->tot_vectors, header->cb_entries);
+  return 1;
+}
+
+static void delta_index_finish (void) {
+  weights_index_header_t *header = (weights_index_header_t *) DW.header_buff;
+  header->body_crc32c[1] = ~DW.cb->crc32c_complement;
+  header->body_crc32c[2] = ~DW.vectors->crc32c_complement;
+  header->magic = WEIGHTS_DELTA_INDEX_MAGIC;
+  const long long log_pos = header->log_pos1;
+  const int t = header->tot_vectors;
+  DW.header_buff[1023] = compute_crc32c (DW.header_buff, 1023 * 4);
+  assert (lseek (SWS.newidx_fd, 0, SEEK_SET) == 0);
+  kfs_sws_write (&SWS, DW.header_buff, sizeof (DW.header_buff));
+  kfs_sws_close (&SWS);
+  free (DW.cb);
+  free (DW.vectors);
+  DW.cb = DW.vectors = NULL;
+  DW.writing = 0;
+  last_index_log_pos = delta_index_log_pos = log_pos;
+  delta_index_vectors = t;
+  vkprintf (1, "%s: delta snapshot at log position %lld written in %.6lf seconds\n", __func__, log_pos, get_utime_monotonic () - DW.start_time);
+}
+
+/* starts delta snapshot of vectors changed since last full snapshot if it isn't being written,
+   writes its next chunk, returns 1 if delta snapshot isn't finished */
+int save_delta_index (int writing_binlog) {
+  if (!DW.writing && !delta_index_start (writing_binlog)) {
     return 0;
   }
+  weights_index_header_t *header = (weights_index_header_t *) DW.header_buff;
+  long long budget = DELTA_CHUNK_SIZE;
+  if (DW.cb_written < header->cb_entries) {
+    int n = header->cb_entries - DW.cb_written;
+    if (n > budget / 12) {
+      n = budget / 12;
+    }
+    delta_write_cb_entries (n);
+    budget -= 12LL * n;
+  }
+  while (budget > 0 && DW.vectors_written < header->tot_vectors) {
+    budget -= delta_write_vector (Dirty[DW.vectors_written++]);
+  }
+  delta_stream_flush (DW.cb);
+  delta_stream_flush (DW.vectors);
+  if (DW.cb_written < header->cb_entries || DW.vectors_written < header->tot_vectors) {
+    return 1;
+  }
+  delta_index_finish ();
+  return 0;
+}
 
-  kfs_read_file (Snapshot, header_buff, sizeof (header_buff));
+/* parent process after fork for save_index: following deltas are based on the snapshot being written by child */
+void weights_index_forked (void) {
+  assert (!DW.writing);
+  int i;
+  for (i = 0; i < dirty_vectors; i++) {
+    Dirty[i]->delta_idx = 0;
+  }
+  dirty_vectors = 0;
+  delta_base_log_pos = last_index_log_pos = log_cur_pos ();
+  delta_cb_base = cb_added;
+}
+
+static int read_index_header (kfs_file_handle_t F, int header_buff[1024]) {
+  weights_index_header_t *header = (weights_index_header_t *) header_buff;
+  if (kfs_read_file (F, header_buff, 4096) != 4096) {
+    kprintf ("[%s] index file is too short\n", F->info->filename);
+    return -1;
+  }
 
-  if (header->magic != WEIGHTS_INDEX_MAGIC_V2) {
-    kprintf ("[%s] index file is not for weights-engine\n", Snapshot->info->filename);
+  if (header->magic != WEIGHTS_INDEX_MAGIC_V2 && header->magic != WEIGHTS_DELTA_INDEX_MAGIC) {
+    kprintf ("[%s] index file is not for weights-engine\n", F->info->filename);
     return -1;
   }
 
   if (header_buff[1023] != (int) compute_crc32c (header_buff, 1023 * 4)) {
-    kprintf ("[%s] index header is broken (crc32c isn't matched)\n", Snapshot->info->filename);
+    kprintf ("[%s] index header is broken (crc32c isn't matched)\n", F->info->filename);
     return -1;
   }
+  return 0;
+}
+
+/* finds among snapshots older than F the one written at base_log_pos */
+static kfs_file_handle_t open_base_index (kfs_file_handle_t F, long long base_log_pos) {
+  int header_buff[1024];
+  weights_index_header_t *header = (weights_index_header_t *) header_buff;
+  kfs_file_handle_t G = F, P;
+  while ((P = open_previous_snapshot (engine_snapshot_replica, G)) != NULL) {
+    if (G != F) {
+      close_snapshot (G, 1);
+    }
+    G = P;
+    if (read_index_header (G, header_buff) >= 0 && header->log_pos1 == base_log_pos) {
+      assert (lseek (G->fd, G->offset, SEEK_SET) == G->offset);
+      return G;
+    }
+  }
+  if (G != F) {
+    close_snapshot (G, 1);
+  }
+  return NULL;
+}
+
+static int cmp_relaxation_time (const void *a, const void *b) {
+  const weights_vector_t *x = *(weights_vector_t **) a, *y = *(weights_vector_t **) b;
+  return x->relaxation_time < y->relaxation_time ? -1 : x->relaxation_time > y->relaxation_time ? 1 : 0;
+}
+
+/* mark != 0: vectors and cyclic buffer entries of delta snapshot are considered changed since base snapshot */
+static int load_index_body (weights_index_header_t *header, int mark) {
+  int i;
+  const int delta = header->magic == WEIGHTS_DELTA_INDEX_MAGIC;
   clearin ();
   /* half life array */
   for (i = 0; i < WEIGHTS_MAX_COORDS; i++) {
@@ -1032,6 +1318,7 @@ int load_index (void) {
     weights_set_half_life (&E);
     readadv (4);
   }
+  relax_crc32c ();
   if (~idx_crc32c_complement != header->body_crc32c[0]) {
     kprintf ("[%s] half life section is corrupted (crc32c isn't matched)\n", Snapshot->info->filename);
     return -1;
@@ -1039,27 +1326,47 @@ int load_index (void) {
   /* cyclic buffer data */
   idx_crc32c_complement = -1;
   assert (header->cb_entries >= 0 && header->cb_entries <= WEIGHTS_CYCLIC_BUFFER_SIZE);
-  for (i = 0; i < header->cb_entries; i++) {
-    int *p = readin (12); assert (p);
-    CB[i].vector_id = p[0];
-    CB[i].coord_id = p[1];
-    CB[i].timestamp = p[2];
-    CB[i].refcnt = 0;
-    readadv (12);
-  }
-  c_wptr = header->c_wptr;
-  if (CB[c_wptr].vector_id) {
-    i = c_wptr;
-    do {
-      cyclic_buffer_cache_store (CB[i].vector_id, CB[i].coord_id, CB[i].timestamp);
-      i = (i + 1) % WEIGHTS_CYCLIC_BUFFER_SIZE;
-    } while (i != c_wptr);
+  assert (header->c_wptr >= 0 && header->c_wptr < WEIGHTS_CYCLIC_BUFFER_SIZE);
+  if (delta) {
+    const int j = header->c_wptr + WEIGHTS_CYCLIC_BUFFER_SIZE - header->cb_entries;
+    for (i = 0; i < header->cb_entries; i++) {
+      int *p = readin (12); assert (p);
+      weights_cyclic_buffer_en_t *E = &CB[(i + j) % WEIGHTS_CYCLIC_BUFFER_SIZE];
+      E->vector_id = p[0];
+      E->coord_id = p[1];
+      E->timestamp = p[2];
+      E->refcnt = 0;
+      cyclic_buffer_cache_store (p[0], p[1], p[2]);
+      readadv (12);
+    }
+    if (mark) {
+      cb_added += header->cb_entries;
+    }
+    c_wptr = header->c_wptr;
   } else {
-    for (i = 0; i < c_wptr; i++) {
-      cyclic_buffer_cache_store (CB[i].vector_id, CB[i].coord_id, CB[i].timestamp);
+    for (i = 0; i < header->cb_entries; i++) {
+      int *p = readin (12); assert (p);
+      CB[i].vector_id = p[0];
+      CB[i].coord_id = p[1];
+      CB[i].timestamp = p[2];
+      CB[i].refcnt = 0;
+      readadv (12);
+    }
+    c_wptr = header->c_wptr;
+    if (CB[c_wptr].vector_id) {
+      i = c_wptr;
+      do {
+        cyclic_buffer_cache_store (CB[i].vector_id, CB[i].coord_id, CB[i].timestamp);
+        i = (i + 1) % WEIGHTS_CYCLIC_BUFFER_SIZE;
+      } while (i != c_wptr);
+    } else {
+      for (i = 0; i < c_wptr; i++) {
+        cyclic_buffer_cache_store (CB[i].vector_id, CB[i].coord_id, CB[i].timestamp);
+      }
     }
   }
 
+  relax_crc32c ();
   if (~idx_crc32c_complement != header->body_crc32c[1]) {
     kprintf ("[%s] cyclic buffer section is corrupted (crc32c isn't matched)\n", Snapshot->info->filename);
     return -1;
@@ -1068,23 +1375,45 @@ int load_index (void) {
   /* vectors data */
   idx_crc32c_complement = -1;
 
-  if (header->tot_vectors > WEIGHTS_DEFAULT_HASH_SIZE) {
+  if (H == NULL && header->tot_vectors > WEIGHTS_DEFAULT_HASH_SIZE) {
     vector_hash_prime = header->tot_vectors;
   }
   init_weights_data (WEIGHTS_SCHEMA_V1);
 
-  assert (!tot_vectors);
+  assert (delta || !tot_vectors);
+  /* delta vectors aren't ordered by relaxation time, they are moved to the end of vectors list after loading */
+  weights_vector_t **L = NULL;
+  if (delta) {
+    L = malloc (sizeof (L[0]) * (header->tot_vectors + 1));
+    assert (L);
+  }
   for (i = 0; i < header->tot_vectors; i++) {
     int *p = readin (12); assert (p);
     //fprintf (stderr, "%s: %d %d %d\n", __func__, p[0], p[1], p[2]);
+    const int old_vectors = tot_vectors;
     weights_vector_t *V = get_vector_f (p[0], 1);
     assert (V);
-    del_use (V);
-    add_use_back (V);
-    if (tot_vectors != (i + 1)) {
+    if (delta) {
+      L[i] = V;
+      /* vector from delta replaces vector from base snapshot */
+      weights_counters_t *C = V->head.next, *D;
+      while (C) {
+        D = C->next;
+        zfree (C, sizeof (weights_counters_t));
+        tot_counters_arrays--;
+        C = D;
+      }
+      memset (&V->head, 0, sizeof (V->head));
+      if (mark) {
+        mark_dirty (V);
+      }
+    } else if (tot_vectors != old_vectors + 1) {
       kprintf ("%s: tot_vectors (%d) != %d, duplicate vector_id (%d) in snapshot '%s'?\n",
         __func__, tot_vectors, i + 1, p[0], Snapshot->info->filename);
       assert (0);
+    } else {
+      del_use (V);
+      add_use_back (V);
     }
     V->relaxation_time = p[1];
     int j, mask = p[2];
@@ -1114,11 +1443,56 @@ int load_index (void) {
       mask &= mask - 1;
     }
   }
+  if (delta) {
+    /* all of them were changed after base snapshot, so they follow unchanged vectors */
+    qsort (L, header->tot_vectors, sizeof (L[0]), cmp_relaxation_time);
+    for (i = 0; i < header->tot_vectors; i++) {
+      del_use (L[i]);
+      add_use_back (L[i]);
+    }
+    free (L);
+  }
 
+  relax_crc32c ();
   if (~idx_crc32c_complement != header->body_crc32c[2]) {
     kprintf ("[%s] vectors section is corrupted (crc32c isn't matched)\n", Snapshot->info->filename);
     return -1;
   }
+  freein ();
+  return 0;
+}
+
+/* returns -2 if delta snapshot was skipped since its base wasn't found (nothing was loaded) */
+static int load_index_file (kfs_file_handle_t F, int depth) {
+  int header_buff[1024];
+  assert (sizeof (weights_index_header_t) <= sizeof (header_buff) - 4);
+  weights_index_header_t *header = (weights_index_header_t *) header_buff;
+
+  if (read_index_header (F, header_buff) < 0) {
+    return -1;
+  }
+
+  if (header->magic == WEIGHTS_DELTA_INDEX_MAGIC && header->base_log_pos) {
+    kfs_file_handle_t B = depth < WEIGHTS_MAX_DELTA_CHAIN ? open_base_index (F, header->base_log_pos) : NULL;
+    if (B == NULL) {
+      kprintf ("[%s] base snapshot for log position %lld isn't found, skipping delta snapshot\n", F->info->filename, header->base_log_pos);
+      return -2;
+    }
+    vkprintf (1, "[%s] loading base snapshot %s\n", F->info->filename, B->info->filename);
+    int r = load_index_file (B, depth + 1);
+    close_snapshot (B, 1);
+    if (r < 0) {
+      return r;
+    }
+  }
+
+  kfs_file_handle_t S = Snapshot;
+  Snapshot = F;
+  int r = load_index_body (header, !depth);
+  Snapshot = S;
+  if (r < 0) {
+    return r;
+  }
 
   log_split_min = header->log_split_min;
   log_split_max = header->log_split_max;
@@ -1127,9 +1501,40 @@ int load_index (void) {
   jump_log_pos = header->log_pos1;
   jump_log_crc32 = header->log_pos1_crc32;
   jump_log_ts = header->log_timestamp;
+  if (!depth) {
+    delta_base_log_pos = header->magic == WEIGHTS_DELTA_INDEX_MAGIC ? header->base_log_pos : header->log_pos1;
+    last_index_log_pos = header->log_pos1;
+  }
+  return 0;
+}
+
+int load_index (void) {
+  if (Snapshot == NULL) {
+    jump_log_ts = 0;
+    jump_log_pos = 0;
+    jump_log_crc32 = 0;
+    return 0;
+  }
+
+  kfs_file_handle_t F = Snapshot;
+  int r;
+  while ((r = load_index_file (F, 0)) == -2) {
+    kfs_file_handle_t G = open_previous_snapshot (engine_snapshot_replica, F);
+    if (F != Snapshot) {
+      close_snapshot (F, 1);
+    }
+    F = G;
+    if (F == NULL) {
+      kprintf ("no loadable snapshot found\n");
+      return -1;
+    }
+    vkprintf (1, "load index file %s instead\n", F->info->filename);
+  }
+  if (F != Snapshot) {
+    close_snapshot (F, 1);
+  }
 
   vkprintf (4, "jump_log_pos: %lld\n", jump_log_pos);
   vkprintf (4, "jump_log_ts: %d\n", jump_log_ts);
-  freein ();
-  return 0;
+  return r;
 }
@@ -45,6 +45,7 @@ typedef struct weights_vector {
   int relaxation_time;
   short subscription_refcnt;
   unsigned short counters_mask;
+  int delta_idx; /* 1 + position in array of vectors changed since last full index, 0 if vector wasn't changed */
   weights_counters_t head;
 } weights_vector_t;
 
@@ -90,8 +91,13 @@ extern long long jump_log_pos;
 extern int jump_log_ts;
 extern unsigned jump_log_crc32;
 
+extern long long delta_base_log_pos, delta_index_log_pos;
+extern int delta_index_vectors;
+
 int load_index (void);
 int save_index (int writing_binlog);
+int save_delta_index (int writing_binlog);
+void weights_index_forked (void);
 
 typedef struct {
   int min;
@@ -169,6 +169,10 @@ int weights_prepare_stats (struct connection *c) {
   SB_PRINT_I32(tot_counters_arrays);
   SB_PRINT_I32(tot_subscriptions);
   SB_PRINT_I32(vector_hash_prime);
+  SB_PRINT_I32(delta_index_interval);
+  SB_PRINT_I64(delta_base_log_pos);
+  SB_PRINT_I64(delta_index_log_pos);
+  SB_PRINT_I32(delta_index_vectors);
 
   weights_half_life_stat_t half_life;
   weights_half_life_stats (&half_life);
@@ -366,7 +370,9 @@ void cron (void) {
 engine_t weights_engine;
 server_functions_t weights_functions = {
   .cron = cron,
-  .save_index = save_index
+  .save_index = save_index,
+  .save_delta_index = save_delta_index,
+  .index_forked = weights_index_forked
 };
 
 void start_server (void) {
@@ -424,6 +430,12 @@ int f_parse_option (int val) {
   case 'i':
     index_mode = 1;
     break;
+  case 'D':
+    delta_index_interval = atoi (optarg);
+    if (delta_index_interval < 0) {
+      delta_index_interval = 0;
+    }
+    break;
   default:
     fprintf (stderr, "Unimplemented option '%c' (%d)\n", (char) val, val);
     return -1;
@@ -437,6 +449,7 @@ int main (int argc, char *argv[]) {
   parse_option ("index", no_argument, 0, 'i', "reindex");
   remove_parse_option (201);
   parse_option ("udp", no_argument, 0, 'U', "enables udp message support");
+  parse_option ("delta-index", required_argument, 0, 'D', "<seconds> every <seconds> writes delta snapshot of vectors changed since last full snapshot without fork, 'weights-engine -i' folds deltas into full snapshot");
   parse_engine_options_long (argc, argv, f_parse_option);
 
   progname = argv[0];